@@ -25,4 +25,18 @@ benchmark::Event benchmark::EventFactory::CreateThread(const data::Thread& data,
         {"pid", std::to_string(processId)}, {"args", "{\"name\": \"" + data.name + "\"}"}, 
         {"tid", std::to_string(data.threadId)}
         });
+}
+
+benchmark::Event benchmark::EventFactory::CreateCounter(const data::Counter& data, unsigned int processId)
+{
+    std::string values;
+    for (const auto& [name, value] : data.values)
+    {
+        values += (values.empty() ? "" : ", ") + ("\"" + name + "\": " + std::to_string(value));
+    }
+
+    return Event({
+        { "name", "\"" + data.name + "\""}, {"ph", "\"C\""}, {"ts", std::to_string(data.timepoint)},
+        {"pid", std::to_string(processId)}, {"args", "{" + values + "}"}
+        });
 }
\ No newline at end of file
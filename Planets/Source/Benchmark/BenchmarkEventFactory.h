@@ -10,5 +10,6 @@ namespace benchmark
 		static Event CreateTiming(const data::Timing& data, unsigned int processId);
 		static Event CreateSession(const data::Session& data, unsigned int processId);
 		static Event CreateThread(const data::Thread& data, unsigned int processId);
+		static Event CreateCounter(const data::Counter& data, unsigned int processId);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "BenchmarkGpuProfiler.h"
+#include "BenchmarkManager.h"
+#include "../Rendering/GlMacro.h"
+#include <chrono>
+
+benchmark::GpuProfiler& benchmark::GpuProfiler::Get()
+{
+	// The queries are deleted along with the OpenGL context, so the
+	// profiler is free to outlive it, unlike most OpenGL objects
+	static GpuProfiler instance;
+	return instance;
+}
+
+GLuint benchmark::GpuProfiler::RecordTimestamp()
+{
+	const GLuint query = TakeQuery();
+	GL(glQueryCounter(query, GL_TIMESTAMP));
+	return query;
+}
+
+GLuint benchmark::GpuProfiler::TakeQuery()
+{
+	if (mFreeQueries.empty())
+	{
+		mFreeQueries.resize(QUERY_BATCH_SIZE);
+		GL(glCreateQueries(GL_TIMESTAMP, QUERY_BATCH_SIZE, mFreeQueries.data()));
+	}
+
+	const GLuint query = mFreeQueries.back();
+	mFreeQueries.pop_back();
+	return query;
+}
+
+void benchmark::GpuProfiler::AddTiming(const std::string& name, const GLuint startQuery, const GLuint endQuery)
+{
+	mPendingTimings.push_back(PendingTiming{ name, startQuery, endQuery });
+}
+
+void benchmark::GpuProfiler::Resolve()
+{
+	if (!mNamedTrack)
+	{
+		Manager::Get().NameThread(data::Thread{ "GPU", GPU_TRACK_ID });
+		mNamedTrack = true;
+	}
+
+	Calibrate();
+
+	while (!mPendingTimings.empty())
+	{
+		const PendingTiming& timing = mPendingTimings.front();
+
+		// The end of the timing is recorded after its start, so
+		// once the end is available, the start is available as well
+		GLint isAvailable = GL_FALSE;
+		GL(glGetQueryObjectiv(timing.endQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable));
+		if (!isAvailable)
+		{
+			break;
+		}
+
+		GLint64 start = 0;
+		GLint64 end = 0;
+		GL(glGetQueryObjecti64v(timing.startQuery, GL_QUERY_RESULT, &start));
+		GL(glGetQueryObjecti64v(timing.endQuery, GL_QUERY_RESULT, &end));
+
+		const long long startTimepoint = ConvertToCpuTime(start);
+		Manager::Get().Benchmark(
+			data::Timing{ timing.name, startTimepoint, ConvertToCpuTime(end) - startTimepoint, GPU_TRACK_ID });
+
+		mFreeQueries.push_back(timing.startQuery);
+		mFreeQueries.push_back(timing.endQuery);
+		mPendingTimings.pop_front();
+	}
+}
+
+long long benchmark::GpuProfiler::ConvertToCpuTime(const GLint64 gpuTimestamp) const
+{
+	return (gpuTimestamp + mClockOffset) / 1000;
+}
+
+void benchmark::GpuProfiler::Calibrate()
+{
+	// Querying the timestamp directly returns the time at which the GPU has received all the
+	// earlier commands, rather than finished them, hence it does not wait for the GPU. The clocks
+	// drift apart over time, so they are calibrated for every resolve.
+	GLint64 gpuTime = 0;
+	GL(glGetInteger64v(GL_TIMESTAMP, &gpuTime));
+	const long long cpuTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+
+	mClockOffset = cpuTime - gpuTime;
+}
\ No newline at end of file
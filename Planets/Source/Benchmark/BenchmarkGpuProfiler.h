@@ -0,0 +1,61 @@
+#pragma once
+#include "GL/glew.h"
+#include <deque>
+
+namespace benchmark
+{
+	// Singleton. Keeps track of the GPU timings that have been recorded, by "GpuTimer"
+	// scopes, and hands them over to the "Manager" once the GPU has caught up with them.
+	// The timings end up on a track of their own, named "GPU", in the same trace as the
+	// CPU timings. Should only be used by the thread that owns the OpenGL context.
+	class GpuProfiler
+	{
+	public:
+		static GpuProfiler& Get();
+
+		// Returns a query that records the time at which the GPU has
+		// finished all the commands that were issued before the call
+		GLuint RecordTimestamp();
+		// Returns a query that has not recorded anything yet, which lets the timestamp
+		// be recorded later on, without anything that could throw an exception
+		GLuint TakeQuery();
+		// Adds the timing "name", that starts at the timestamp of "startQuery" and
+		// ends at the timestamp of "endQuery", to the timings that await the GPU
+		void AddTiming(const std::string& name, GLuint startQuery, GLuint endQuery);
+
+		// Hands the timings whose timestamps are available over to the "Manager", without
+		// waiting for the GPU. The rest are left for later calls. Needs to be called once
+		// per frame, which normally resolves the timings of a couple of frames ago.
+		void Resolve();
+	private:
+		GpuProfiler() = default;
+
+		struct PendingTiming
+		{
+			std::string name;
+			GLuint startQuery = 0;
+			GLuint endQuery = 0;
+		};
+
+		// Converts a GPU timestamp, in nanoseconds, to the microseconds of the CPU timings
+		long long ConvertToCpuTime(GLint64 gpuTimestamp) const;
+		// Measures the difference between the clocks of the GPU and the CPU
+		void Calibrate();
+	private:
+		// The timings are resolved in the order that they were recorded, since
+		// the GPU finishes the commands in the order that they were issued
+		std::deque<PendingTiming> mPendingTimings;
+		// The queries that are not in use. The pool only grows when the
+		// GPU is further behind than the queries that have been created.
+		std::vector<GLuint> mFreeQueries;
+
+		// The CPU time, in nanoseconds, minus the GPU time, at the last calibration
+		long long mClockOffset = 0;
+		bool mNamedTrack = false;
+
+		// The id of the "GPU" track, which is the thread id that the GPU timings are
+		// given. Real thread ids are hashes, which are unlikely to ever collide with it.
+		static constexpr unsigned int GPU_TRACK_ID = 1;
+		static constexpr GLsizei QUERY_BATCH_SIZE = 32;
+	};
+}
\ No newline at end of file
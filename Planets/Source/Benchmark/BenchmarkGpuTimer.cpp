@@ -0,0 +1,16 @@
+#include "BenchmarkGpuTimer.h"
+
+benchmark::GpuTimer::GpuTimer(const std::string& name)
+	:
+	mName(name),
+	mStartQuery(GpuProfiler::Get().RecordTimestamp()),
+	mEndQuery(GpuProfiler::Get().TakeQuery())
+{
+}
+
+benchmark::GpuTimer::~GpuTimer()
+{
+	// Destructors should not throw exception, hence no GL macro
+	glQueryCounter(mEndQuery, GL_TIMESTAMP);
+	GpuProfiler::Get().AddTiming(mName, mStartQuery, mEndQuery);
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "BenchmarkGpuProfiler.h"
+
+namespace benchmark
+{
+	// Measures how long the GPU takes to execute the commands that are issued during the
+	// scope. Unlike the "Timer", which measures how long the CPU takes to issue them. The
+	// timing is recorded with timestamp queries, which lets the scopes nest, and gets handed
+	// over to the "Manager" a couple of frames later, by "GpuProfiler::Resolve".
+	class GpuTimer
+	{
+	public:
+		GpuTimer(const std::string& name);
+		~GpuTimer();
+		// One should not be able to copy nor move a "GpuTimer" instance
+		GpuTimer(const GpuTimer& other) = delete;
+		GpuTimer& operator=(const GpuTimer& other) = delete;
+	private:
+		std::string mName;
+		GLuint mStartQuery = 0;
+		// Taken up front, so that the destructor only needs to record the timestamp
+		GLuint mEndQuery = 0;
+	};
+}
\ No newline at end of file
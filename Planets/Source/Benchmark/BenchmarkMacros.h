@@ -1,5 +1,6 @@
 #pragma once
 #include "BenchmarkTimer.h"
+#include "BenchmarkGpuTimer.h"
 #include "BenchmarkSession.h"
 #include "BenchmarkManager.h"
 
@@ -15,6 +16,17 @@
 // Enables benchmarking for the scope
 #define BENCHMARK benchmark::Timer CONCATENATE(timer, __LINE__)(__FUNCSIG__)
 #define NAMED_BENCHMARK(name) benchmark::Timer CONCATENATE(timer, __LINE__)(name)
+// Enables benchmarking of the GPU work that gets issued inside the scope
+#define GPU_BENCHMARK(name) benchmark::GpuTimer CONCATENATE(gpuTimer, __LINE__)(name)
+
+// Hands the GPU timings that are done over to the benchmark file. Needs to be used once per frame.
+#define RESOLVE_GPU_BENCHMARKS benchmark::GpuProfiler::Get().Resolve()
+
+// Records the values of the counter "name", as pairs of a series name and a value, which
+// the trace draws as a graph over time, e.g., BENCHMARK_COUNTER("Draws", { "Opaque", 10 })
+#define BENCHMARK_COUNTER(name, ...) benchmark::Manager::Get().Benchmark(benchmark::data::Counter{ name, \
+std::chrono::duration_cast<std::chrono::microseconds>( \
+std::chrono::high_resolution_clock::now().time_since_epoch()).count(), { __VA_ARGS__ } })
 
 // Turns the current scope into a session
 #define CREATE_BENCHMARK_SESSION(name) benchmark::Session benchmarkSession(name)
@@ -33,6 +45,9 @@ benchmark::data::Thread{name, (unsigned int)std::hash<std::thread::id>()(std::th
 #else
 #define BENCHMARK
 #define NAMED_BENCHMARK
+#define GPU_BENCHMARK(name)
+#define RESOLVE_GPU_BENCHMARKS
+#define BENCHMARK_COUNTER(name, ...)
 #define CREATE_BENCHMARK_SESSION(name)
 #define NAME_THREAD(name)
 #define SAVE_BENCHMARK
@@ -57,6 +57,17 @@ void benchmark::Manager::Benchmark(const data::Timing& timingData)
 	);
 }
 
+void benchmark::Manager::Benchmark(const data::Counter& counterData)
+{
+	std::lock_guard lockGuard(mMutex);
+
+	assert(SessionIsActive());
+
+	ProcessEvent(
+		EventFactory::CreateCounter(counterData, mSessionData.activeId)
+	);
+}
+
 void benchmark::Manager::NameThread(const data::Thread& threadData)
 {
 	std::lock_guard lockGuard(mMutex);
@@ -26,6 +26,8 @@ namespace benchmark
 		// Thread-safe
 		void Benchmark(const data::Timing& timingData);
 		// Thread-safe
+		void Benchmark(const data::Counter& counterData);
+		// Thread-safe
 		void NameThread(const data::Thread& threadData);
 
 		void SaveBenchmark();
@@ -1,4 +1,5 @@
 #pragma once
 #include "TimingData.h"
 #include "SessionData.h"
-#include "ThreadData.h"
\ No newline at end of file
+#include "ThreadData.h"
+#include "CounterData.h"
\ No newline at end of file
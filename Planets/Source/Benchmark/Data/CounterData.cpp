@@ -0,0 +1,10 @@
+#include "CounterData.h"
+
+benchmark::data::Counter::Counter(const std::string& name, long long timepoint,
+								  std::vector<std::pair<std::string, long long>> values)
+	:
+	name(name),
+	timepoint(timepoint),
+	values(std::move(values))
+{
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace benchmark
+{
+	namespace data
+	{
+		struct Counter
+		{
+			Counter(const std::string& name, long long timepoint,
+					std::vector<std::pair<std::string, long long>> values);
+			std::string name;
+			long long timepoint = 0;
+			// The series of the counter, by their names, which get stacked on top of each other
+			std::vector<std::pair<std::string, long long>> values;
+		};
+	}
+}
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include "CelestialBody.h"
 #include "../Rendering/GlMacro.h"
+#include "../Rendering/GlStateCache.h"
+#include "../Benchmark/BenchmarkMacros.h"
 #include "../Keyboard.h"
+#include "../Noise/NoiseTableRegistry.h"
+#include "../Rendering/MipChain.h"
+#include "../Rendering/StreamBuffer.h"
 
 CelestialBody::CelestialBody(const std::shared_ptr<Program> renderingProgram,
 	const std::shared_ptr<Program> terrainGeneratorProgram, const Vector3& position,
@@ -8,6 +13,7 @@ CelestialBody::CelestialBody(const std::shared_ptr<Program> renderingProgram,
 	:
 	mRenderingProgram(renderingProgram),
 	mTerrainGeneratorProgram(terrainGeneratorProgram),
+	mPermutationUniformBuffer(PermutationUniformBuffer::Get(NoiseTableRegistry::DEFAULT_SEED)),
 	mPosition(position),
 	mScale(scale),
 	mVariableGroup(variableGroup)
@@ -18,63 +24,93 @@ CelestialBody::CelestialBody(const std::shared_ptr<Program> renderingProgram,
 	// is often easier to read and understand than a raw value.
 	assert(mDimensions.MODEL_RADIUS == 1.0f);
 
-	if (!msInitializedTextures)
+	if (!msInitializedSharedResources)
 	{
-		msInitializedTextures = true;
+		msInitializedSharedResources = true;
 		msTextures.emplace("CraterEjectaRay", "AsteroidNormal", "RockCliffNormal");
+
+		msMeshBuffer.emplace((GLsizei)sizeof(CelestialVertex));
+		InitializeVertexFormat(msMeshBuffer->GetVertexArray());
+
+		// A signed format, since the components of the normals range from -1 to 1
+		msDetailNormalMaps.emplace(GL_RGBA8_SNORM, DETAIL_NORMAL_MAP_SIZE,
+			mipchain::GetMipLevelCount(DETAIL_NORMAL_MAP_SIZE, DETAIL_NORMAL_MAP_SIZE, mipchain::FULL_CHAIN));
 	}
 
-	mDimensions.sideLengthInCells = int(mDimensions.MODEL_DIAMETER / cellSideLength);
-	// Make sure that the side length is not 0
-	assert(mDimensions.sideLengthInCells >= 1);
+	mDetailNormalMapLayer = msDetailNormalMaps->AllocateLayer();
+	// The allocation might have replaced the texture of the array
+	msTextureSet.bindings = { { celestialbodytextures::textureunit::DETAIL_NORMAL_MAP, msDetailNormalMaps->GetTexture() } };
 
-	mDimensions.cellSideLength = mDimensions.MODEL_DIAMETER / (float)mDimensions.sideLengthInCells;
+	SetDimensions(cellSideLength);
 
 	// The shader storage buffer object needs to be initialized
-	// before we initialize the vbo
+	// before we initialize the mesh
 	InitializeShaderStorageBufferObject();
 	InitializeUniformBufferObjects();
-
-	// The vbo needs to be initialized
-	// before we initialize the vao
-	InitializeVbo();
-
-	InitializeVao();
+	InitializeMesh();
 }
 
 CelestialBody::~CelestialBody()
 {
 	// We do not want to throw an exception inside a destructor. 
 	// Hence, we do not use the macro "GL".
-	glDeleteVertexArrays(1, &mVao);
-	glDeleteBuffers(1, &mVbo);
 	glDeleteBuffers(1, &mShaderStorageBufferObject);
 	glDeleteBuffers(1, &mCraterUniformBufferObject);
-	glDeleteBuffers(1, &mPermutationUniformBufferObject);
+	GlStateCache::ForgetBuffer(mShaderStorageBufferObject);
+	GlStateCache::ForgetBuffer(mCraterUniformBufferObject);
+
+	if (mMesh)
+	{
+		msMeshBuffer->Remove(*mMesh);
+	}
+	msDetailNormalMaps->FreeLayer(mDetailNormalMapLayer);
 }
 
-void CelestialBody::Render(const Camera& camera, const Matrix4& projectionMatrix) const
+void CelestialBody::UpdateSharedTextures()
 {
-	mRenderingProgram->Bind();
-	GL(glBindVertexArray(mVao));
+	assert(msTextures);
+	msTextures->Update();
+}
 
-	// Bind all the textures
-	msTextures->BindTexture(1);
-	msTextures->BindCraterTexture(2);
-	msTextures->BindCraterSampler(2);
-	msTextures->BindNormalMaps(3, 4);
-	msTextures->BindNormalInterpolation(5);
+void CelestialBody::RegenerateSharedTextures(const int size)
+{
+	assert(msTextures);
+	msTextures->GenerateNoiseTexturesOnGpu(size, size);
+}
 
-	// The permutation table is needed for perlin noise calculations inside the shader
-	GL(glBindBufferBase(GL_UNIFORM_BUFFER, 0, mPermutationUniformBufferObject));
+void CelestialBody::SaveSharedTextures()
+{
+	assert(msTextures);
+	msTextures->SaveNoiseTextures();
+}
 
-	BindUniforms(camera, projectionMatrix);
+void CelestialBody::BindSharedResources()
+{
+	assert(msTextures);
+	msTextures->Bind();
 
-	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)mSphereVertices.size());
+	// The permutation table is needed for perlin noise calculations inside the shaders.
+	// All the celestial bodies share the same one.
+	PermutationUniformBuffer::Get(NoiseTableRegistry::DEFAULT_SEED)->Bind(0);
+}
 
-	// We bind the default sampler, since we do not want
-	// the crater sampler, bound above, to still be bound
-	msTextures->BindDefaultSampler(2);
+void CelestialBody::Submit(RenderQueue& renderQueue, const Vector3& offset) const
+{
+	assert(mMesh);
+	const MeshBuffer::Range range = msMeshBuffer->GetRange(*mMesh);
+
+	DrawPacket packet;
+	packet.program = mRenderingProgram.get();
+	// The rest of the textures are already bound, by "BindSharedResources",
+	// to units that only the celestial bodies use
+	packet.textureSet = &msTextureSet;
+	packet.vertexArray = msMeshBuffer->GetVertexArray();
+	packet.first = range.first;
+	packet.count = range.count;
+	packet.drawData.position = TightlyPackedVector3(mPosition + offset);
+	packet.drawData.scale = mScale;
+	packet.drawData.textureLayer = mDetailNormalMapLayer;
+	renderQueue.Submit(packet);
 }
 
 void CelestialBody::Update(float deltaTime)
@@ -85,7 +121,7 @@ void CelestialBody::Update(float deltaTime)
 	{
 		// Update the vertices, if the user has changed
 		// the variables
-		UpdateVboVertices(mSphereVertices);
+		UpdateMeshVertices(mSphereVertices);
 	}
 }
 
@@ -100,6 +136,125 @@ float CelestialBody::GetRadius() const
 	return mDimensions.MODEL_RADIUS * mScale;
 }
 
+void CelestialBody::SetCellSideLength(const float cellSideLength)
+{
+	SetDimensions(cellSideLength);
+	mSphereVertices = GetSphereVertices();
+
+	// The craters, and thereby the detail normal map, only depend on the directions
+	// from the model's origin. Only the mesh needs to be regenerated.
+	UploadMesh(GetTerrainVertices(mSphereVertices));
+}
+
+float CelestialBody::GetCellSideLength() const
+{
+	return mDimensions.cellSideLength;
+}
+
+size_t CelestialBody::GetTriangleCount() const
+{
+	return mSphereVertices.size() / 3;
+}
+
+MeshError CelestialBody::MeasureMeshError()
+{
+	const int nSamples = MESH_ERROR_SAMPLES_PER_SIDE;
+	const float sampleSpacing = mDimensions.MODEL_DIAMETER / (float)nSamples;
+	const std::array<CubeFace, 6> faces = GetCubeFaces();
+
+	// Sample the terrain at the centres of a fine grid on each face, which
+	// places the samples in between the vertices of the mesh
+	std::vector<CelestialVertex> samples;
+	samples.reserve((size_t)nSamples * nSamples * faces.size());
+	for (const CubeFace& face : faces)
+	{
+		for (int y = 0; y < nSamples; ++y)
+		{
+			for (int x = 0; x < nSamples; ++x)
+			{
+				Vector3 position = face.lowerLeftCorner + face.tangent * (((float)x + 0.5f) * sampleSpacing)
+					+ face.binormal * (((float)y + 0.5f) * sampleSpacing);
+				position.Normalize();
+				samples.push_back(CelestialVertex{ TightlyPackedVector3(position), {}, {} });
+			}
+		}
+	}
+	samples = GetTerrainVertices(std::move(samples));
+
+	std::vector<CelestialVertex> meshVertices(mSphereVertices.size());
+	msMeshBuffer->Read(*mMesh, meshVertices.data());
+
+	const int n = mDimensions.sideLengthInCells;
+	double errorSum = 0.0;
+	MeshError error;
+	for (size_t i = 0; i < samples.size(); ++i)
+	{
+		const int faceIndex = int(i / ((size_t)nSamples * nSamples));
+		const int x = int(i % nSamples);
+		const int y = int(i / nSamples % nSamples);
+
+		// The position of the sample on the face of the cube, in cells. The mesh is
+		// displaced along the directions from the origin, so the triangle that the
+		// sample lies within on the cube, is also the one that it lies within on the mesh.
+		const float cellX = ((float)x + 0.5f) * sampleSpacing / mDimensions.cellSideLength;
+		const float cellY = ((float)y + 0.5f) * sampleSpacing / mDimensions.cellSideLength;
+		const int column = std::min((int)cellX, n - 1);
+		const int row = std::min((int)cellY, n - 1);
+
+		// Every cell is made up of two triangles, which are split along the
+		// diagonal from the lower right corner to the upper left one
+		const bool isInFirstTriangle = (cellX - (float)column) + (cellY - (float)row) <= 1.0f;
+		const size_t firstVertex = (((size_t)faceIndex * n + row) * n + column) * 6 + (isInFirstTriangle ? 0 : 3);
+
+		const Vector3 p0 = (Vector3)meshVertices[firstVertex].position;
+		const Vector3 p1 = (Vector3)meshVertices[firstVertex + 1].position;
+		const Vector3 p2 = (Vector3)meshVertices[firstVertex + 2].position;
+		const Vector3 terrainPosition = (Vector3)samples[i].position;
+
+		// The distance from the origin to where the direction of
+		// the sample intersects the plane of the triangle
+		const Vector3 triangleNormal = (p1 - p0).Cross(p2 - p0);
+		const Vector3 direction = terrainPosition.GetNormalized();
+		const float meshDistance = triangleNormal.Dot(p0) / triangleNormal.Dot(direction);
+
+		const float sampleError = std::abs(meshDistance - terrainPosition.GetLength());
+		errorSum += (double)sampleError;
+		error.max = std::max(error.max, sampleError);
+	}
+	error.mean = (float)(errorSum / (double)samples.size());
+
+	return error;
+}
+
+std::array<CelestialBody::CubeFace, 6> CelestialBody::GetCubeFaces() const
+{
+	const float r = mDimensions.MODEL_RADIUS;
+	return
+	{
+		// Front face
+		CubeFace{ { -r, -r, r }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+		// Back face
+		CubeFace{ { r, -r, -r }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } },
+		// Left face
+		CubeFace{ { -r, -r, -r }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f } },
+		// Right face
+		CubeFace{ { r, -r, r }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } },
+		// Top face
+		CubeFace{ { -r, r, r }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } },
+		// Bottom face
+		CubeFace{ { -r, -r, -r }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }
+	};
+}
+
+void CelestialBody::SetDimensions(const float cellSideLength)
+{
+	mDimensions.sideLengthInCells = int(mDimensions.MODEL_DIAMETER / cellSideLength);
+	// Make sure that the side length is not 0
+	assert(mDimensions.sideLengthInCells >= 1);
+
+	mDimensions.cellSideLength = mDimensions.MODEL_DIAMETER / (float)mDimensions.sideLengthInCells;
+}
+
 std::vector<CelestialVertex> CelestialBody::GetFaceVertices(const Vector3& lowerLeftCornerOfFace,
 	const Vector3& tangent, const Vector3& binormal) const
 {
@@ -166,35 +321,10 @@ std::vector<CelestialVertex> CelestialBody::GetSphereVertices() const
 	// a sphere, but originally hade the shape of a cube
 	std::vector<std::vector<CelestialVertex>> cubeVertices;
 
-	// Front face
-	cubeVertices.push_back(
-		GetFaceVertices({ -mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS, mDimensions.MODEL_RADIUS },
-			{ 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }));
-
-	// Back face
-	cubeVertices.push_back(
-		GetFaceVertices({ mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS },
-			{ -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }));
-
-	// Left face
-	cubeVertices.push_back(
-		GetFaceVertices({ -mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS },
-			{ 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }));
-
-	// Right face
-	cubeVertices.push_back(
-		GetFaceVertices({ mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS, mDimensions.MODEL_RADIUS },
-			{ 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f }));
-
-	// Top face
-	cubeVertices.push_back(
-		GetFaceVertices({ -mDimensions.MODEL_RADIUS, mDimensions.MODEL_RADIUS, mDimensions.MODEL_RADIUS },
-			{ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }));
-
-	// Bottom face
-	cubeVertices.push_back(
-		GetFaceVertices({ -mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS, -mDimensions.MODEL_RADIUS },
-			{ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }));
+	for (const CubeFace& face : GetCubeFaces())
+	{
+		cubeVertices.push_back(GetFaceVertices(face.lowerLeftCorner, face.tangent, face.binormal));
+	}
 
 	std::vector<CelestialVertex> vertices;
 	// All the sides have the same amount of vertices, hence we can multiply by 6
@@ -296,29 +426,38 @@ std::vector<bool> CelestialBody::GetCraterTextureBools(
 	return textureBools;
 }
 
-void CelestialBody::RunTerrainGeneratorProgram(const size_t nVertices,
-const int nCraters, const float maxCraterTextureRadius)
+void CelestialBody::BindTerrainGeneratorProgram(const bool bakeNormalMap)
 {
 	mTerrainGeneratorProgram->Bind();
 
 	// We give the compute shader access to all the vertices, by binding
 	// the shader storage buffer object
-	GL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mShaderStorageBufferObject));
+	GlStateCache::Get().BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mShaderStorageBufferObject);
 
 	// The permutation table is needed for perlin noise calculations inside the shader
-	GL(glBindBufferBase(GL_UNIFORM_BUFFER, 1, mPermutationUniformBufferObject));
+	mPermutationUniformBuffer->Bind(1);
 
 	// The uniform buffer object contains the crater data that is needed for generating
 	// the craters
-	GL(glBindBufferBase(GL_UNIFORM_BUFFER, 2, mCraterUniformBufferObject));
+	GlStateCache::Get().BindBufferBase(GL_UNIFORM_BUFFER, 2, mCraterUniformBufferObject);
 
-	GL(glUniform1i(0, nCraters));
-	GL(glUniform1f(1, maxCraterTextureRadius));
+	GL(glUniform1i(0, (int)mVariableGroup->Get(0)));
+	GL(glUniform1f(1, mVariableGroup->Get(2)));
 
 	std::vector<float> dynamicVariables = mVariableGroup->GetVariables();
 	// Pass the dynamic variables (which contain additional parameters for
 	// generating the terrain of the celestial body) to the shader
 	GL(glUniform1fv(2, (GLsizei)dynamicVariables.size(), &dynamicVariables.front()));
+
+	// The program is shared between the celestial bodies, so the mode needs to be set every time
+	GL(glUniform1i(23, bakeNormalMap));
+	GL(glUniform1i(24, DETAIL_NORMAL_MAP_SIZE));
+}
+
+void CelestialBody::RunTerrainGeneratorProgram(const size_t nVertices)
+{
+	GPU_BENCHMARK("Terrain generation");
+	BindTerrainGeneratorProgram(false);
 	
 	// Execute the compute shader. We know that "nVertices" will
 	// be divisible by 36, since we have generated,
@@ -327,24 +466,15 @@ const int nCraters, const float maxCraterTextureRadius)
 	GL(glDispatchCompute(GLuint(nVertices / 36), 1, 1));
 }
 
-void CelestialBody::UpdateVboVertices(std::vector<CelestialVertex> vertices)
+std::vector<CelestialVertex> CelestialBody::GetTerrainVertices(std::vector<CelestialVertex> vertices)
 {
-	const int nCraters = (int)mVariableGroup->Get(0);
-	const float maxCraterTextureRadius = mVariableGroup->Get(2);
-	
 	// We update the shader storage buffer object, so that we are able
 	// to access the vertices from the terrain generator program
 	UpdateShaderStorageBufferObject(vertices);
 
-	// If craters should be generated, update the uniform buffer object with new crater data
-	if (nCraters > 0)
-	{
-		UpdateUniformBufferObject(vertices, nCraters, maxCraterTextureRadius);
-	}
-	
 	// Update the vertices inside the shader storage buffer,
 	// by running the terrain generator program
-	RunTerrainGeneratorProgram(vertices.size(), nCraters, maxCraterTextureRadius);
+	RunTerrainGeneratorProgram(vertices.size());
 
 	// Wait for the vertices inside the shader storage buffer to 
 	// get updated
@@ -352,7 +482,7 @@ void CelestialBody::UpdateVboVertices(std::vector<CelestialVertex> vertices)
 
 	// Get the updated vertices
 	CelestialVertexGlsl* updatedVerticesGlsl =
-		(CelestialVertexGlsl*)GL(glMapNamedBufferRange(mShaderStorageBufferObject, NULL,
+		(CelestialVertexGlsl*)GL(glMapNamedBufferRange(mShaderStorageBufferObject, 0,
 			vertices.size() * sizeof(CelestialVertexGlsl), GL_MAP_READ_BIT));
 
 	// Tansform the glsl vertices into regular vertices
@@ -365,28 +495,77 @@ void CelestialBody::UpdateVboVertices(std::vector<CelestialVertex> vertices)
 	// We are done reading from the shader storage buffer
 	GL(glUnmapNamedBuffer(mShaderStorageBufferObject));
 
-	// Finally, update the vbo with the newly updated vertices
-	GL(glNamedBufferData(mVbo, sizeof(CelestialVertex) * vertices.size(), &vertices.front(), GL_STATIC_DRAW));
+	return vertices;
+}
+
+void CelestialBody::UpdateMeshVertices(std::vector<CelestialVertex> vertices)
+{
+	const int nCraters = (int)mVariableGroup->Get(0);
+	const float maxCraterTextureRadius = mVariableGroup->Get(2);
+
+	// If craters should be generated, update the uniform buffer object with new crater data
+	if (nCraters > 0)
+	{
+		UpdateUniformBufferObject(vertices, nCraters, maxCraterTextureRadius);
+	}
+	
+	// Finally, update the mesh with the newly updated vertices
+	UploadMesh(GetTerrainVertices(std::move(vertices)));
+
+	// The terrain has changed, so the normals need to be baked again
+	BakeDetailNormalMap();
 }
 
-void CelestialBody::InitializeVao()
+void CelestialBody::BakeDetailNormalMap()
 {
-	GL(glCreateVertexArrays(1, &mVao));
-	GL(glBindVertexArray(mVao));
+	GPU_BENCHMARK("Detail normal map bake");
+	BindTerrainGeneratorProgram(true);
 
-	GL(glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(CelestialVertex, position)));
-	GL(glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(CelestialVertex, uv)));
-	GL(glVertexAttribFormat(2, 3, GL_FLOAT, GL_FALSE, offsetof(CelestialVertex, normal)));
+	// The compute shader writes directly into all the faces of the
+	// layer, through a cube map that views the layer
+	const GLuint detailNormalMap = msDetailNormalMaps->CreateLayerView(mDetailNormalMapLayer);
+	GlStateCache::Get().BindImageTexture(0, detailNormalMap, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8_SNORM);
 
-	GL(glVertexArrayAttribBinding(mVao, 0, 0));
-	GL(glVertexArrayAttribBinding(mVao, 1, 0));
-	GL(glVertexArrayAttribBinding(mVao, 2, 0));
+	// One invocation per texel, and 12 invocations per work group
+	GL(glDispatchCompute(GLuint(DETAIL_NORMAL_MAP_SIZE * DETAIL_NORMAL_MAP_SIZE * 6 / 12), 1, 1));
 
-	GL(glEnableVertexAttribArray(0));
-	GL(glEnableVertexAttribArray(1));
-	GL(glEnableVertexAttribArray(2));
+	// The normal map will get sampled after the compute shader has written to it
+	GL(glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT));
 
-	GL(glVertexArrayVertexBuffer(mVao, 0, mVbo, NULL, sizeof(CelestialVertex)));
+	// The first mip level only exists on the GPU, so the mip chain is generated there,
+	// instead of on the CPU. The view limits the generation to the layer.
+	GL(glGenerateTextureMipmap(detailNormalMap));
+	GL(glDeleteTextures(1, &detailNormalMap));
+	GlStateCache::ForgetTexture(detailNormalMap);
+}
+
+void CelestialBody::UploadMesh(const std::vector<CelestialVertex>& vertices)
+{
+	if (mMesh)
+	{
+		msMeshBuffer->Update(*mMesh, vertices.data(), (GLsizei)vertices.size());
+	}
+	else
+	{
+		mMesh = msMeshBuffer->Add(vertices.data(), (GLsizei)vertices.size());
+	}
+}
+
+void CelestialBody::InitializeVertexFormat(const GLuint vertexArray)
+{
+	GL(glVertexArrayAttribFormat(vertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof(CelestialVertex, position)));
+	GL(glVertexArrayAttribFormat(vertexArray, 1, 3, GL_FLOAT, GL_FALSE, offsetof(CelestialVertex, uv)));
+	GL(glVertexArrayAttribFormat(vertexArray, 2, 3, GL_FLOAT, GL_FALSE, offsetof(CelestialVertex, normal)));
+
+	GL(glVertexArrayAttribBinding(vertexArray, 0, 0));
+	GL(glVertexArrayAttribBinding(vertexArray, 1, 0));
+	GL(glVertexArrayAttribBinding(vertexArray, 2, 0));
+
+	GL(glEnableVertexArrayAttrib(vertexArray, 0));
+	GL(glEnableVertexArrayAttrib(vertexArray, 1));
+	GL(glEnableVertexArrayAttrib(vertexArray, 2));
+
+	// The mesh buffer binds its vertex buffer to the binding index 0
 }
 
 void CelestialBody::InitializeShaderStorageBufferObject()
@@ -400,41 +579,17 @@ void CelestialBody::InitializeUniformBufferObjects()
 
 	// The buffer has to be able to hold "MAX_CRATER_COUNT" amount of "CraterData" instances.
 	// Each "CraterData" instance is aligned at a multiple of 2 * the size of a "vec4", hence
-	// we multiply by "4 * 4 * 2".
-	GL(glNamedBufferData(mCraterUniformBufferObject, MAX_CRATER_COUNT * 4 * 4 * 2,
-		NULL, GL_STATIC_DRAW));
-
-	// vvv Initialization of "mPermutationUniformBufferObject" vvv
-
-	GL(glCreateBuffers(1, &mPermutationUniformBufferObject));
-
-	struct Vector4AlignedInt
-	{
-		Vector4AlignedInt(const int value)
-			:
-			value(value)
-		{}
-		Vector4AlignedInt() = default;
-		int alignas(4 * 4) value = 0;
-	};
-	// We are aligning each element of the permutation table as a "vec4", to
-	// conform to the std140 storage layout
-	BasicPermutationTable<Vector4AlignedInt, 256> permutationTable;
-	// The "stride" (in memory) between each element is 4 * 4 bytes. The start of the last element
-	// is therefore "(permutationTable.Size() - 1) * 4 * 4". The total size is the start of the
-	// last element + the size of the last element, i.e, "(permutationTable.Size() - 1) * 4 * 4 + sizeof(int)"
-	GL(glNamedBufferData(mPermutationUniformBufferObject, (permutationTable.Size() - 1) * 4 * 4 + sizeof(int),
-		permutationTable.GetPointerToData(), GL_STATIC_DRAW));
+	// we multiply by "4 * 4 * 2". The storage is immutable, since the crater data is only
+	// ever copied into it, on the GPU, from the stream buffer.
+	GL(glNamedBufferStorage(mCraterUniformBufferObject, MAX_CRATER_COUNT * 4 * 4 * 2, NULL, 0));
 }
 
-void CelestialBody::InitializeVbo()
+void CelestialBody::InitializeMesh()
 {
-	GL(glCreateBuffers(1, &mVbo));
-
 	mSphereVertices = GetSphereVertices();
 
-	// Update the vertices of the vbo
-	UpdateVboVertices(mSphereVertices);
+	// Generate the terrain of the mesh
+	UpdateMeshVertices(mSphereVertices);
 }
 
 void CelestialBody::UpdateUniformBufferObject(const std::vector<CelestialVertex>& vertices,
@@ -465,11 +620,12 @@ void CelestialBody::UpdateUniformBufferObject(const std::vector<CelestialVertex>
 
 	// Each "CraterData" instance is aligned at a multiple of 2 * the size of a "vec4", hence
 	// we multiply by "4 * 4 * 2"
-	GL(glNamedBufferData(mCraterUniformBufferObject, uniformBufferData.size() * 4 * 4 * 2,
-		&uniformBufferData.front(), GL_STATIC_DRAW));
+	assert(nCraters <= MAX_CRATER_COUNT);
+	StreamBuffer::Get().CopyToBuffer(mCraterUniformBufferObject, 0, &uniformBufferData.front(),
+		uniformBufferData.size() * 4 * 4 * 2);
 }
 
-void CelestialBody::UpdateShaderStorageBufferObject(const std::vector<CelestialVertex>& vertices) const
+void CelestialBody::UpdateShaderStorageBufferObject(const std::vector<CelestialVertex>& vertices)
 {
 	// Convert the vector of "CelestialVertex" to a vector of 
 	// "CelestialVertexGlsl", i.e. a vector of vertices that 
@@ -482,19 +638,15 @@ void CelestialBody::UpdateShaderStorageBufferObject(const std::vector<CelestialV
 			return CelestialVertexGlsl{ vertex.position, vertex.uv, vertex.normal };
 		});
 
-	// Update the shader storage buffer object with the correctly memory aligned vertices
-	GL(glNamedBufferData(mShaderStorageBufferObject, verticesGlsl.size() * sizeof(CelestialVertexGlsl)
-		, &verticesGlsl.front(), GL_DYNAMIC_READ));
-}
-
-void CelestialBody::BindUniforms(const Camera& camera, const Matrix4& projectionMatrix) const
-{
-	const Matrix4 viewRotation = 
-		(Matrix4)matrix::GetRotation(-camera.GetXRotation(), -camera.GetYRotation(), 0.0f);
+	// The storage is only reallocated when the vertices do not fit, which
+	// is only the case when the resolution of the mesh has been increased
+	const size_t size = verticesGlsl.size() * sizeof(CelestialVertexGlsl);
+	if (size > mShaderStorageBufferSize)
+	{
+		GL(glNamedBufferData(mShaderStorageBufferObject, size, NULL, GL_DYNAMIC_READ));
+		mShaderStorageBufferSize = size;
+	}
 
-	GL(glUniform3fv(0, 1, camera.GetPosition().GetPointerToData()));
-	GL(glUniformMatrix4fv(1, 1, GL_FALSE, viewRotation.GetPointerToData()));
-	GL(glUniformMatrix4fv(2, 1, GL_FALSE, projectionMatrix.GetPointerToData()));
-	GL(glUniform3fv(3, 1, mPosition.GetPointerToData()));
-	GL(glUniform1f(4, mScale));	
+	// Update the shader storage buffer object with the correctly memory aligned vertices
+	StreamBuffer::Get().CopyToBuffer(mShaderStorageBufferObject, 0, &verticesGlsl.front(), size);
 }
\ No newline at end of file
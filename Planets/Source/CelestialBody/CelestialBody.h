@@ -1,11 +1,16 @@
 #pragma once
 #include "../Rendering/Program.h"
+#include "../Rendering/PermutationUniformBuffer.h"
 #include "../Rendering/Camera.h"
+#include "../Rendering/MeshBuffer.h"
+#include "../Rendering/CubeMapArray.h"
+#include "../Rendering/RenderQueue.h"
 #include "../Mathematics/Matrix/Matrix.h"
 #include "../Rendering/Vertex/CelestialVertex.h"
 #include "../Rendering/Vertex/CelestialVertexGlsl.h"
 #include "../DynamicVariableGroup.h"
 #include "CelestialBodyTextures.h"
+#include <array>
 
 struct CraterData
 {
@@ -36,6 +41,13 @@ struct CelestialBodyDimensions
 	static constexpr float MODEL_DIAMETER = MODEL_RADIUS * 2.0f;
 };
 
+// How far a mesh is from the terrain with all of its detail, in model space
+struct MeshError
+{
+	float mean = 0.0f;
+	float max = 0.0f;
+};
+
 class CelestialBody
 {
 public:
@@ -43,13 +55,51 @@ public:
 		const std::shared_ptr<Program> terrainGeneratorProgram, const Vector3& position,
 		float scale, float cellSideLength, std::shared_ptr<DynamicVariableGroup<float>> variableGroup);
 	~CelestialBody();
-	void Render(const Camera& camera, const Matrix4& projectionMatrix) const;
+
+	// Updates the textures that all the celestial bodies share. Needs to be
+	// called once per frame, before "BindSharedResources".
+	static void UpdateSharedTextures();
+	// Regenerates the shared noise textures on the GPU, with the resolution "size" x "size"
+	static void RegenerateSharedTextures(int size);
+	// Writes the shared noise textures to the files that they are loaded from at startup
+	static void SaveSharedTextures();
+
+	// Binds the textures, and the uniform buffer, that all the celestial bodies share.
+	// Needs to be called once per frame, before any of the celestial bodies are rendered.
+	static void BindSharedResources();
+
+	// Submits the draw of the celestial body, moved by "offset". The celestial bodies that
+	// share a rendering program get drawn together, when the render queue is flushed.
+	void Submit(RenderQueue& renderQueue, const Vector3& offset = Vector3(0.0f, 0.0f, 0.0f)) const;
 	void Update(float deltaTime);
 	Vector3 GetPosition() const;
 
 	// Returns the radius of the rendered celestial body
 	float GetRadius() const;
+
+	// Regenerates the mesh with cells of the side length "cellSideLength", but keeps the
+	// craters. The shading keeps its detail, no matter how coarse the mesh is, since the
+	// normals are sampled from the detail normal map.
+	void SetCellSideLength(float cellSideLength);
+	float GetCellSideLength() const;
+	size_t GetTriangleCount() const;
+
+	// Compares the mesh with the terrain, which is sampled in between the vertices
+	// of the mesh. Reads back the mesh, so it should not be called every frame.
+	MeshError MeasureMeshError();
 private:
+	struct CubeFace
+	{
+		Vector3 lowerLeftCorner;
+		Vector3 tangent;
+		Vector3 binormal;
+	};
+
+	// Returns the faces of the cube that gets projected on to the sphere
+	std::array<CubeFace, 6> GetCubeFaces() const;
+
+	void SetDimensions(float cellSideLength);
+
 	// Returns all the vertices of the face projected on to a sphere of radius:
 	// "mDimensions.MODEL_RADIUS"
 	std::vector<CelestialVertex> GetFaceVertices(const Vector3& lowerLeftCornerOfFace,
@@ -62,19 +112,36 @@ private:
 	// shape of a cube
 	std::vector<CelestialVertex> GetSphereVertices() const;
 
+	// Binds the terrain generator program, along with its buffers and uniforms. When
+	// "bakeNormalMap" is set, the program bakes the detail normal map instead of
+	// generating the terrain of the vertices.
+	void BindTerrainGeneratorProgram(bool bakeNormalMap);
+
 	// Runs the terrain generator program, a compute shader, which will
 	// generate the terrain of the vertices inside the shader storage buffer
-	void RunTerrainGeneratorProgram(size_t nVertices, int nCraters, float maxCraterTextureRadius);
+	void RunTerrainGeneratorProgram(size_t nVertices);
 
-	// Will run the terrain generator program and update the vertices inside
-	// the vbo, which will affect the rendered celestial body. "mSphereVertices"
-	// will remain unchanged.
-	void UpdateVboVertices(std::vector<CelestialVertex> vertices);
+	// Runs the terrain generator program on the vertices, which should lie on the
+	// sphere, and returns them with the terrain applied
+	std::vector<CelestialVertex> GetTerrainVertices(std::vector<CelestialVertex> vertices);
+
+	// Will generate new craters, run the terrain generator program and update the
+	// vertices of the mesh, which will affect the rendered celestial body.
+	// "mSphereVertices" will remain unchanged.
+	void UpdateMeshVertices(std::vector<CelestialVertex> vertices);
+
+	// Replaces the vertices of the mesh, inside the shared mesh buffer
+	void UploadMesh(const std::vector<CelestialVertex>& vertices);
+
+	// Bakes the normals of the terrain, with all of its detail, into the detail normal map
+	void BakeDetailNormalMap();
+
+	// Specifies the vertex format of the shared mesh buffer's vertex array object
+	static void InitializeVertexFormat(GLuint vertexArray);
 
-	void InitializeVao();
 	void InitializeShaderStorageBufferObject();
 	void InitializeUniformBufferObjects();
-	void InitializeVbo();
+	void InitializeMesh();
 
 	// The following three methods generate crater data that will get passed to
 	// the terrain generator program through the uniform buffer object
@@ -90,10 +157,8 @@ private:
 		int nCraters, float maxCraterTextureRadius);
 
 	// Updates the shader storage buffer object with the passed in vertices
-	void UpdateShaderStorageBufferObject(const std::vector<CelestialVertex>& vertices) const;
+	void UpdateShaderStorageBufferObject(const std::vector<CelestialVertex>& vertices);
 
-	// Binds all the necessary uniforms for rendering
-	void BindUniforms(const Camera& camera, const Matrix4& projectionMatrix) const;
 private:
 	// The textures are static, since we want all the celestial bodies
 	// to share the same textures. We can not initialize the textures
@@ -101,7 +166,14 @@ private:
 	// the initialization of GLEW. We therefore use "std::optional"
 	// to delay the initialization.
 	static inline std::optional<CelestialBodyTextures> msTextures;
-	static inline bool msInitializedTextures = false;
+	static inline bool msInitializedSharedResources = false;
+
+	// The meshes and the detail normal maps of all the celestial bodies are stored
+	// together, so that the celestial bodies that share a rendering program can be
+	// drawn with a single multi-draw call
+	static inline std::optional<MeshBuffer> msMeshBuffer;
+	static inline std::optional<CubeMapArray> msDetailNormalMaps;
+	static inline TextureSet msTextureSet;
 
 	const std::shared_ptr<Program> mRenderingProgram;
 
@@ -110,11 +182,20 @@ private:
 	const std::shared_ptr<Program> mTerrainGeneratorProgram;
 
 	// The OpenGL objects
-	GLuint mVao = 0;
-	GLuint mVbo = 0;
 	GLuint mShaderStorageBufferObject = 0;
 	GLuint mCraterUniformBufferObject = 0;
-	GLuint mPermutationUniformBufferObject = 0;
+	// The size, in bytes, of the shader storage buffer object, which only ever grows
+	size_t mShaderStorageBufferSize = 0;
+
+	// The mesh of the terrain, inside "msMeshBuffer"
+	std::optional<MeshBuffer::MeshId> mMesh;
+	// The layer, inside "msDetailNormalMaps", with the object-space normals
+	// of the terrain, baked per direction from the model's origin
+	int mDetailNormalMapLayer = 0;
+
+	// The permutation table is needed for the perlin noise calculations
+	// inside the shaders. All the celestial bodies share the same one.
+	const std::shared_ptr<const PermutationUniformBuffer> mPermutationUniformBuffer;
 
 	Vector3 mPosition;
 	float mScale = 0.0f;
@@ -131,4 +212,15 @@ private:
 	CelestialBodyDimensions mDimensions;
 
 	static constexpr int MAX_CRATER_COUNT = 1024;
+
+	// The resolution of each face of the detail normal map. Needs to be even, since
+	// the terrain generator program has 12 invocations per work group.
+	static constexpr int DETAIL_NORMAL_MAP_SIZE = 512;
+	static_assert(DETAIL_NORMAL_MAP_SIZE * DETAIL_NORMAL_MAP_SIZE * 6 % 12 == 0);
+
+	// The terrain is sampled at this many points, along each side of each face,
+	// when measuring the error of the mesh. The samples are run through the terrain
+	// generator program, which needs the number of samples to be divisible by 36.
+	static constexpr int MESH_ERROR_SAMPLES_PER_SIDE = 240;
+	static_assert(MESH_ERROR_SAMPLES_PER_SIDE * MESH_ERROR_SAMPLES_PER_SIDE * 6 % 36 == 0);
 };
\ No newline at end of file
@@ -1,16 +1,19 @@
 #include "CelestialBodyTextures.h"
-#include "../Noise/PerlinNoise.h"
+#include "../Noise/NoiseTableRegistry.h"
 #include "../Rendering/GlMacro.h"
-#include <fstream>
+#include "../Rendering/GlStateCache.h"
+#include "../Rendering/TextureContainer.h"
+#include "../Rendering/MipChain.h"
 
 CelestialBodyTextures::CelestialBodyTextures(const std::string& craterTexture, 
 	const std::string& normalMap, const std::string& secondNormalMap)
 	:
-	mCraterTexture(craterTexture),
-	mNormalMap(normalMap),
-	mSecondNormalMap(secondNormalMap)
+	mCraterTexture(AssetCache::Get().GetTexture(craterTexture)),
+	mNormalMap(AssetCache::Get().GetTexture(normalMap, TextureKind::NormalMap)),
+	mSecondNormalMap(AssetCache::Get().GetTexture(secondNormalMap, TextureKind::NormalMap))
 {
-	auto permutationTable = std::make_shared<PermutationTable<256>>();
+	auto permutationTable =
+		NoiseTableRegistry::Get().GetPermutationTable<256>(NoiseTableRegistry::DEFAULT_SEED);
 	InitializeAllGlTextures(*permutationTable);
 }
 
@@ -18,18 +21,29 @@ CelestialBodyTextures::CelestialBodyTextures(const std::string& craterTexture,
 	const std::string& normalMap, const std::string& secondNormalMap, 
 	const celestialbodytextures::GenerateTexturesFlag&)
 	:
-	mCraterTexture(craterTexture),
-	mNormalMap(normalMap),
-	mSecondNormalMap(secondNormalMap)
+	mCraterTexture(AssetCache::Get().GetTexture(craterTexture)),
+	mNormalMap(AssetCache::Get().GetTexture(normalMap, TextureKind::NormalMap)),
+	mSecondNormalMap(AssetCache::Get().GetTexture(secondNormalMap, TextureKind::NormalMap))
 {
-	auto permutationTable = std::make_shared<PermutationTable<256>>();
+	auto permutationTable =
+		NoiseTableRegistry::Get().GetPermutationTable<256>(NoiseTableRegistry::DEFAULT_SEED);
+
+	const std::string normalInterpolationFilePath =
+		TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + texturecontainer::FILE_EXTENSION;
+	const std::string surfaceFilePath = TEXTURE_PATH + SURFACE_TEXTURE_NAME + texturecontainer::FILE_EXTENSION;
+
+	#if LOG_BAKING_THROUGHPUT
+		NoiseTextureBaker::LogThroughput(permutationTable, GENERATED_TEXTURE_SIZE, GENERATED_TEXTURE_SIZE,
+			surfaceFilePath, normalInterpolationFilePath);
+	#endif
 
 	// Generate new data for the normal interpolation texture
 	// and the surface texture, before initializing the textures
 	// vvv
-	PerlinNoise<2> perlinNoise(permutationTable);
-	GenerateNormalInterpolationTexture(255, 255, perlinNoise);
-	GenerateSurfaceTexture(255, 255, perlinNoise);
+	NoiseTextureBaker baker(permutationTable);
+	baker.BakeNormalInterpolationTexture(GENERATED_TEXTURE_SIZE, GENERATED_TEXTURE_SIZE,
+		normalInterpolationFilePath);
+	baker.BakeSurfaceTexture(GENERATED_TEXTURE_SIZE, GENERATED_TEXTURE_SIZE, surfaceFilePath);
 	// ^^^
 
 	InitializeAllGlTextures(*permutationTable);
@@ -41,277 +55,176 @@ CelestialBodyTextures::~CelestialBodyTextures()
 	// Hence, we do not use the macro "GL".
 	glDeleteTextures(1, &mTexture);
 	glDeleteTextures(1, &mNormalInterpolationTexture);
-	glDeleteSamplers(1, &mCraterSampler);
-	glDeleteSamplers(1, &mDefaultSampler);
+	GlStateCache::ForgetTexture(mTexture);
+	GlStateCache::ForgetTexture(mNormalInterpolationTexture);
 }
 
-void CelestialBodyTextures::BindTexture(GLuint location) const
+void CelestialBodyTextures::GenerateNoiseTexturesOnGpu(const int width, const int height)
 {
-	GL(glBindTextureUnit(location, mTexture));
-}
+	if (width < 1 || height < 1 || width > NoiseTextureBaker::MAX_SIZE || height > NoiseTextureBaker::MAX_SIZE)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not generate noise textures with the size " + std::to_string(width)
+			+ "x" + std::to_string(height));
+	}
 
-void CelestialBodyTextures::BindNormalMaps(GLuint location0, GLuint location1) const
-{
-	mNormalMap.Bind(location0);
-	mSecondNormalMap.Bind(location1);
-}
+	if (!mTextureGeneratorProgram)
+	{
+		mTextureGeneratorProgram.emplace("CelestialBodyTextureGeneration");
+		mPermutationUniformBuffer = PermutationUniformBuffer::Get(NoiseTableRegistry::DEFAULT_SEED);
+	}
 
-void CelestialBodyTextures::BindNormalInterpolation(GLuint location) const
-{
-	GL(glBindTextureUnit(location, mNormalInterpolationTexture));
-}
+	// The storage of a texture is immutable, so the textures
+	// need to be recreated when the resolution changes
+	// vvv
+	glDeleteTextures(1, &mTexture);
+	glDeleteTextures(1, &mNormalInterpolationTexture);
+	GlStateCache::ForgetTexture(mTexture);
+	GlStateCache::ForgetTexture(mNormalInterpolationTexture);
 
-void CelestialBodyTextures::BindCraterTexture(GLuint location) const
-{
-	mCraterTexture.Bind(location);
-}
+	const int nMipLevels = mipchain::GetMipLevelCount(width, height, mipchain::FULL_CHAIN);
 
-void CelestialBodyTextures::BindCraterSampler(GLuint location) const
-{
-	GL(glBindSampler(location, mCraterSampler));
-}
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mTexture));
+	GL(glTextureStorage2D(mTexture, nMipLevels, GL_RGBA8, width, height));
 
-void CelestialBodyTextures::BindDefaultSampler(GLuint location) const
-{
-	GL(glBindSampler(location, mDefaultSampler));
-}
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mNormalInterpolationTexture));
+	GL(glTextureStorage2D(mNormalInterpolationTexture, nMipLevels, GL_R32F, width, height));
+	// ^^^
 
-void CelestialBodyTextures::InitializeNormalInterpolation()
-{
-	int width = 0;
-	int height = 0;
-	auto pixels = GetNormalInterpolationPixels(width, height);
+	mTextureGeneratorProgram->Bind();
 
-	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mNormalInterpolationTexture));
-	GL(glTextureStorage2D(mNormalInterpolationTexture, 1, GL_R32F, width, height));
-	GL(glTextureSubImage2D(mNormalInterpolationTexture, 0, 0, 0, width, height, GL_RED, GL_FLOAT, pixels.get()));
+	// The compute shader writes directly into the textures
+	GlStateCache& stateCache = GlStateCache::Get();
+	stateCache.BindImageTexture(0, mTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	stateCache.BindImageTexture(1, mNormalInterpolationTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+	// The permutation table is needed for perlin noise calculations inside the shader
+	mPermutationUniformBuffer->Bind(1);
+
+	GL(glUniform2i(0, width, height));
+	// The noise is evaluated in the coordinate space of the reference size, just
+	// like the "NoiseTextureBaker" does, so that the pattern does not change
+	// with the resolution
+	GL(glUniform2f(1, (float)NoiseTextureBaker::REFERENCE_SIZE / (float)width,
+		(float)NoiseTextureBaker::REFERENCE_SIZE / (float)height));
+
+	// Each work group covers 8 x 8 texels, hence we round up to a multiple of 8
+	GL(glDispatchCompute(GLuint((width + 7) / 8), GLuint((height + 7) / 8), 1));
+
+	// The textures will get sampled, and possibly read back by "SaveNoiseTextures",
+	// after the compute shader has written to them
+	GL(glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT));
+
+	// The first mip levels only exist on the GPU, so the mip
+	// chains are generated there, instead of on the CPU
+	GL(glGenerateTextureMipmap(mTexture));
+	GL(glGenerateTextureMipmap(mNormalInterpolationTexture));
 }
 
-void CelestialBodyTextures::InitializeTexture()
+void CelestialBodyTextures::SaveNoiseTextures() const
 {
 	int width = 0;
 	int height = 0;
-	auto pixels = GetSurfacePixels(width, height);
+	GL(glGetTextureLevelParameteriv(mTexture, 0, GL_TEXTURE_WIDTH, &width));
+	GL(glGetTextureLevelParameteriv(mTexture, 0, GL_TEXTURE_HEIGHT, &height));
 
-	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mTexture));
-	GL(glTextureStorage2D(mTexture, 1, GL_RGBA8, width, height));
-	GL(glTextureSubImage2D(mTexture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.get()));
-}
+	// vvv Surface texture vvv
+	const size_t surfacePixelsSize = textureformat::GetImageSize(TextureFormat::Rgba8, width, height);
+	auto surfacePixels = std::make_unique<unsigned char[]>(surfacePixelsSize);
+	GL(glGetTextureImage(mTexture, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)surfacePixelsSize, surfacePixels.get()));
 
-void CelestialBodyTextures::InitializeCraterSampler()
-{
-	GL(glCreateSamplers(1, &mCraterSampler));
+	TextureContainerWriter surfaceWriter(TEXTURE_PATH + SURFACE_TEXTURE_NAME + texturecontainer::FILE_EXTENSION,
+		TextureFormat::Rgba8, width, height);
+	surfaceWriter.Write(surfacePixels.get(), surfacePixelsSize);
+	surfaceWriter.Finish();
+	// ^^^ Surface texture ^^^
 
-	// If we, by accident, come outside the texture we want
-	// the colour to be fully transparent
-	const float colour[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-	GL(glSamplerParameterfv(mCraterSampler, GL_TEXTURE_BORDER_COLOR, colour));
+	// vvv Normal interpolation texture vvv
+	const size_t normalInterpolationPixelsSize = textureformat::GetImageSize(TextureFormat::R32f, width, height);
+	auto normalInterpolationPixels = std::make_unique<float[]>((size_t)width * height);
+	GL(glGetTextureImage(mNormalInterpolationTexture, 0, GL_RED, GL_FLOAT, (GLsizei)normalInterpolationPixelsSize,
+		normalInterpolationPixels.get()));
 
-	GL(glSamplerParameteri(mCraterSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER));
-	GL(glSamplerParameteri(mCraterSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER));
+	TextureContainerWriter normalInterpolationWriter(
+		TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + texturecontainer::FILE_EXTENSION,
+		TextureFormat::R32f, width, height);
+	normalInterpolationWriter.Write(normalInterpolationPixels.get(), normalInterpolationPixelsSize);
+	normalInterpolationWriter.Finish();
+	// ^^^ Normal interpolation texture ^^^
 }
 
-void CelestialBodyTextures::InitializeDefaultSampler()
+void CelestialBodyTextures::Update()
 {
-	GL(glCreateSamplers(1, &mDefaultSampler));
-
-	// The default behaviour for the texture wraps is "GL_REPEAT"
-	GL(glSamplerParameteri(mDefaultSampler, GL_TEXTURE_WRAP_S, GL_REPEAT));
-	GL(glSamplerParameteri(mDefaultSampler, GL_TEXTURE_WRAP_T, GL_REPEAT));
+	mVirtualSurfaceTexture->Update();
 }
 
-void CelestialBodyTextures::InitializeAllGlTextures(const PermutationTable<256>& permutationTable)
+void CelestialBodyTextures::Bind() const
 {
-	InitializeNormalInterpolation();
-	InitializeTexture();
-	InitializeCraterSampler();
-	InitializeDefaultSampler();
+	using namespace celestialbodytextures;
+
+	GlStateCache& stateCache = GlStateCache::Get();
+	stateCache.BindTextureUnit(textureunit::SURFACE, mTexture);
+	mCraterTexture->Bind(textureunit::CRATER);
+	mCraterSampler->Bind(textureunit::CRATER);
+	mNormalMap->Bind(textureunit::NORMAL_MAP);
+	mSecondNormalMap->Bind(textureunit::SECOND_NORMAL_MAP);
+	stateCache.BindTextureUnit(textureunit::NORMAL_INTERPOLATION, mNormalInterpolationTexture);
+	mVirtualSurfaceTexture->Bind(textureunit::VIRTUAL_SURFACE_PAGE_TABLE, textureunit::VIRTUAL_SURFACE,
+		VIRTUAL_SURFACE_FEEDBACK_BINDING);
 }
 
-float CelestialBodyTextures::GetFractalPerlinNoise(const PerlinNoise<2>& perlinNoise, 
-	const Vector2& position, const int nOctaves, const float startFrequency, const float startAmplitude) const
+void CelestialBodyTextures::InitializeNormalInterpolation(ThreadPool& threadPool)
 {
-	float frequency = startFrequency;
-	float amplitude = startAmplitude;
-	float maxAmplitude = 0.0f;
-	float perlinValue = 0.0f;
-
-	// For each ocatave incrementation, we want to half the amplitude
-	// and double the frequency
-	for (int i = 0; i < nOctaves; i++, amplitude /= 2.0f, frequency *= 2.0f)
+	// The pixels are uploaded straight from the mapped file
+	const std::unique_ptr<MappedTextureContainer> container = texturecache::LoadWithMipChain(
+		TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + texturecontainer::FILE_EXTENSION, &threadPool);
+	if (container->GetFormat() != TextureFormat::R32f)
 	{
-		// "perlinNoise.Get" returns a value that ranges from 0 to 1. We 
-		// therefore need to multiply by 2, and subtract by 1 to get a value
-		// that ranges from -1 to 1. We then multiply by amplitude to get a 
-		// value that ranges from -amplitude to amplitude.
-		const float localPerlinValue = (perlinNoise.Get(position * frequency) * 2.0f - 1.0f) * amplitude;
-		perlinValue += localPerlinValue;
-
-		// The max amplitude will increase by the amplitude
-		// of the local perlin value
-		maxAmplitude += amplitude;
+		throw CREATE_CUSTOM_EXCEPTION("The normal interpolation texture is expected to have the format R32f");
 	}
 
-	// The perlin value ranges from -maxAmplitude to maxAmplitude. Adding
-	// the max amplitude to the value and then dividing that sum by 2 * the 
-	// max amplitude will make the perlin value range from 0 to 1.
-	return (perlinValue + maxAmplitude) / (2.0f * maxAmplitude);
+	mNormalInterpolationTexture = container->CreateGlTexture();
 }
 
-float CelestialBodyTextures::GetWarpedPerlinNoise(const PerlinNoise<2>& perlinNoise, 
-	const Vector2& position, const int nOctaves, const float frequency,
-	const float amplitude, const float warpAmount) const
+void CelestialBodyTextures::InitializeTexture(ThreadPool& threadPool)
 {
-	// Calculate the position offset using fractal noise
-	Vector2 offset
+	const std::unique_ptr<MappedTextureContainer> container = texturecache::LoadWithMipChain(
+		TEXTURE_PATH + SURFACE_TEXTURE_NAME + texturecontainer::FILE_EXTENSION, &threadPool);
+	if (container->GetFormat() != TextureFormat::Rgba8)
 	{
-		GetFractalPerlinNoise(perlinNoise, position,
-		nOctaves, frequency, amplitude),
-
-		// The noise for the y-offset, is offsetted with (5.2, 1.3), so that 
-		// we will not get the same random values for both coordinates
-		GetFractalPerlinNoise(perlinNoise, position + Vector2(5.2f, 1.3f),
-		nOctaves, frequency, amplitude)
-	};
-
-	// Return a warped noise, i.e., a fractal noise that is 
-	// offsetted with yet another fractal noise
-	return GetFractalPerlinNoise(perlinNoise, position
-			+ offset * warpAmount, nOctaves, frequency, amplitude);
-}
-
-void CelestialBodyTextures::GenerateSurfaceTexture(const int width, const int height,
-	const PerlinNoise<2>& perlinNoise) const
-{
-	// The size of a pixel, in bytes
-	const int pixelSize = 4;
-	auto pixels = std::make_unique<unsigned char[]>(width * height * pixelSize);
-
-	for (int y = 0; y < height; ++y)
-	{
-		for (int x = 0; x < width; ++x)
-		{
-			const float perlinValue = GetWarpedPerlinNoise(perlinNoise,
-				Vector2((float)x, (float)y), 4, 0.01f, 1.0f, 1080.0f);
-
-			const unsigned char grayscaleValue =
-				unsigned char(perlinValue * 255.0f);
-
-			// A pointer to the first byte of the current pixel
-			unsigned char* const startOfPixel = &pixels[y * width * pixelSize + x * pixelSize];
-
-			// The red, green, and blue channels (the first three bytes of the pixel)
-			// should all have the same grayscale value
-			std::fill_n(startOfPixel, 3, grayscaleValue);
-
-			// The fourth byte of the pixel, the alpha channel, should
-			// have the highest value, i.e., 255, since we want the colour
-			// to be fully opaque
-			startOfPixel[3] = 255;
-		}
+		throw CREATE_CUSTOM_EXCEPTION("The surface texture is expected to have the format Rgba8");
 	}
 
-	std::ofstream file;
-	file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-
-	try
-	{
-		// We want to discard the old content, hence "std::ios_base::trunc"
-		file.open(TEXTURE_PATH + SURFACE_TEXTURE_NAME + RAW_FILE_EXTENSION,
-			std::ios_base::binary | std::ios_base::trunc);
-		file << width << " " << height;
-		file.write(reinterpret_cast<const char*>(pixels.get()), width * height * pixelSize);
-	}
-	catch (std::ios_base::failure)
-	{
-		throw CREATE_CUSTOM_EXCEPTION("Failed to open or write to file: "
-			+ TEXTURE_PATH + SURFACE_TEXTURE_NAME + RAW_FILE_EXTENSION);
-	}
+	mTexture = container->CreateGlTexture();
 }
 
-std::unique_ptr<unsigned char[]> CelestialBodyTextures::GetSurfacePixels(int& width, int& height) const
+void CelestialBodyTextures::InitializeCraterSampler()
 {
-	std::ifstream file;
-	file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-
-	try
-	{
-		file.open(TEXTURE_PATH + SURFACE_TEXTURE_NAME + RAW_FILE_EXTENSION,
-			std::ios_base::binary);
-
-		file >> width;
-		file >> height;
-
-		// The size of a pixel, in bytes
-		const int pixelSize = 4;
-		auto pixels = std::make_unique<unsigned char[]>(width * height * pixelSize);
-		file.read(reinterpret_cast<char*>(pixels.get()), width * height * pixelSize);
-
-		return pixels;
-	}
-	catch (std::ios_base::failure)
-	{
-		throw CREATE_CUSTOM_EXCEPTION("Failed to open or read from file: "
-			+ TEXTURE_PATH + SURFACE_TEXTURE_NAME + RAW_FILE_EXTENSION);
-	}
+	SamplerParameters parameters;
+	parameters.wrapS = GL_CLAMP_TO_BORDER;
+	parameters.wrapT = GL_CLAMP_TO_BORDER;
+	// If we, by accident, come outside the texture we want
+	// the colour to be fully transparent
+	parameters.borderColour = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-	return std::unique_ptr<unsigned char[]>();
+	mCraterSampler = AssetCache::Get().GetSampler(parameters);
 }
 
-void CelestialBodyTextures::GenerateNormalInterpolationTexture(
-	const int width, const int height, const PerlinNoise<2>& perlinNoise) const
+void CelestialBodyTextures::InitializeVirtualSurfaceTexture()
 {
-	auto pixels = std::make_unique<float[]>(width * height);
-
-	for (int y = 0; y < height; ++y)
-	{
-		for (int x = 0; x < width; ++x)
+	mPageBaker.emplace(NoiseTableRegistry::Get().GetPermutationTable<256>(NoiseTableRegistry::DEFAULT_SEED));
+	mVirtualSurfaceTexture.emplace([this](const VirtualTexturePageRegion& region)
 		{
-			pixels[y * width + x] = perlinNoise.Get(Vector2((float)x, (float)y) * 0.1f);
-		}
-	}
-	
-	std::ofstream file;
-	file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-
-	try
-	{
-		// We want to discard the old content, hence "std::ios_base::trunc"
-		file.open(TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + RAW_FILE_EXTENSION, 
-			std::ios_base::binary | std::ios_base::trunc);
-		file << width << " " << height;
-		file.write(reinterpret_cast<const char*>(pixels.get()), width * height * sizeof(float));
-	}
-	catch (std::ios_base::failure)
-	{
-		throw CREATE_CUSTOM_EXCEPTION("Failed to open or write to file: " 
-			+ TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + RAW_FILE_EXTENSION);
-	}
+			return mPageBaker->BakeSurfaceRegion(region.x, region.y, region.size, region.size,
+				region.mipLevelSize, region.mipLevelSize);
+		});
 }
 
-std::unique_ptr<float[]> CelestialBodyTextures::GetNormalInterpolationPixels(int& width, int& height) const
+void CelestialBodyTextures::InitializeAllGlTextures(const PermutationTable<256>& permutationTable)
 {
-	std::ifstream file;
-	file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-
-	try
-	{
-		file.open(TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + RAW_FILE_EXTENSION, 
-			std::ios_base::binary);
-
-		file >> width;
-		file >> height;
-
-		auto pixels = std::make_unique<float[]>(width * height);
-		file.read(reinterpret_cast<char*>(pixels.get()), width * height * sizeof(float));
-		
-		return pixels;
-	}
-	catch (std::ios_base::failure)
-	{
-		throw CREATE_CUSTOM_EXCEPTION("Failed to open or read from file: " 
-			+ TEXTURE_PATH + NORMAL_INTERPOLATION_TEXTURE_NAME + RAW_FILE_EXTENSION);
-	}
-
-	return std::unique_ptr<float[]>();
-}
+	// The mip chains of the textures are built in parallel, unless the texture cache already has them
+	ThreadPool threadPool;
+	InitializeNormalInterpolation(threadPool);
+	InitializeTexture(threadPool);
+	InitializeCraterSampler();
+	InitializeVirtualSurfaceTexture();
+}
\ No newline at end of file
@@ -1,5 +1,10 @@
-#include "../Rendering/Texture.h"
+#include "../Rendering/AssetCache.h"
+#include "../Rendering/Program.h"
+#include "../Rendering/PermutationUniformBuffer.h"
+#include "../Rendering/VirtualTexture.h"
+#include "NoiseTextureBaker.h"
 #include "../Noise/PerlinNoise.h"
+#include <optional>
 
 
 namespace celestialbodytextures
@@ -13,6 +18,27 @@ namespace celestialbodytextures
 		// "CelestialBodyTextures"
 		const inline GenerateTexturesFlag generateTextures;
 	}
+
+	// The texture units that the textures are bound to. No other program uses these
+	// units, which lets the textures stay bound between the draws, and between frames.
+	// The bindings inside the celestial body shaders need to match these units. Bindless
+	// textures would do without the units, but unlike the extensions that the renderer
+	// requires, "GL_ARB_bindless_texture" is missing from drivers such as llvmpipe.
+	namespace textureunit
+	{
+		constexpr GLuint SURFACE = 8;
+		constexpr GLuint CRATER = 9;
+		constexpr GLuint NORMAL_MAP = 10;
+		constexpr GLuint SECOND_NORMAL_MAP = 11;
+		constexpr GLuint NORMAL_INTERPOLATION = 12;
+		constexpr GLuint VIRTUAL_SURFACE_PAGE_TABLE = 13;
+		constexpr GLuint VIRTUAL_SURFACE = 14;
+		// Not shared, every celestial body binds its own detail normal map to this unit
+		constexpr GLuint DETAIL_NORMAL_MAP = 15;
+	}
+
+	// The shader storage buffer binding that the virtual surface texture's feedback is written to
+	constexpr GLuint VIRTUAL_SURFACE_FEEDBACK_BINDING = 1;
 }
 
 class CelestialBodyTextures
@@ -30,53 +56,42 @@ public:
 
 	~CelestialBodyTextures();
 
-	// Methods that bind the various textures to the wanted locations
-	void BindTexture(GLuint location) const;
-	void BindNormalMaps(GLuint location0, GLuint location1) const;
-	void BindNormalInterpolation(GLuint location) const;
-	void BindCraterTexture(GLuint location) const;
-	void BindCraterSampler(GLuint location) const;
-	void BindDefaultSampler(GLuint location) const;
+	// Regenerates the noise textures with a compute shader, directly into the textures that
+	// get bound, at the given resolution. Nothing is written to disk, unless "SaveNoiseTextures"
+	// gets called.
+	void GenerateNoiseTexturesOnGpu(int width, int height);
+
+	// Reads the noise textures back from the GPU and writes them to the texture
+	// containers, which the first constructor reads the textures from
+	void SaveNoiseTextures() const;
+
+	// Keeps the virtual surface texture up to date with what the previous frames
+	// have seen. Needs to be called once per frame, before the frame is rendered.
+	void Update();
+
+	// Binds all the textures, and the crater sampler, to their units inside
+	// "celestialbodytextures::textureunit". Only needs to be called once per frame,
+	// since the textures get replaced when they finish loading, or get regenerated.
+	void Bind() const;
 private:
-	void InitializeNormalInterpolation();
-	void InitializeTexture();
+	void InitializeNormalInterpolation(ThreadPool& threadPool);
+	void InitializeTexture(ThreadPool& threadPool);
 	void InitializeCraterSampler();
-	void InitializeDefaultSampler();
+	void InitializeVirtualSurfaceTexture();
 	void InitializeAllGlTextures(const PermutationTable<256>& permutationTable);
-
-	float GetFractalPerlinNoise(const PerlinNoise<2>& perlinNoise, const Vector2& position,
-		const int nOctaves, const float startFrequency, const float startAmplitude) const;
-	float GetWarpedPerlinNoise(const PerlinNoise<2>& perlinNoise,
-		const Vector2& position, const int nOctaves, const float frequency,
-		const float amplitude, const float warpAmount) const;
-
-	// Generates a raw surface texture for the celestial 
-	// body, using a warped perlin noise, and writes it to
-	// the texture folder
-	void GenerateSurfaceTexture(int width, int height,
-		const PerlinNoise<2>& perlinNoise) const;
-	std::unique_ptr<unsigned char[]> GetSurfacePixels(int& width, int& height) const;
-
-	// Generates a raw normal interpolation texture, 
-	// using perlin noise, and writes it to the 
-	// texture folder
-	void GenerateNormalInterpolationTexture(int width, int height,
-		const PerlinNoise<2>& perlinNoise) const;
-
-	std::unique_ptr<float[]> GetNormalInterpolationPixels(int& width, int& height) const;
 private:
 	// A texture that could be applied to the
 	// craters of the celestial body
-	Texture mCraterTexture;
+	std::shared_ptr<const Texture> mCraterTexture;
 	
 	// A normal map that should be applied
 	// to the surface of the celestial body
-	Texture mNormalMap;
+	std::shared_ptr<const Texture> mNormalMap;
 
 	// A second normal map that should be applied
 	// (in combination with the above normal map)
 	// to the surface of the celestial body
-	Texture mSecondNormalMap;
+	std::shared_ptr<const Texture> mSecondNormalMap;
 
 	// The surface texture for the celestial body
 	GLuint mTexture = 0;
@@ -86,16 +101,26 @@ private:
 	// two normal maps
 	GLuint mNormalInterpolationTexture = 0;
 
+	// A high resolution version of the surface texture, of which only the visible pages
+	// are baked, by "mPageBaker", and kept in video memory. The shader falls back to the
+	// surface texture wherever the pages have not been baked yet.
+	std::optional<NoiseTextureBaker> mPageBaker;
+	std::optional<VirtualTexture> mVirtualSurfaceTexture;
+
 	// A sampler that should be bound in combination with the
-	// the crater texture
-	GLuint mCraterSampler = 0;
+	// the crater texture. It stays bound to the crater's unit.
+	std::shared_ptr<const Sampler> mCraterSampler;
 
-	// A sampler that should be bound when we no longer
-	// want to use the crater sampler
-	GLuint mDefaultSampler = 0;
+	// The compute shader that generates the noise textures, and the permutation table
+	// that its perlin noise uses. These are initialized the first time that the textures
+	// are generated on the GPU.
+	std::optional<Program> mTextureGeneratorProgram;
+	std::shared_ptr<const PermutationUniformBuffer> mPermutationUniformBuffer;
 
 	static const inline std::string TEXTURE_PATH = "Source/Textures/";
-	static const inline std::string RAW_FILE_EXTENSION = ".raw";
 	static const inline std::string NORMAL_INTERPOLATION_TEXTURE_NAME = "NormalInterpolation";
 	static const inline std::string SURFACE_TEXTURE_NAME = "SurfaceTexture";
+
+	// The width and height of the generated noise textures
+	static constexpr int GENERATED_TEXTURE_SIZE = 255;
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "FaceGridNoise.h"
+
+int FaceGrid::GetSideLengthInPoints() const
+{
+	// A side of n cells has n + 1 points
+	return sideLengthInCells + 1;
+}
+
+Vector3 FaceGrid::GetPoint(const int x, const int y) const
+{
+	Vector3 point = lowerLeftCornerOfFace;
+	point += tangent * (cellSideLength * (float)x) + binormal * (cellSideLength * (float)y);
+	point.Normalize();
+	return point;
+}
+
+FaceGridNoise::FaceGridNoise(const std::shared_ptr<const PermutationTable<256>> permutationTable)
+	:
+	mPerlinNoise(permutationTable)
+{
+}
+
+std::vector<float> FaceGridNoise::GetFractalNoise(const FaceGrid& grid, const int nOctaves,
+	const float startFrequency, const bool useCellCache, PerlinNoise<3>::CellCacheStatistics& statistics) const
+{
+	const int sideLength = grid.GetSideLengthInPoints();
+	std::vector<float> noise((size_t)sideLength * sideLength);
+
+	// The coordinates of the points of the current tile, as a structure of arrays
+	std::array<std::vector<float>, 3> tilePoints;
+	// The same coordinates, multiplied by the frequency of the current octave
+	std::array<std::vector<float>, 3> scaledTilePoints;
+	std::vector<float> octaveValues;
+	std::vector<float> tileNoise;
+
+	for (int tileY = 0; tileY < sideLength; tileY += TILE_SIZE)
+	{
+		for (int tileX = 0; tileX < sideLength; tileX += TILE_SIZE)
+		{
+			const int tileWidth = std::min(TILE_SIZE, sideLength - tileX);
+			const int tileHeight = std::min(TILE_SIZE, sideLength - tileY);
+			const size_t nPoints = (size_t)tileWidth * tileHeight;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				tilePoints[i].resize(nPoints);
+				scaledTilePoints[i].resize(nPoints);
+			}
+			octaveValues.resize(nPoints);
+			tileNoise.assign(nPoints, 0.0f);
+
+			for (int y = 0, j = 0; y < tileHeight; ++y)
+			{
+				for (int x = 0; x < tileWidth; ++x, ++j)
+				{
+					const Vector3 point = grid.GetPoint(tileX + x, tileY + y);
+					for (int i = 0; i < 3; ++i)
+					{
+						tilePoints[i][j] = point[i];
+					}
+				}
+			}
+
+			float amplitude = 1.0f;
+			float frequency = startFrequency;
+			float maxAmplitude = 0.0f;
+
+			// For each ocatave incrementation, we want to half the amplitude
+			// and double the frequency
+			for (int octave = 0; octave < nOctaves; ++octave, amplitude /= 2.0f, frequency *= 2.0f)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					std::transform(tilePoints[i].begin(), tilePoints[i].end(), scaledTilePoints[i].begin(),
+						[frequency](float value)
+						{
+							return value * frequency;
+						});
+				}
+
+				const std::array<const float*, 3> coordinates =
+					{ scaledTilePoints[0].data(), scaledTilePoints[1].data(), scaledTilePoints[2].data() };
+
+				// The cache only lives for one octave of one tile, since a cell of one
+				// octave has nothing in common with the cells of the other octaves
+				if (useCellCache)
+				{
+					mPerlinNoise.GetUsingCellCache(coordinates, octaveValues.data(), nPoints, statistics);
+				}
+				else
+				{
+					mPerlinNoise.Get(coordinates, octaveValues.data(), nPoints);
+				}
+
+				for (size_t j = 0; j < nPoints; ++j)
+				{
+					// The perlin noise ranges from 0 to 1. We make it range
+					// from -amplitude to amplitude before accumulating it.
+					tileNoise[j] += (octaveValues[j] * 2.0f - 1.0f) * amplitude;
+				}
+
+				// The max amplitude will increase by the amplitude
+				// of the local perlin value
+				maxAmplitude += amplitude;
+			}
+
+			// Make the noise range from 0 to 1 and copy it into its place in the grid
+			for (int y = 0, j = 0; y < tileHeight; ++y)
+			{
+				for (int x = 0; x < tileWidth; ++x, ++j)
+				{
+					noise[(size_t)(tileY + y) * sideLength + tileX + x] =
+						(tileNoise[j] + maxAmplitude) / (2.0f * maxAmplitude);
+				}
+			}
+		}
+	}
+
+	return noise;
+}
\ No newline at end of file
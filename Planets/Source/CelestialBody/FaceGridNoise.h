@@ -0,0 +1,45 @@
+#pragma once
+#include "../Noise/PerlinNoise.h"
+
+// The grid of points that makes up one face of the cube, which gets projected on to a
+// sphere. These are the same points as the corners of the cells that
+// "CelestialBody::GetFaceVertices" creates.
+struct FaceGrid
+{
+	Vector3 lowerLeftCornerOfFace;
+	Vector3 tangent;
+	Vector3 binormal;
+
+	// The length of a cell
+	float cellSideLength = 0.0f;
+
+	// The length of the face's sides, in amount of cells
+	int sideLengthInCells = 0;
+
+	// The amount of points along each side
+	int GetSideLengthInPoints() const;
+
+	// Returns the point at ("x", "y"), projected on to a sphere with a radius of 1
+	Vector3 GetPoint(int x, int y) const;
+};
+
+// Evaluates fractal perlin noise at all the points of a face grid. The grid is walked
+// tile by tile, so that neighbouring points get evaluated after each other, which lets
+// the perlin noise reuse the hashed corners of the lattice cells (see
+// "PerlinNoise::GetUsingCellCache").
+class FaceGridNoise
+{
+public:
+	FaceGridNoise(const std::shared_ptr<const PermutationTable<256>> permutationTable);
+
+	// Returns the noise, ranging from 0 to 1, of every point of the grid, stored row by row.
+	// "useCellCache" decides whether the lattice cells get cached. Only when they are,
+	// "statistics" gets updated.
+	std::vector<float> GetFractalNoise(const FaceGrid& grid, int nOctaves, float startFrequency,
+		bool useCellCache, PerlinNoise<3>::CellCacheStatistics& statistics) const;
+private:
+	PerlinNoise<3> mPerlinNoise;
+
+	// The side length, in points, of the tiles
+	static constexpr int TILE_SIZE = 16;
+};
\ No newline at end of file
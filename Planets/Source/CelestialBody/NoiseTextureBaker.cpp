@@ -0,0 +1,312 @@
+#include "NoiseTextureBaker.h"
+#include "../Timer.h"
+#include "../CustomException.h"
+#include "../Console/Log.h"
+#include "../Rendering/TextureContainer.h"
+#include <algorithm>
+
+double BakeStatistics::GetMegapixelsPerSecond() const
+{
+	return ((double)width * (double)height / 1e+6) / seconds;
+}
+
+NoiseTextureBaker::NoiseTextureBaker(const std::shared_ptr<const PermutationTable<256>> permutationTable,
+	const unsigned int nThreads)
+	:
+	mPerlinNoise(permutationTable),
+	mThreadPool(nThreads)
+{
+}
+
+BakeStatistics NoiseTextureBaker::BakeSurfaceTexture(const int width, const int height, const std::string& filePath)
+{
+	// The noise is sampled in the coordinate space of the reference size,
+	// so that the pattern does not change with the resolution
+	const float xScale = (float)REFERENCE_SIZE / (float)width;
+	const float yScale = (float)REFERENCE_SIZE / (float)height;
+
+	return Bake<unsigned char>(width, height, TextureFormat::Rgba8, filePath,
+		[this, xScale, yScale](const Tile& tile, unsigned char* pixels, int rowStride)
+		{
+			BakeSurfaceTile(tile, xScale, yScale, SURFACE_OCTAVES, pixels, rowStride);
+		});
+}
+
+std::future<std::vector<unsigned char>> NoiseTextureBaker::BakeSurfaceRegion(const int x, const int y,
+	const int regionWidth, const int regionHeight, const int width, const int height)
+{
+	const float xScale = (float)REFERENCE_SIZE / (float)width;
+	const float yScale = (float)REFERENCE_SIZE / (float)height;
+
+	// Every doubling of the resolution gets an octave of twice the frequency, which
+	// keeps the finest octave at about the same size, measured in pixels
+	int nOctaves = SURFACE_OCTAVES;
+	for (int size = REFERENCE_SIZE * 2; size <= std::max(width, height); size *= 2)
+	{
+		++nOctaves;
+	}
+
+	return mThreadPool.Submit([this, x, y, regionWidth, regionHeight, xScale, yScale, nOctaves]()
+		{
+			std::vector<unsigned char> pixels((size_t)regionWidth * regionHeight * 4);
+			BakeSurfaceTile(Tile{ x, y, regionWidth, regionHeight }, xScale, yScale, nOctaves,
+				pixels.data(), regionWidth * 4);
+			return pixels;
+		});
+}
+
+BakeStatistics NoiseTextureBaker::BakeNormalInterpolationTexture(const int width, const int height,
+	const std::string& filePath)
+{
+	const float xScale = (float)REFERENCE_SIZE / (float)width;
+	const float yScale = (float)REFERENCE_SIZE / (float)height;
+
+	return Bake<float>(width, height, TextureFormat::R32f, filePath,
+		[this, xScale, yScale](const Tile& tile, float* pixels, int rowStride)
+		{
+			BakeNormalInterpolationTile(tile, xScale, yScale, pixels, rowStride);
+		});
+}
+
+void NoiseTextureBaker::LogThroughput(const std::shared_ptr<const PermutationTable<256>> permutationTable,
+	const int width, const int height, const std::string& surfaceFilePath,
+	const std::string& normalInterpolationFilePath)
+{
+	const unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned int nThreads = 1; ; nThreads = std::min(nThreads * 2, maxThreads))
+	{
+		NoiseTextureBaker baker(permutationTable, nThreads);
+
+		const BakeStatistics surfaceStatistics = baker.BakeSurfaceTexture(width, height, surfaceFilePath);
+		const BakeStatistics normalInterpolationStatistics =
+			baker.BakeNormalInterpolationTexture(width, height, normalInterpolationFilePath);
+
+		LOG("Baked " << width << "x" << height << " textures using " << nThreads << " thread(s)" << std::endl
+			<< "Surface: " << surfaceStatistics.GetMegapixelsPerSecond() << " MP/s" << std::endl
+			<< "Normal interpolation: " << normalInterpolationStatistics.GetMegapixelsPerSecond() << " MP/s"
+			<< std::endl);
+
+		if (nThreads == maxThreads)
+		{
+			return;
+		}
+	}
+}
+
+template<class T, class TileFunction>
+BakeStatistics NoiseTextureBaker::Bake(const int width, const int height, const TextureFormat format,
+	const std::string& filePath, const TileFunction& tileFunction)
+{
+	if (width < 1 || height < 1 || width > MAX_SIZE || height > MAX_SIZE)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not bake a texture with the size " + std::to_string(width) + "x"
+			+ std::to_string(height) + ". The maximum size is " + std::to_string(MAX_SIZE) + "x"
+			+ std::to_string(MAX_SIZE));
+	}
+
+	Timer timer;
+	// Start the timer
+	timer.Time();
+
+	// The amount of elements of type "T" per pixel
+	const int nChannels = (int)(textureformat::GetImageSize(format, 1, 1) / sizeof(T));
+
+	TextureContainerWriter writer(filePath, format, width, height);
+
+	// A band is one row of tiles. We use two bands, so that one band can
+	// get written to the file while the next one is being evaluated.
+	const size_t bandSize = (size_t)width * TILE_SIZE * nChannels;
+	std::vector<T> bands[2] = { std::vector<T>(bandSize), std::vector<T>(bandSize) };
+	std::future<void> pendingWrite;
+
+	for (int bandY = 0, bandIndex = 0; bandY < height; bandY += TILE_SIZE, bandIndex ^= 1)
+	{
+		std::vector<T>& band = bands[bandIndex];
+		const int bandHeight = std::min(TILE_SIZE, height - bandY);
+
+		// Evaluate all the tiles of the band in parallel
+		std::vector<std::future<void>> tileFutures;
+		for (int tileX = 0; tileX < width; tileX += TILE_SIZE)
+		{
+			const Tile tile{ tileX, bandY, std::min(TILE_SIZE, width - tileX), bandHeight };
+			T* const firstPixelOfTile = &band[(size_t)tileX * nChannels];
+
+			tileFutures.push_back(mThreadPool.Submit(
+				[&tileFunction, tile, firstPixelOfTile, rowStride = width * nChannels]()
+				{
+					tileFunction(tile, firstPixelOfTile, rowStride);
+				}));
+		}
+		std::for_each(tileFutures.begin(), tileFutures.end(),
+			[](std::future<void>& future)
+			{
+				future.get();
+			});
+
+		// The previous band has to be written before we start writing this band, since
+		// the rows need to end up in order. This also guarantees that the other band is
+		// free to be reused during the next iteration.
+		if (pendingWrite.valid())
+		{
+			pendingWrite.get();
+		}
+
+		pendingWrite = std::async(std::launch::async,
+			[&writer, &band, bandSize = (size_t)width * bandHeight * nChannels]()
+			{
+				writer.Write(band.data(), bandSize * sizeof(T));
+			});
+	}
+
+	if (pendingWrite.valid())
+	{
+		pendingWrite.get();
+	}
+	writer.Finish();
+
+	return BakeStatistics{ width, height, mThreadPool.GetThreadCount(), timer.Time() };
+}
+
+void NoiseTextureBaker::BakeSurfaceTile(const Tile& tile, const float xScale, const float yScale,
+	const int nOctaves, unsigned char* const pixels, const int rowStride) const
+{
+	const size_t nPixels = (size_t)tile.width * tile.height;
+
+	std::vector<float> xs(nPixels);
+	std::vector<float> ys(nPixels);
+	for (int y = 0, i = 0; y < tile.height; ++y)
+	{
+		for (int x = 0; x < tile.width; ++x, ++i)
+		{
+			xs[i] = (float)(tile.x + x) * xScale;
+			ys[i] = (float)(tile.y + y) * yScale;
+		}
+	}
+
+	std::vector<float> perlinValues(nPixels);
+	GetWarpedPerlinNoise(xs.data(), ys.data(), nPixels, nOctaves, 0.01f, 1.0f, 1080.0f, perlinValues.data());
+
+	// The size of a pixel, in bytes
+	const int pixelSize = 4;
+	for (int y = 0, i = 0; y < tile.height; ++y)
+	{
+		for (int x = 0; x < tile.width; ++x, ++i)
+		{
+			const unsigned char grayscaleValue = (unsigned char)(perlinValues[i] * 255.0f);
+
+			// A pointer to the first byte of the current pixel
+			unsigned char* const startOfPixel = &pixels[(size_t)y * rowStride + (size_t)x * pixelSize];
+
+			// The red, green, and blue channels (the first three bytes of the pixel)
+			// should all have the same grayscale value
+			std::fill_n(startOfPixel, 3, grayscaleValue);
+
+			// The fourth byte of the pixel, the alpha channel, should
+			// have the highest value, i.e., 255, since we want the colour
+			// to be fully opaque
+			startOfPixel[3] = 255;
+		}
+	}
+}
+
+void NoiseTextureBaker::BakeNormalInterpolationTile(const Tile& tile, const float xScale, const float yScale,
+	float* const pixels, const int rowStride) const
+{
+	const size_t nPixels = (size_t)tile.width * tile.height;
+
+	std::vector<float> xs(nPixels);
+	std::vector<float> ys(nPixels);
+	for (int y = 0, i = 0; y < tile.height; ++y)
+	{
+		for (int x = 0; x < tile.width; ++x, ++i)
+		{
+			xs[i] = (float)(tile.x + x) * xScale * 0.1f;
+			ys[i] = (float)(tile.y + y) * yScale * 0.1f;
+		}
+	}
+
+	std::vector<float> perlinValues(nPixels);
+	mPerlinNoise.Get({ xs.data(), ys.data() }, perlinValues.data(), nPixels);
+
+	for (int y = 0, i = 0; y < tile.height; ++y)
+	{
+		std::copy_n(&perlinValues[i], tile.width, &pixels[(size_t)y * rowStride]);
+		i += tile.width;
+	}
+}
+
+void NoiseTextureBaker::GetFractalPerlinNoise(const float* const xs, const float* const ys, const size_t count,
+	const int nOctaves, const float startFrequency, const float startAmplitude, float* const output) const
+{
+	float frequency = startFrequency;
+	float amplitude = startAmplitude;
+	float maxAmplitude = 0.0f;
+
+	std::fill_n(output, count, 0.0f);
+
+	std::vector<float> scaledXs(count);
+	std::vector<float> scaledYs(count);
+	std::vector<float> octaveValues(count);
+
+	// For each ocatave incrementation, we want to half the amplitude
+	// and double the frequency
+	for (int i = 0; i < nOctaves; i++, amplitude /= 2.0f, frequency *= 2.0f)
+	{
+		for (size_t j = 0; j < count; ++j)
+		{
+			scaledXs[j] = xs[j] * frequency;
+			scaledYs[j] = ys[j] * frequency;
+		}
+		mPerlinNoise.Get({ scaledXs.data(), scaledYs.data() }, octaveValues.data(), count);
+
+		for (size_t j = 0; j < count; ++j)
+		{
+			// The perlin noise ranges from 0 to 1. We make it range
+			// from -amplitude to amplitude before accumulating it.
+			output[j] += (octaveValues[j] * 2.0f - 1.0f) * amplitude;
+		}
+
+		// The max amplitude will increase by the amplitude
+		// of the local perlin value
+		maxAmplitude += amplitude;
+	}
+
+	// The perlin value ranges from -maxAmplitude to maxAmplitude. Adding
+	// the max amplitude to the value and then dividing that sum by 2 * the
+	// max amplitude will make the perlin value range from 0 to 1.
+	for (size_t j = 0; j < count; ++j)
+	{
+		output[j] = (output[j] + maxAmplitude) / (2.0f * maxAmplitude);
+	}
+}
+
+void NoiseTextureBaker::GetWarpedPerlinNoise(const float* const xs, const float* const ys, const size_t count,
+	const int nOctaves, const float frequency, const float amplitude, const float warpAmount,
+	float* const output) const
+{
+	// Calculate the position offsets using fractal noise
+	std::vector<float> xOffsets(count);
+	std::vector<float> yOffsets(count);
+	GetFractalPerlinNoise(xs, ys, count, nOctaves, frequency, amplitude, xOffsets.data());
+
+	// The noise for the y-offset, is offsetted with (5.2, 1.3), so that
+	// we will not get the same random values for both coordinates
+	std::vector<float> shiftedXs(count);
+	std::vector<float> shiftedYs(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		shiftedXs[i] = xs[i] + 5.2f;
+		shiftedYs[i] = ys[i] + 1.3f;
+	}
+	GetFractalPerlinNoise(shiftedXs.data(), shiftedYs.data(), count, nOctaves, frequency, amplitude, yOffsets.data());
+
+	// Return a warped noise, i.e., a fractal noise that is
+	// offsetted with yet another fractal noise
+	for (size_t i = 0; i < count; ++i)
+	{
+		shiftedXs[i] = xs[i] + xOffsets[i] * warpAmount;
+		shiftedYs[i] = ys[i] + yOffsets[i] * warpAmount;
+	}
+	GetFractalPerlinNoise(shiftedXs.data(), shiftedYs.data(), count, nOctaves, frequency, amplitude, output);
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+#include "../Noise/PerlinNoise.h"
+#include "../Threading/ThreadPool.h"
+#include "../Rendering/TextureContainer.h"
+
+// When enabled, generating new celestial body textures also bakes them once per
+// thread count and logs the throughput (in megapixels per second) of every run
+#define LOG_BAKING_THROUGHPUT 0
+
+struct BakeStatistics
+{
+	int width = 0;
+	int height = 0;
+	unsigned int nThreads = 0;
+	double seconds = 0.0;
+
+	double GetMegapixelsPerSecond() const;
+};
+
+// Bakes the procedurally generated textures of the celestial bodies. The image is
+// split into square tiles that get evaluated in parallel on a thread pool, using the
+// batched noise kernel. Each finished row of tiles is streamed to the output file while
+// the next row is being evaluated, so the memory usage is bounded by two rows of tiles,
+// regardless of the resolution.
+class NoiseTextureBaker
+{
+public:
+	// When "nThreads" is 0, one thread per hardware thread is used
+	NoiseTextureBaker(const std::shared_ptr<const PermutationTable<256>> permutationTable, unsigned int nThreads = 0);
+
+	// Bakes a grayscale, warped perlin noise, RGBA texture and writes it to "filePath"
+	BakeStatistics BakeSurfaceTexture(int width, int height, const std::string& filePath);
+	// Bakes a single channel, floating-point, perlin noise texture and writes it to "filePath"
+	BakeStatistics BakeNormalInterpolationTexture(int width, int height, const std::string& filePath);
+
+	// Thread-safe. Queues the baking of a "regionWidth" x "regionHeight" region of a surface texture
+	// with the resolution "width" x "height", whose first pixel is at ("x", "y"), on the thread pool.
+	// The region may reach outside the texture. Resolutions above the reference size get additional
+	// octaves, so that the extra pixels add detail, instead of only magnifying the pattern.
+	std::future<std::vector<unsigned char>> BakeSurfaceRegion(int x, int y, int regionWidth, int regionHeight,
+		int width, int height);
+
+	// Bakes both textures once for every power of two thread count (up to the amount of
+	// hardware threads), and logs how many megapixels per second every run achieved
+	static void LogThroughput(const std::shared_ptr<const PermutationTable<256>> permutationTable,
+		int width, int height, const std::string& surfaceFilePath, const std::string& normalInterpolationFilePath);
+
+	// The highest supported resolution, along each axis
+	static constexpr int MAX_SIZE = 8192;
+
+	// The resolution that the noise parameters were chosen for. Textures with
+	// any other resolution show the same pattern, only sampled more or less densely.
+	static constexpr int REFERENCE_SIZE = 255;
+private:
+	struct Tile
+	{
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	// Splits the image into tiles, evaluates them on the thread pool with "tileFunction" and
+	// streams the result, as a texture container, to "filePath". "tileFunction" gets called as
+	// tileFunction(tile, firstPixelOfTile, rowStride), where "rowStride" is in elements.
+	template<class T, class TileFunction>
+	BakeStatistics Bake(int width, int height, TextureFormat format,
+		const std::string& filePath, const TileFunction& tileFunction);
+
+	void BakeSurfaceTile(const Tile& tile, float xScale, float yScale, int nOctaves,
+		unsigned char* pixels, int rowStride) const;
+	void BakeNormalInterpolationTile(const Tile& tile, float xScale, float yScale,
+		float* pixels, int rowStride) const;
+
+	// Batched versions of the fractal and warped perlin noise, which evaluate the noise
+	// at the "count" positions ("xs[i]", "ys[i]") and store the results in "output"
+	void GetFractalPerlinNoise(const float* xs, const float* ys, size_t count, int nOctaves,
+		float startFrequency, float startAmplitude, float* output) const;
+	void GetWarpedPerlinNoise(const float* xs, const float* ys, size_t count, int nOctaves,
+		float frequency, float amplitude, float warpAmount, float* output) const;
+private:
+	PerlinNoise<2> mPerlinNoise;
+	ThreadPool mThreadPool;
+
+	// The side length, in pixels, of the tiles
+	static constexpr int TILE_SIZE = 64;
+
+	// The number of octaves of the surface texture, at the reference size
+	static constexpr int SURFACE_OCTAVES = 4;
+};
\ No newline at end of file
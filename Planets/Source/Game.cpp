@@ -2,15 +2,22 @@
 #include "Benchmark/BenchmarkMacros.h"
 #include "Rendering/GlMacro.h"
 #include "Console/Log.h"
+#include "Noise/NoiseTableRegistry.h"
 #include "Configure.h"
 
 using namespace std::literals::string_literals;
-Game::Game()
+Game::Game(const std::optional<HeadlessBenchmark::Settings>& headlessSettings)
     :
-    mWindow("Planets"s + " " + VERSION_STRING, 640, 480),
+    mWindow("Planets"s + " " + VERSION_STRING,
+        headlessSettings ? headlessSettings->width : 640,
+        headlessSettings ? headlessSettings->height : 480,
+        headlessSettings.has_value(),
+        headlessSettings ? headlessSettings->contextCreationApi : GLFW_NATIVE_CONTEXT_API),
     mKeyboard(mWindow),
-    mProjectionMatrix(matrix::GetProjection(ConvertDegreesToRadians(60.0f), 0.1f, 200.0f)),
-    mPostProcessor(std::bind(&Game::RenderWithPostProcessingEffect, this)),
+    mFrameConstants(ConvertDegreesToRadians(60.0f), 0.1f, 200.0f),
+    // Further per-pixel effects, added after the ocean, get fused into the ocean's pass
+    mPostProcessor(std::bind(&Game::RenderWithPostProcessingEffect, this), CreatePostProcessingEffects(),
+        { "OceanEffect" }),
     mMoonTextureRenderingProgram(std::make_shared<Program>("MoonTexture")),
     mMoonColourRenderingProgram(std::make_shared<Program>("MoonColour")),
     mPlanetRenderingProgram(std::make_shared<Program>("Planet")),
@@ -31,82 +38,66 @@ Game::Game()
 
     SetGlStates();
 
-    mPostProcessor.AddEffect("NoEffect", PostProcessingEffect(Program("NoEffect"), 
-        [](GLuint colourTexture, GLuint depthTexture)
+    if (headlessSettings)
+    {
+        mHeadlessBenchmark.emplace(*headlessSettings);
+        if (headlessSettings->sweepsMeshResolutions)
         {
-            GL(glBindTextureUnit(0, colourTexture));
-            GL(glBindTextureUnit(1, depthTexture));
-        }));
+            LOG("Mesh resolution sweep, with all the frames of the headless benchmark per resolution."
+                << " The errors are the mean and the max distances, in model space, between the meshes"
+                << " and the terrain (textured moon, asteroid moon, planet)" << std::endl);
+            StartReportingMeshResolution(0);
+        }
+    }
+    else
+    {
+        mDynamicResolution.emplace(TARGET_GPU_FRAME_TIME);
+    }
+
+    // Start the timer
+    mTimer.Time();
+}
+
+Game::~Game()
+{
+    // Destructors should not throw exception, hence no GL macro
+    glDeleteVertexArrays(1, &mVao);
+    GlStateCache::ForgetVertexArray(mVao);
+    mAssetCache.LogStatistics();
+    // Where the startup time of the programs went
+    Program::LogStatistics();
+    // Nobody is there to answer whether the benchmark should be saved, when running headless
+    if (!mHeadlessBenchmark)
+    {
+        SAVE_BENCHMARK;
+    }
+}
+
+std::unordered_map<std::string, PostProcessingEffect> Game::CreatePostProcessingEffects()
+{
+    std::unordered_map<std::string, PostProcessingEffect> effects;
+
+    // The post processor binds the colour and the depth textures
+    // to the texture units 0 and 1, before preparing an effect
+    effects.emplace("NoEffect", PostProcessingEffect(Program("NoEffect"), 
+        [](GLuint, GLuint) {}));
 
-    mPostProcessor.AddEffect("OceanEffect", PostProcessingEffect(Program("OceanEffect"),
+    effects.emplace("OceanEffect", PostProcessingEffect::CreatePerPixel("OceanEffect",
         [
             this,
-            // In order to make the normal map copyable,
-            // we need to store it as a "std::shared_ptr"
-            normalMap = std::make_shared<Texture>("WaterNormal"), 
-            perlinNoise = PerlinNoise<2>(std::make_shared<PermutationTable<256>>())
+            // The normal map is shared through the asset cache,
+            // which also makes the lambda copyable
+            normalMap = mAssetCache.GetTexture("WaterNormal", TextureKind::NormalMap), 
+            perlinNoise = PerlinNoise<2>(
+                NoiseTableRegistry::Get().GetPermutationTable<256>(NoiseTableRegistry::DEFAULT_SEED))
         ]
-        (GLuint colourTexture, GLuint depthTexture)
+        (GLuint, GLuint)
         {
-            GL(glBindTextureUnit(0, colourTexture));
-            GL(glBindTextureUnit(1, depthTexture));
-      
             normalMap->Bind(2);
 
-            // Calculate the projection matrix parameters. These will be used
-            // for reverting the projection matrix's transformation, in order
-            // to get the pixel's screen position back into its world
-            // position. Calculating the parameters here, in this way, is bad
-            // for multiple reasons:
-            // 1) These parameters need to match the parameters used when constructing
-            // "mProjectionMatrix". If we later change, for example, the near value used
-            // for constructing the projection matrix, the parameters will not match and
-            // we will get incorrect results.
-            // 2) We are calculating the parameters every frame, when we only need to do
-            // the calculation at the start of the program (at the moment, the parameters
-            // do not change after they have been initialized, since we are not yet supporting
-            // window resizing.
-            // 3) Duplication of code (code that does the same calculations can be found inside
-            // the function "matrix::GetProjection").
-            // Due to all these issues, the below provisional code block will likely change 
-            // in the future.
-            const float near = 0.1f;
-            const float far = 200.0f;
-
-            const float top = (float)tan(ConvertDegreesToRadians(60.0f) / 2.0) * near;
-            const float bottom = -top;
-            const float aspectRatio = (float)Window::GetWidth() / (float)Window::GetHeight();
-            const float right = aspectRatio * top;
-            const float left = -right;
-            // ^^^ Calculation of projection matrix parameters ^^^
-
-            GL(glUniform1f(0, near));
-            GL(glUniform1f(1, far));
-            GL(glUniform1f(2, left));
-            GL(glUniform1f(3, right));
-            GL(glUniform1f(4, top));
-            GL(glUniform1f(5, bottom));
-
-
+            // The view and the projection are read from the frame constants
             GL(glUniform1f(6, mPlanet.GetRadius()));
-
-            Matrix3 viewRotation = matrix::GetRotation(-mCamera.GetXRotation(), -mCamera.GetYRotation(), 0.0f);
-            // The view rotation matrix and the inverse of the view rotation matrix,
-            // both need to be 4x4 matrices, since that is how the shader wants them
-            Matrix4 viewRotationMatrix4 = Matrix4(viewRotation);
-            std::optional<Matrix4> viewRotationInverseMatrix4 = viewRotationMatrix4.GetInverse();
-
-            // The position of the planet, as seen from the camera
-            Vector3 planetViewPosition = mPlanet.GetPosition();
-            planetViewPosition -= mCamera.GetPosition();
-            planetViewPosition = viewRotation * planetViewPosition;
-
-            GL(glUniform3fv(7, 1, planetViewPosition.GetPointerToData()));
-            GL(glUniformMatrix4fv(8, 1, GL_FALSE, viewRotationMatrix4.GetPointerToData()));
-
-            // Make sure that the inversion succeeded
-            assert(viewRotationInverseMatrix4);
-            GL(glUniformMatrix4fv(9, 1, GL_FALSE, viewRotationInverseMatrix4->GetPointerToData()));
+            GL(glUniform3fv(7, 1, mPlanet.GetPosition().GetPointerToData()));
 
             // vvv Normal map rotation calculation vvv
 
@@ -154,17 +145,17 @@ Game::Game()
 
            GL(glUniformMatrix3fv(10, 1, GL_FALSE, normalMapRotation0.GetPointerToData()));
            GL(glUniformMatrix3fv(11, 1, GL_FALSE, normalMapRotation1.GetPointerToData()));
+        },
+        // The ocean can only cover the pixels that the planet covers
+        [this]()
+        {
+            const Vector3 viewPosition =
+                mFrameConstants.GetViewRotation() * (mPlanet.GetPosition() - mCamera.GetPosition());
+            return ScreenRectangle::GetSphereBounds(viewPosition, mPlanet.GetRadius(),
+                mFrameConstants.GetProjection(), mFrameConstants.GetNear());
         }));
 
-    // Start the timer
-    mTimer.Time();
-}
-
-Game::~Game()
-{
-    // Destructors should not throw exception, hence no GL macro
-    glDeleteVertexArrays(1, &mVao);
-    SAVE_BENCHMARK;
+    return effects;
 }
 
 void Game::BeginLoop()
@@ -180,13 +171,66 @@ void Game::Loop()
 {
     BENCHMARK;
 
+    if (mHeadlessBenchmark)
+    {
+        mHeadlessBenchmark->BeginFrame();
+    }
+    if (mDynamicResolution)
+    {
+        mDynamicResolution->BeginFrame();
+    }
+
     GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 
+    // Upload the textures that have finished decoding since the last frame
+    mTextureLoader.Update();
+    // The uploads above might have pushed the textures over the video memory budget
+    mAssetCache.Update();
+
     Update();
     Render();
+    // The data that was streamed during the frame stays untouched until the GPU is done with it
+    mStreamBuffer.EndFrame();
+    // The GPU timings of the earlier frames that the GPU has finished
+    RESOLVE_GPU_BENCHMARKS;
+    // Reports how many of the binds of the frame actually reached the driver
+    mGlStateCache.EndFrame();
+
+    if (mDynamicResolution)
+    {
+        mDynamicResolution->EndFrame();
+        // Only reallocates the render targets when the scale has moved to another step
+        mPostProcessor.SetRenderScale(mDynamicResolution->GetScale());
+    }
 
     mDeltaTime = (float)mTimer.Time();
 
+    if (mHeadlessBenchmark)
+    {
+        mHeadlessBenchmark->EndFrame();
+        // Every frame advances the time equally, so that the
+        // benchmark renders the same frames every time it is run
+        mDeltaTime = HEADLESS_DELTA_TIME;
+
+        if (mHeadlessBenchmark->IsDone())
+        {
+            mHeadlessBenchmark->LogStatistics();
+
+            const bool hasNextMeshResolution = mHeadlessBenchmark->SweepsMeshResolutions()
+                && *mReportedMeshResolution + 1 < REPORTED_CELL_SIDE_LENGTHS.size();
+            if (hasNextMeshResolution)
+            {
+                // The warm-up frames of the next resolution hide the regeneration of the meshes
+                StartReportingMeshResolution(*mReportedMeshResolution + 1);
+                mHeadlessBenchmark->Restart();
+            }
+            else
+            {
+                mWindowShouldClose = true;
+            }
+        }
+    }
+
     NAMED_BENCHMARK("Swap and poll");
     // Swap front and back buffers
     mWindow.SwapBuffers();
@@ -201,7 +245,18 @@ void Game::Update()
 
     mTime += (double)mDeltaTime;
    
-    mCamera.UpdatePosition(mDeltaTime);
+    if (mHeadlessBenchmark)
+    {
+        mHeadlessBenchmark->MoveCamera(mCamera);
+    }
+    else
+    {
+        mCamera.UpdatePosition(mDeltaTime);
+    }
+    mFrameConstants.Update(mCamera);
+    UpdateMeshResolutionReport();
+    UpdateNoiseTextures();
+    CelestialBody::UpdateSharedTextures();
     mTexturedMoon.Update(mDeltaTime);
     mAsteroidMoon.Update(mDeltaTime);
     mPlanet.Update(mDeltaTime);
@@ -210,15 +265,145 @@ void Game::Update()
 void Game::Render() const
 {
     BENCHMARK;
-    mPostProcessor.Render("OceanEffect");
+    GPU_BENCHMARK("Render");
+    mPostProcessor.Render();
 }
 
 void Game::RenderWithPostProcessingEffect()
 {
     BENCHMARK;
-    mTexturedMoon.Render(mCamera, mProjectionMatrix);
-    mAsteroidMoon.Render(mCamera, mProjectionMatrix);
-    mPlanet.Render(mCamera, mProjectionMatrix);
+    GPU_BENCHMARK("Celestial bodies");
+    if (mHeadlessBenchmark)
+    {
+        mHeadlessBenchmark->BeginDraws();
+    }
+
+    // The celestial bodies share their resources, which only need to be bound once
+    CelestialBody::BindSharedResources();
+    // Only the headless benchmark draws copies, which are stacked above the celestial bodies
+    const int nCopies = mHeadlessBenchmark ? mHeadlessBenchmark->GetCopyCount() : 1;
+    for (CelestialBody* const celestialBody : GetCelestialBodies())
+    {
+        for (int copy = 0; copy < nCopies; ++copy)
+        {
+            celestialBody->Submit(mRenderQueue,
+                Vector3(0.0f, celestialBody->GetRadius() * COPY_SPACING * (float)copy, 0.0f));
+        }
+    }
+    mRenderQueue.Flush();
+
+    if (mHeadlessBenchmark)
+    {
+        mHeadlessBenchmark->EndDraws();
+    }
+}
+
+void Game::UpdateMeshResolutionReport()
+{
+    // The headless benchmark moves on to the next resolution by itself, once it has
+    // measured all its frames, since its delta time does not tell the frame time
+    if (mHeadlessBenchmark)
+    {
+        return;
+    }
+
+    const bool reportKeyIsPressed = Keyboard::KeyIsPressed(GLFW_KEY_M);
+    const bool reportKeyWasJustPressed = reportKeyIsPressed && !mReportKeyWasPressed;
+    mReportKeyWasPressed = reportKeyIsPressed;
+
+    if (!mReportedMeshResolution)
+    {
+        if (reportKeyWasJustPressed)
+        {
+            std::array<CelestialBody*, 3> celestialBodies = GetCelestialBodies();
+            for (size_t i = 0; i < celestialBodies.size(); ++i)
+            {
+                mCellSideLengthsBeforeReport[i] = celestialBodies[i]->GetCellSideLength();
+            }
+
+            LOG("Mesh resolution report, averaged over " << N_REPORTED_FRAMES << " frames per resolution."
+                << " The errors are the mean and the max distances, in model space, between the meshes"
+                << " and the terrain (textured moon, asteroid moon, planet)" << std::endl);
+            StartReportingMeshResolution(0);
+        }
+        return;
+    }
+
+    // The delta time of the first frame includes the regeneration of the meshes
+    if (mReportedFrames++ == 0)
+    {
+        return;
+    }
+    mReportedFrameTime += (double)mDeltaTime;
+
+    if (mReportedFrames <= N_REPORTED_FRAMES)
+    {
+        return;
+    }
+
+    LOG("    " << mReportedFrameTime / N_REPORTED_FRAMES * 1000.0 << " ms per frame" << std::endl);
+
+    if (*mReportedMeshResolution + 1 < REPORTED_CELL_SIDE_LENGTHS.size())
+    {
+        StartReportingMeshResolution(*mReportedMeshResolution + 1);
+    }
+    else
+    {
+        // Restore the resolutions that the celestial bodies had before the report
+        std::array<CelestialBody*, 3> celestialBodies = GetCelestialBodies();
+        for (size_t i = 0; i < celestialBodies.size(); ++i)
+        {
+            celestialBodies[i]->SetCellSideLength(mCellSideLengthsBeforeReport[i]);
+        }
+        mReportedMeshResolution.reset();
+    }
+}
+
+void Game::UpdateNoiseTextures()
+{
+    const bool regenerateKeyIsPressed = Keyboard::KeyIsPressed(GLFW_KEY_G);
+    if (regenerateKeyIsPressed && !mRegenerateKeyWasPressed)
+    {
+        mNoiseTextureSize = mNoiseTextureSize ? (*mNoiseTextureSize + 1) % NOISE_TEXTURE_SIZES.size() : 0;
+        const int size = NOISE_TEXTURE_SIZES[*mNoiseTextureSize];
+        LOG("Regenerating the noise textures at " << size << "x" << size << std::endl);
+        CelestialBody::RegenerateSharedTextures(size);
+    }
+    mRegenerateKeyWasPressed = regenerateKeyIsPressed;
+
+    const bool saveKeyIsPressed = Keyboard::KeyIsPressed(GLFW_KEY_P);
+    if (saveKeyIsPressed && !mSaveKeyWasPressed)
+    {
+        LOG("Saving the noise textures" << std::endl);
+        CelestialBody::SaveSharedTextures();
+    }
+    mSaveKeyWasPressed = saveKeyIsPressed;
+}
+
+void Game::StartReportingMeshResolution(const size_t index)
+{
+    mReportedMeshResolution = index;
+    mReportedFrames = 0;
+    mReportedFrameTime = 0.0;
+
+    const float cellSideLength = REPORTED_CELL_SIDE_LENGTHS[index];
+    LOG("Cell side length " << cellSideLength << ":" << std::endl);
+
+    size_t nTriangles = 0;
+    for (CelestialBody* const celestialBody : GetCelestialBodies())
+    {
+        celestialBody->SetCellSideLength(cellSideLength);
+        nTriangles += celestialBody->GetTriangleCount();
+
+        const MeshError error = celestialBody->MeasureMeshError();
+        LOG("    Error: " << error.mean << " (mean), " << error.max << " (max)" << std::endl);
+    }
+    LOG("    " << nTriangles << " triangles in total" << std::endl);
+}
+
+std::array<CelestialBody*, 3> Game::GetCelestialBodies()
+{
+    return { &mTexturedMoon, &mAsteroidMoon, &mPlanet };
 }
 
 void Game::CloseWindowCallback()
@@ -233,11 +418,14 @@ void Game::SetGlStates()
     // Its only purpose is to fulfill some GPUs requirement 
     // to always have a vertex array object bound.
     GL(glCreateVertexArrays(1, &mVao));
-    GL(glBindVertexArray(mVao));
+    mGlStateCache.BindVertexArray(mVao);
 
     GL(glClearColor(135.0f / 255.0f, 206.0f / 255.0f, 235.0f / 255.0f, 0.0f));
-    GL(glEnable(GL_DEPTH_TEST));
-    GL(glEnable(GL_CULL_FACE));
-    GL(glEnable(GL_BLEND));
+    mGlStateCache.SetEnabled(GL_DEPTH_TEST, true);
+    mGlStateCache.SetEnabled(GL_CULL_FACE, true);
+    mGlStateCache.SetEnabled(GL_BLEND, true);
+    // The detail normal maps of the celestial bodies are cube maps, whose
+    // faces should get filtered together along their edges
+    GL(glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS));
     GL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 }
\ No newline at end of file
@@ -2,17 +2,27 @@
 #include "Window/Window.h"
 #include "Keyboard.h"
 #include "Rendering/Program.h"
+#include "Rendering/GlStateCache.h"
 #include "Rendering/Camera.h"
+#include "Rendering/TextureLoader.h"
+#include "Rendering/AssetCache.h"
+#include "Rendering/RenderQueue.h"
+#include "Rendering/FrameConstantsBuffer.h"
+#include "Rendering/StreamBuffer.h"
+#include "Rendering/DynamicResolution.h"
 #include "Mathematics/Matrix/Matrix.h"
 #include "Timer.h"
 #include "Rendering/PostProcessing/PostProcessor.h"
 #include "CelestialBody/CelestialBody.h"
 #include "DynamicVariableManager.h"
+#include "HeadlessBenchmark.h"
 
 class Game
 {
 public:
-	Game();
+	// Runs the headless benchmark, instead of letting the user control
+	// the camera, when "headlessSettings" contains a value
+	Game(const std::optional<HeadlessBenchmark::Settings>& headlessSettings = std::nullopt);
 	~Game();
 
 	void BeginLoop();
@@ -23,8 +33,33 @@ private:
 	void RenderWithPostProcessingEffect();
 	void CloseWindowCallback();
 	void SetGlStates();
+	// Creates the post-processing effects, whose preparations read the members of the game
+	// every frame. The members do not need to have been constructed yet, when it is called.
+	std::unordered_map<std::string, PostProcessingEffect> CreatePostProcessingEffects();
+
+	// Starts a mesh resolution report when "M" gets pressed. The report renders a number of
+	// frames with each of the mesh resolutions, and logs the average frame time along with
+	// how far the meshes are from the terrain, before it restores the original resolutions.
+	void UpdateMeshResolutionReport();
+	// Regenerates the noise textures on the GPU, at the next resolution of "NOISE_TEXTURE_SIZES",
+	// when G is pressed, and saves them to disk when P is pressed
+	void UpdateNoiseTextures();
+	// Regenerates the meshes with the resolution "REPORTED_CELL_SIDE_LENGTHS[index]"
+	void StartReportingMeshResolution(size_t index);
+	std::array<CelestialBody*, 3> GetCelestialBodies();
 private:
 	Window mWindow;
+	// Needs to be constructed right after the window, since
+	// the below members bind their objects through it
+	GlStateCache mGlStateCache;
+	// Needs to be constructed right after the window and the state cache, since
+	// every texture that the below members create is loaded through it
+	TextureLoader mTextureLoader;
+	// Streams the data that changes from frame to frame to the GPU. Needs to be
+	// constructed before the members below, which upload their data through it.
+	StreamBuffer mStreamBuffer;
+	// Hands out the textures and samplers, so that each one is only created once
+	AssetCache mAssetCache;
 	Keyboard mKeyboard;
 	Camera mCamera;
 	bool mWindowShouldClose = false;
@@ -35,13 +70,32 @@ private:
 	float mDeltaTime = 1.0f / 60.0f;
 	double mTime = 0.0f;
 
+	// Only has a value when running headless
+	std::optional<HeadlessBenchmark> mHeadlessBenchmark;
+	static constexpr float HEADLESS_DELTA_TIME = 1.0f / 60.0f;
+	// The distance between the copies that the headless benchmark draws of a celestial
+	// body, in radii of the body, which keeps the copies from overlapping
+	static constexpr float COPY_SPACING = 2.5f;
+
+	// Scales the resolution of the scene to hold the GPU time of a frame near the target. Has
+	// no value when running headless, whose frames should all be rendered at the same resolution.
+	std::optional<DynamicResolution> mDynamicResolution;
+	// Leaves some of the 1/60 s of a frame, at 60 FPS, to the swapping of the buffers
+	static constexpr double TARGET_GPU_FRAME_TIME = 14.0;
+
 	// Some GPUs require that we have a vertex array 
 	// object bound and this vertex array object exists
 	// solely to fulfill that requirement
 	GLuint mVao = 0;
 
-	Matrix4 mProjectionMatrix;
+	// The view and the projection, which every program reads from the same uniform buffer
+	FrameConstantsBuffer mFrameConstants;
+	// Needs to be constructed before the celestial bodies, whose construction binds the terrain
+	// generator program. Since binding a program waits for the driver, every program, including
+	// those of the effects, needs to have been created by then, to be compiled in parallel.
 	PostProcessor mPostProcessor;
+	// Draws the celestial bodies, sorted by their programs
+	RenderQueue mRenderQueue;
 
 	// Generates the terrain of the celestial body
 	std::shared_ptr<Program> mCelestialBodyGeneratorProgram;
@@ -54,4 +108,24 @@ private:
 	CelestialBody mTexturedMoon;
 	CelestialBody mAsteroidMoon;
 	CelestialBody mPlanet;
+
+	// vvv Mesh resolution report vvv
+	static constexpr std::array<float, 4> REPORTED_CELL_SIDE_LENGTHS = { 0.02f, 0.04f, 0.08f, 0.16f };
+	static constexpr int N_REPORTED_FRAMES = 300;
+
+	// The index of the resolution that is being reported, if there is a report going on
+	std::optional<size_t> mReportedMeshResolution;
+	int mReportedFrames = 0;
+	double mReportedFrameTime = 0.0;
+	std::array<float, 3> mCellSideLengthsBeforeReport = {};
+	bool mReportKeyWasPressed = false;
+	// ^^^ Mesh resolution report ^^^
+
+	// vvv Noise texture regeneration vvv
+	static constexpr std::array<int, 4> NOISE_TEXTURE_SIZES = { 255, 511, 1023, 2047 };
+	// The index of the resolution that the noise textures were last regenerated at
+	std::optional<size_t> mNoiseTextureSize;
+	bool mRegenerateKeyWasPressed = false;
+	bool mSaveKeyWasPressed = false;
+	// ^^^ Noise texture regeneration ^^^
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "HeadlessBenchmark.h"
+#include "Rendering/GlMacro.h"
+#include "Mathematics/Algorithms.h"
+#include "Console/Log.h"
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+std::optional<HeadlessBenchmark::Settings> HeadlessBenchmark::ParseCommandLine(const int argc, char* argv[])
+{
+	const std::vector<std::string> arguments(argv + 1, argv + argc);
+	if (std::find(arguments.begin(), arguments.end(), "--headless") == arguments.end())
+	{
+		return std::nullopt;
+	}
+
+	Settings settings;
+	for (size_t i = 0; i < arguments.size(); ++i)
+	{
+		const std::string& argument = arguments[i];
+		if (argument == "--headless")
+		{
+			continue;
+		}
+		if (argument == "--mesh-resolutions")
+		{
+			settings.sweepsMeshResolutions = true;
+			continue;
+		}
+
+		// The rest of the arguments are followed by a value
+		if (i + 1 == arguments.size())
+		{
+			throw CREATE_CUSTOM_EXCEPTION("Missing a value after the argument \"" + argument + "\"");
+		}
+		const std::string& value = arguments[++i];
+
+		try
+		{
+			if (argument == "--frames")
+			{
+				settings.nFrames = std::stoi(value);
+			}
+			else if (argument == "--resolution")
+			{
+				const size_t separator = value.find('x');
+				settings.width = std::stoi(value.substr(0, separator));
+				settings.height = std::stoi(value.substr(separator + 1));
+			}
+			else if (argument == "--context")
+			{
+				const std::unordered_map<std::string, int> contextCreationApis = {
+					{ "native", GLFW_NATIVE_CONTEXT_API },
+					{ "egl", GLFW_EGL_CONTEXT_API },
+					{ "osmesa", GLFW_OSMESA_CONTEXT_API } };
+				settings.contextCreationApi = contextCreationApis.at(value);
+			}
+			else if (argument == "--copies")
+			{
+				settings.nCopies = std::stoi(value);
+			}
+			else
+			{
+				throw CREATE_CUSTOM_EXCEPTION("Unknown argument \"" + argument + "\"");
+			}
+		}
+		catch (const std::logic_error&)
+		{
+			// Thrown by "std::stoi" and "std::unordered_map::at"
+			throw CREATE_CUSTOM_EXCEPTION("Invalid value \"" + value + "\" for the argument \"" + argument + "\"");
+		}
+	}
+
+	if (settings.nFrames <= 0 || settings.width <= 0 || settings.height <= 0 || settings.nCopies <= 0)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("The number of frames, the resolution and the number of copies need to be positive");
+	}
+
+	return settings;
+}
+
+HeadlessBenchmark::HeadlessBenchmark(const Settings& settings)
+	:
+	mSettings(settings)
+{
+	mCpuTimes.reserve(mSettings.nFrames);
+	mGpuTimes.reserve(mSettings.nFrames);
+	mDrawTimes.reserve(mSettings.nFrames);
+}
+
+HeadlessBenchmark::~HeadlessBenchmark()
+{
+	// Destructors should not throw exception, hence no GL macro(s)
+	for (const GLuint query : mPendingQueries)
+	{
+		glDeleteQueries(1, &query);
+	}
+	glDeleteQueries((GLsizei)mFreeQueries.size(), mFreeQueries.data());
+}
+
+void HeadlessBenchmark::MoveCamera(Camera& camera) const
+{
+	// The warm-up frames stay at the start of the path, and the
+	// measured frames take the camera around it exactly once
+	const int measuredFrame = std::max(mFrame - mSettings.nWarmUpFrames, 0);
+	const float angle = 2.0f * (float)M_PI * (float)measuredFrame / (float)mSettings.nFrames;
+
+	const Vector3 position(PATH_RADIUS * sin(angle), PATH_HEIGHT, PATH_CENTRE_Z + PATH_RADIUS * cos(angle));
+
+	// Look at the centre of the path. A camera without any rotation looks
+	// along the negative z-axis, which the y-rotation turns counterclockwise.
+	Vector3 toCentre = Vector3(0.0f, 0.0f, PATH_CENTRE_Z) - position;
+	toCentre.Normalize();
+	const float xRotation = asin(toCentre[1]);
+	const float yRotation = atan2(-toCentre[0], -toCentre[2]);
+
+	camera.SetPose(position, xRotation, yRotation);
+}
+
+void HeadlessBenchmark::BeginFrame()
+{
+	mFrameStart = std::chrono::steady_clock::now();
+
+	if (mFreeQueries.empty())
+	{
+		mFreeQueries.resize(8);
+		GL(glCreateQueries(GL_TIME_ELAPSED, (GLsizei)mFreeQueries.size(), mFreeQueries.data()));
+	}
+	const GLuint query = mFreeQueries.back();
+	mFreeQueries.pop_back();
+
+	GL(glBeginQuery(GL_TIME_ELAPSED, query));
+	mPendingQueries.push_back(query);
+}
+
+void HeadlessBenchmark::EndFrame()
+{
+	GL(glEndQuery(GL_TIME_ELAPSED));
+
+	const bool isMeasured = mFrame >= mSettings.nWarmUpFrames;
+	if (isMeasured)
+	{
+		const std::chrono::duration<double, std::milli> cpuTime = std::chrono::steady_clock::now() - mFrameStart;
+		mCpuTimes.push_back(cpuTime.count());
+	}
+	else
+	{
+		// The GPU times of the warm-up frames are never read
+		mFreeQueries.push_back(mPendingQueries.back());
+		mPendingQueries.pop_back();
+	}
+	++mFrame;
+
+	ReadGpuTimes(false);
+}
+
+void HeadlessBenchmark::BeginDraws()
+{
+	mDrawsStart = std::chrono::steady_clock::now();
+}
+
+void HeadlessBenchmark::EndDraws()
+{
+	const bool isMeasured = mFrame >= mSettings.nWarmUpFrames;
+	if (isMeasured)
+	{
+		const std::chrono::duration<double, std::milli> drawTime = std::chrono::steady_clock::now() - mDrawsStart;
+		mDrawTimes.push_back(drawTime.count());
+	}
+}
+
+int HeadlessBenchmark::GetCopyCount() const
+{
+	return mSettings.nCopies;
+}
+
+bool HeadlessBenchmark::SweepsMeshResolutions() const
+{
+	return mSettings.sweepsMeshResolutions;
+}
+
+bool HeadlessBenchmark::IsDone() const
+{
+	return mFrame >= mSettings.nWarmUpFrames + mSettings.nFrames;
+}
+
+void HeadlessBenchmark::LogStatistics()
+{
+	ReadGpuTimes(true);
+
+	LOG("Headless benchmark of " << mCpuTimes.size() << " frames at " << mSettings.width << "x"
+		<< mSettings.height << ", with " << mSettings.nCopies << " copies of every celestial body, on "
+		<< glGetString(GL_RENDERER) << std::endl);
+	LOG("               mean     median       95th        max" << std::endl);
+	LogStatistics("CPU (ms)", mCpuTimes);
+	LogStatistics("GPU (ms)", mGpuTimes);
+	// The CPU time of the draws of the celestial bodies, which is part of the CPU time of the frames
+	LogStatistics("Draws (ms)", mDrawTimes);
+}
+
+void HeadlessBenchmark::Restart()
+{
+	// The queries of all the frames have been read while logging the statistics
+	assert(mPendingQueries.empty());
+
+	mFrame = 0;
+	mCpuTimes.clear();
+	mGpuTimes.clear();
+	mDrawTimes.clear();
+}
+
+void HeadlessBenchmark::ReadGpuTimes(const bool wait)
+{
+	while (!mPendingQueries.empty())
+	{
+		const GLuint query = mPendingQueries.front();
+		if (!wait)
+		{
+			GLint isAvailable = GL_FALSE;
+			GL(glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &isAvailable));
+			if (!isAvailable)
+			{
+				// The later frames are not done either
+				return;
+			}
+		}
+
+		GLuint64 nanoseconds = 0;
+		GL(glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds));
+		mGpuTimes.push_back((double)nanoseconds / 1e+6);
+
+		mFreeQueries.push_back(query);
+		mPendingQueries.pop_front();
+	}
+}
+
+void HeadlessBenchmark::LogStatistics(const std::string& name, std::vector<double> milliseconds)
+{
+	if (milliseconds.empty())
+	{
+		return;
+	}
+	std::sort(milliseconds.begin(), milliseconds.end());
+
+	const double mean = std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0) / (double)milliseconds.size();
+	const double median = milliseconds[milliseconds.size() / 2];
+	const double percentile95 = milliseconds[milliseconds.size() * 95 / 100];
+
+	// Formatted on its own stream, since the fixed precision would stick to the later logs otherwise
+	std::stringstream row;
+	row << std::fixed << std::setprecision(3) << std::left << std::setw(8) << name << std::right
+		<< std::setw(11) << mean << std::setw(11) << median << std::setw(11) << percentile95
+		<< std::setw(11) << milliseconds.back();
+	LOG(row.str() << std::endl);
+}
\ No newline at end of file
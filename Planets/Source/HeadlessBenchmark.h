@@ -0,0 +1,94 @@
+#pragma once
+#include "GL/glew.h"
+#include <GLFW/glfw3.h>
+#include "Rendering/Camera.h"
+#include <chrono>
+#include <deque>
+#include <optional>
+
+// Renders a fixed number of frames, without anybody in front of the screen, while the camera
+// follows a scripted path around the celestial bodies. The window stays hidden, and its context
+// can be created through EGL or OSMesa, which lets the benchmark run on a software rasterizer,
+// such as llvmpipe, on machines without a display. The CPU and GPU time of every frame gets
+// measured, and the statistics are logged once all the frames have been rendered. Should only
+// be used by the thread that owns the OpenGL context.
+class HeadlessBenchmark
+{
+public:
+	struct Settings
+	{
+		// The number of measured frames, which follow the frames that warm up the caches
+		int nFrames = 600;
+		int nWarmUpFrames = 60;
+		// The resolution that the scene is rendered at
+		int width = 1280;
+		int height = 720;
+		// The number of times that every celestial body gets drawn, which lets the benchmark
+		// measure how the CPU cost of the draws grows with more bodies than the scene has
+		int nCopies = 1;
+		// Renders all the frames once for every resolution of the meshes in the mesh
+		// resolution report, instead of once with the resolution that the meshes start with
+		bool sweepsMeshResolutions = false;
+		// "GLFW_NATIVE_CONTEXT_API", "GLFW_EGL_CONTEXT_API" or "GLFW_OSMESA_CONTEXT_API"
+		int contextCreationApi = GLFW_NATIVE_CONTEXT_API;
+	};
+
+	// Returns the settings of the benchmark if the command line contains "--headless", which
+	// can be followed by "--frames <n>", "--resolution <width>x<height>", "--context <native,
+	// egl or osmesa>", "--copies <n>" and "--mesh-resolutions". Throws if any of the arguments
+	// are invalid.
+	static std::optional<Settings> ParseCommandLine(int argc, char* argv[]);
+
+	HeadlessBenchmark(const Settings& settings);
+	~HeadlessBenchmark();
+
+	// One should not be able to copy a "HeadlessBenchmark" instance
+	HeadlessBenchmark(const HeadlessBenchmark& other) = delete;
+	HeadlessBenchmark& operator=(const HeadlessBenchmark& other) = delete;
+
+	// Moves the camera to where the path is at the current frame
+	void MoveCamera(Camera& camera) const;
+
+	// Need to surround the work of every frame, except for the swapping of the buffers,
+	// which would otherwise measure how long the frame waited for the display
+	void BeginFrame();
+	void EndFrame();
+	// Need to surround the submission and the flushing of the draws of the celestial
+	// bodies, whose CPU time is measured on its own
+	void BeginDraws();
+	void EndDraws();
+
+	int GetCopyCount() const;
+	bool SweepsMeshResolutions() const;
+
+	bool IsDone() const;
+	// Waits for the GPU to finish the last frames, and logs the statistics of all the frames
+	void LogStatistics();
+	// Starts over from the first warm-up frame, with the camera at the start of the path.
+	// Needs to be called after the statistics of the earlier frames have been logged.
+	void Restart();
+private:
+	// Stores the GPU times that are available, without waiting for the GPU, unless "wait" is set
+	void ReadGpuTimes(bool wait);
+	// Logs the mean, the median, the 95th percentile and the maximum of "milliseconds"
+	static void LogStatistics(const std::string& name, std::vector<double> milliseconds);
+private:
+	Settings mSettings;
+	int mFrame = 0;
+
+	std::chrono::steady_clock::time_point mFrameStart;
+	std::chrono::steady_clock::time_point mDrawsStart;
+	// The queries of the frames whose GPU times have not been read yet, in the order of the frames
+	std::deque<GLuint> mPendingQueries;
+	std::vector<GLuint> mFreeQueries;
+
+	// The times, in milliseconds, of the measured frames
+	std::vector<double> mCpuTimes;
+	std::vector<double> mGpuTimes;
+	std::vector<double> mDrawTimes;
+
+	// The path circles the point that the celestial bodies are placed around
+	static constexpr float PATH_CENTRE_Z = -20.0f;
+	static constexpr float PATH_RADIUS = 60.0f;
+	static constexpr float PATH_HEIGHT = 15.0f;
+};
\ No newline at end of file
@@ -4,7 +4,7 @@
 #include "Benchmark/BenchmarkMacros.h"
 #include "Console/ErrorLog.h"
 
-int main()
+int main(int argc, char* argv[])
 {
     // The status of the execution is 
     // initially set to success
@@ -23,7 +23,7 @@ int main()
             // Creating a benchmark session that exists during the entire lifetime of "game"
             benchmarkSession.emplace("Main");
         #endif  
-        game.emplace();
+        game.emplace(HeadlessBenchmark::ParseCommandLine(argc, argv));
     }
     catch (const CustomException& exception)
     {
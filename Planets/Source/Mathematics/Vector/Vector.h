@@ -96,7 +96,7 @@ public:
 			(*this) /= GetLength();
 		}
 	}
-	[[nodiscard]] BasicVector GetNormalized()
+	[[nodiscard]] BasicVector GetNormalized() const
 	{
 		BasicVector temporary = *this;
 		temporary.Normalize();
@@ -0,0 +1,403 @@
+#include "ImageBenchmarks.h"
+#include "../Rendering/PngLoader.h"
+#include "../Console/Log.h"
+#include "../Timer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <new>
+#include <optional>
+
+// vvv Heap usage tracking vvv
+
+// The global allocation functions are replaced, for the micro-benchmarks only, so that the
+// peak heap usage of a decode can be measured. Note that the buffers that the PNG decoder
+// allocates internally use "malloc" and are therefore not counted.
+namespace
+{
+	std::atomic<size_t> gHeapUsage = 0;
+	std::atomic<size_t> gPeakHeapUsage = 0;
+
+	// Every allocation is prefixed by its size, padded to keep the returned memory aligned
+	constexpr size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+}
+
+void* operator new(const size_t size)
+{
+	void* const allocation = std::malloc(size + ALLOCATION_HEADER_SIZE);
+	if (!allocation)
+	{
+		throw std::bad_alloc();
+	}
+	*static_cast<size_t*>(allocation) = size;
+
+	const size_t heapUsage = gHeapUsage += size;
+	size_t peakHeapUsage = gPeakHeapUsage;
+	while (heapUsage > peakHeapUsage && !gPeakHeapUsage.compare_exchange_weak(peakHeapUsage, heapUsage))
+	{
+	}
+
+	return static_cast<char*>(allocation) + ALLOCATION_HEADER_SIZE;
+}
+
+void operator delete(void* const memory) noexcept
+{
+	if (!memory)
+	{
+		return;
+	}
+
+	void* const allocation = static_cast<char*>(memory) - ALLOCATION_HEADER_SIZE;
+	gHeapUsage -= *static_cast<size_t*>(allocation);
+	std::free(allocation);
+}
+
+void operator delete(void* const memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+// ^^^ Heap usage tracking ^^^
+
+namespace
+{
+	// Every measurement is repeated, and the fastest repetition is the one that gets reported
+	constexpr int N_REPETITIONS = 3;
+
+	// The side lengths, in pixels, of the benchmarked images
+	constexpr unsigned int BENCHMARK_SIZES[] = { 1024, 2048, 4096 };
+
+	// The directory of the textures, relative to the directory that the program runs in
+	const std::string TEXTURE_DIRECTORY = "Source/Textures/";
+
+	// The PNG filter types: none, sub, up, average and Paeth
+	constexpr unsigned char FILTER_TYPES[] = { 0, 1, 2, 3, 4 };
+
+	struct ImageFormat
+	{
+		LodePNGColorType colourType = LCT_RGBA;
+		unsigned int bitDepth = 8;
+		// 0 means no interlacing and 1 means Adam7 interlacing
+		unsigned int interlaceMethod = 0;
+	};
+
+	// The formats cover every path of the decoder: unfiltering straight into the output,
+	// unfiltering scanlines with padding bits, and deinterlacing
+	constexpr ImageFormat VERIFIED_FORMATS[] = {
+		{ LCT_RGBA, 8, 0 }, { LCT_RGB, 8, 0 }, { LCT_GREY, 1, 0 }, { LCT_GREY_ALPHA, 8, 0 },
+		{ LCT_RGBA, 8, 1 }, { LCT_RGB, 8, 1 }, { LCT_GREY, 1, 1 }, { LCT_GREY, 4, 1 }, { LCT_RGBA, 16, 0 }
+	};
+
+	// Returns pseudo random pixels in the given format. The pixels are a mix of
+	// smooth gradients and noise, so that every filter type gets used.
+	std::vector<unsigned char> GeneratePixels(const unsigned int width, const unsigned int height,
+		const ImageFormat& format)
+	{
+		LodePNGColorMode colourMode;
+		lodepng_color_mode_init(&colourMode);
+		colourMode.colortype = format.colourType;
+		colourMode.bitdepth = format.bitDepth;
+
+		std::vector<unsigned char> pixels(lodepng_get_raw_size(width, height, &colourMode));
+		unsigned int random = 1234;
+		for (size_t i = 0; i < pixels.size(); ++i)
+		{
+			// A linear congruential generator
+			random = random * 1664525u + 1013904223u;
+			pixels[i] = (unsigned char)((i % 251) + ((random >> 24) & 15));
+		}
+
+		// The bits after the last pixel are not part of the image, and are decoded as zeroes
+		const size_t nBits = (size_t)width * height * lodepng_get_bpp(&colourMode);
+		if (nBits % 8 != 0)
+		{
+			pixels.back() &= (unsigned char)(0xFF << (8 - nBits % 8));
+		}
+		return pixels;
+	}
+
+	// Encodes the pixels of "GeneratePixels", using the given format. If "filterType" is
+	// given, every scanline uses that filter type, otherwise the encoder chooses.
+	std::vector<unsigned char> EncodeImage(const unsigned int width, const unsigned int height,
+		const ImageFormat& format, const std::optional<unsigned char> filterType = std::nullopt)
+	{
+		lodepng::State state;
+		state.info_raw.colortype = format.colourType;
+		state.info_raw.bitdepth = format.bitDepth;
+		state.info_png.color.colortype = format.colourType;
+		state.info_png.color.bitdepth = format.bitDepth;
+		state.info_png.interlace_method = format.interlaceMethod;
+		state.encoder.auto_convert = 0;
+		// A small window keeps the encoding of the large images fast, at the cost of a
+		// worse compression, which does not matter for the decoder
+		state.encoder.zlibsettings.windowsize = 256;
+
+		// Every scanline of the reduced images of Adam7 needs a filter type, and there
+		// are less than twice as many of those scanlines as there are in the image
+		const std::vector<unsigned char> filterTypes(height * 2 + 7, filterType.value_or(0));
+		if (filterType)
+		{
+			state.encoder.filter_strategy = LFS_PREDEFINED;
+			state.encoder.predefined_filters = filterTypes.data();
+		}
+
+		const std::vector<unsigned char> pixels = GeneratePixels(width, height, format);
+
+		std::vector<unsigned char> png;
+		if (const unsigned int error = lodepng::encode(png, pixels, width, height, state))
+		{
+			LOG("Failed to encode an image: " << lodepng_error_text(error) << std::endl);
+		}
+		return png;
+	}
+
+	// Decodes the image to 8-bit RGBA, i.e., the format that the textures use
+	std::vector<unsigned char> Decode(const std::vector<unsigned char>& png, const bool flipVertically)
+	{
+		lodepng::State state;
+		state.decoder.flip_vertically = flipVertically ? 1 : 0;
+
+		std::vector<unsigned char> image;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		if (const unsigned int error = lodepng::decode(image, width, height, state, png))
+		{
+			LOG("Failed to decode an image: " << lodepng_error_text(error) << std::endl);
+		}
+		return image;
+	}
+
+	// Decodes the image to 8-bit RGBA into a buffer of the caller, like the textures do
+	std::vector<unsigned char> DecodeIntoBuffer(const std::vector<unsigned char>& png, const bool flipVertically)
+	{
+		lodepng::State state;
+		state.decoder.flip_vertically = flipVertically ? 1 : 0;
+
+		unsigned int width = 0;
+		unsigned int height = 0;
+		lodepng_inspect(&width, &height, &state, png.data(), png.size());
+
+		std::vector<unsigned char> image((size_t)width * height * 4);
+		if (const unsigned int error = lodepng::decode(image.data(), image.size(), width, height, state, png))
+		{
+			LOG("Failed to decode an image into a buffer: " << lodepng_error_text(error) << std::endl);
+		}
+		return image;
+	}
+
+	// Decodes the image without converting it, i.e., to the colour type of the PNG
+	std::vector<unsigned char> DecodeWithoutConversion(const std::vector<unsigned char>& png)
+	{
+		lodepng::State state;
+		state.decoder.color_convert = 0;
+
+		std::vector<unsigned char> image;
+		unsigned int width = 0;
+		unsigned int height = 0;
+		if (const unsigned int error = lodepng::decode(image, width, height, state, png))
+		{
+			LOG("Failed to decode an image: " << lodepng_error_text(error) << std::endl);
+		}
+		return image;
+	}
+
+	// The flip that the textures did before the decoder was able to flip the image. It
+	// makes a copy of the image, and a vector of row pointers, and copies the image back.
+	void RevertImageByCopying(std::vector<unsigned char>& image, const int width, const int height)
+	{
+		std::vector<unsigned char> reversedImage = image;
+
+		const int byteWidth = width * 4;
+
+		std::vector<const unsigned char*> rows;
+		rows.resize(height);
+		std::generate(rows.begin(), rows.end(),
+			[i = 0, &image, byteWidth]() mutable
+		{
+			return &image.front() + (i++) * byteWidth;
+		});
+
+		std::for_each(rows.rbegin(), rows.rend(),
+			[i = 0, &reversedImage, byteWidth](const unsigned char* row) mutable
+		{
+			std::copy_n(row, byteWidth, reversedImage.begin() + (i++) * byteWidth);
+		});
+
+		image = reversedImage;
+	}
+
+	struct Measurement
+	{
+		double milliseconds = std::numeric_limits<double>::max();
+		// The highest amount of bytes, allocated through "operator new", during the decode
+		size_t peakHeapUsage = 0;
+	};
+
+	// Returns the fastest of "N_REPETITIONS" calls to "decode", and its peak heap usage
+	template<class F>
+	Measurement Measure(const F& decode)
+	{
+		Measurement measurement;
+		Timer timer;
+		for (int i = 0; i < N_REPETITIONS; ++i)
+		{
+			const size_t heapUsageBefore = gHeapUsage;
+			gPeakHeapUsage = heapUsageBefore;
+
+			// Restart the timer
+			timer.Time();
+			decode();
+			measurement.milliseconds = std::min(measurement.milliseconds, timer.Time() * 1e+3);
+			measurement.peakHeapUsage = gPeakHeapUsage - heapUsageBefore;
+		}
+		return measurement;
+	}
+}
+
+namespace microbenchmark
+{
+	bool VerifyImageDecoding()
+	{
+		bool succeeded = true;
+
+		// An odd size, so that the middle row has to stay in place and the
+		// scanlines of the low bit depths end with padding bits
+		const unsigned int width = 37;
+		const unsigned int height = 29;
+
+		for (const ImageFormat& format : VERIFIED_FORMATS)
+		{
+			const std::vector<unsigned char> png = EncodeImage(width, height, format);
+
+			std::vector<unsigned char> expectedImage = Decode(png, false);
+			RevertImageByCopying(expectedImage, width, height);
+
+			if (Decode(png, true) != expectedImage)
+			{
+				LOG("The flipped decode of a " << format.bitDepth << "-bit image with colour type "
+					<< format.colourType << " and interlace method " << format.interlaceMethod
+					<< " does not match the decode flipped afterwards" << std::endl);
+				succeeded = false;
+			}
+
+			if (format.bitDepth >= 8 && (DecodeIntoBuffer(png, false) != Decode(png, false)
+				|| DecodeIntoBuffer(png, true) != expectedImage))
+			{
+				LOG("The decode into a buffer of a " << format.bitDepth << "-bit image with colour type "
+					<< format.colourType << " and interlace method " << format.interlaceMethod
+					<< " does not match the decode into a vector" << std::endl);
+				succeeded = false;
+			}
+
+			// Every filter type is verified separately, since the common
+			// colour types have their own unfilter for each filter type
+			for (const unsigned char filterType : FILTER_TYPES)
+			{
+				if (DecodeWithoutConversion(EncodeImage(width, height, format, filterType))
+					!= GeneratePixels(width, height, format))
+				{
+					LOG("The decode of a " << format.bitDepth << "-bit image with colour type "
+						<< format.colourType << " and interlace method " << format.interlaceMethod
+						<< " does not match the encoded pixels, with filter type " << (int)filterType << std::endl);
+					succeeded = false;
+				}
+			}
+		}
+
+		return succeeded;
+	}
+
+	void RunImageBenchmarks()
+	{
+		LOG("Decoding 8-bit RGBA PNG images, fastest of " << N_REPETITIONS << " repetitions" << std::endl);
+		LOG("The fused flip happens while decoding, the copying flip is the one the textures used to do" << std::endl);
+		LOG(std::right << std::setw(10) << "Size" << std::setw(18) << "Fused (ms)" << std::setw(18) << "Copying (ms)"
+			<< std::setw(18) << "Fused peak (MB)" << std::setw(20) << "Copying peak (MB)" << std::endl);
+
+		for (const unsigned int size : BENCHMARK_SIZES)
+		{
+			const std::vector<unsigned char> png = EncodeImage(size, size, ImageFormat{ LCT_RGBA, 8, 0 });
+
+			const Measurement fused = Measure(
+				[&png]()
+				{
+					std::vector<unsigned char> image = Decode(png, true);
+				});
+			const Measurement copied = Measure(
+				[&png, size]()
+				{
+					std::vector<unsigned char> image = Decode(png, false);
+					RevertImageByCopying(image, (int)size, (int)size);
+				});
+
+			LOG(std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << std::to_string(size) + "^2"
+				<< std::setw(18) << fused.milliseconds
+				<< std::setw(18) << copied.milliseconds
+				<< std::setw(18) << (double)fused.peakHeapUsage / (1024.0 * 1024.0)
+				<< std::setw(20) << (double)copied.peakHeapUsage / (1024.0 * 1024.0)
+				<< std::endl);
+		}
+		LOG(std::defaultfloat);
+
+		RunTextureDecodingBenchmarks();
+	}
+
+	void RunTextureDecodingBenchmarks()
+	{
+		LOG(std::endl << "Decoding the PNG textures to flipped 8-bit RGBA, fastest of " << N_REPETITIONS
+			<< " repetitions" << std::endl);
+		LOG("The throughput is in decoded megabytes per second" << std::endl);
+		LOG(std::right << std::setw(24) << "Texture" << std::setw(14) << "Size" << std::setw(18) << "Vector (MB/s)"
+			<< std::setw(18) << "Buffer (MB/s)" << std::endl);
+
+		std::error_code errorCode;
+		for (const auto& entry : std::filesystem::directory_iterator(TEXTURE_DIRECTORY, errorCode))
+		{
+			if (entry.path().extension() != ".png")
+			{
+				continue;
+			}
+
+			std::vector<unsigned char> png;
+			if (const unsigned int error = lodepng::load_file(png, entry.path().string()))
+			{
+				LOG("Failed to read " << entry.path().string() << ": " << lodepng_error_text(error) << std::endl);
+				continue;
+			}
+
+			unsigned int width = 0;
+			unsigned int height = 0;
+			lodepng::State state;
+			lodepng_inspect(&width, &height, &state, png.data(), png.size());
+			const double megabytes = (double)width * height * 4 / (1024.0 * 1024.0);
+
+			const Measurement vector = Measure(
+				[&png]()
+				{
+					std::vector<unsigned char> image = Decode(png, true);
+				});
+			const Measurement buffer = Measure(
+				[&png]()
+				{
+					std::vector<unsigned char> image = DecodeIntoBuffer(png, true);
+				});
+
+			LOG(std::right << std::fixed << std::setprecision(1)
+				<< std::setw(24) << entry.path().filename().string()
+				<< std::setw(14) << std::to_string(width) + "x" + std::to_string(height)
+				<< std::setw(18) << megabytes / (vector.milliseconds * 1e-3)
+				<< std::setw(18) << megabytes / (buffer.milliseconds * 1e-3)
+				<< std::endl);
+		}
+		if (errorCode)
+		{
+			LOG("Failed to open " << TEXTURE_DIRECTORY << ", the benchmarks need to run in the Planets directory"
+				<< std::endl);
+		}
+		LOG(std::defaultfloat);
+	}
+}
\ No newline at end of file
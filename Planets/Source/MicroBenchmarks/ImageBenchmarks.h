@@ -0,0 +1,20 @@
+#pragma once
+
+namespace microbenchmark
+{
+	// Decodes PNG images of several colour types, bit depths and interlace methods with the
+	// decoder's vertical flip, and compares them with images that were flipped after being
+	// decoded, and with images that were decoded into a buffer. Every image is also encoded
+	// with each filter type, and decoded back into the pixels it was encoded from. Every
+	// mismatch gets logged. Returns false if there was at least one mismatch.
+	bool VerifyImageDecoding();
+
+	// Measures the time and the peak heap usage of decoding large PNG images, with the
+	// decoder's vertical flip and with the copying flip that the textures used to do,
+	// and logs the results. Then runs "RunTextureDecodingBenchmarks".
+	void RunImageBenchmarks();
+
+	// Measures the decode throughput of the PNG textures in "Source/Textures", decoded
+	// into a vector and into a buffer of the caller, and logs the results
+	void RunTextureDecodingBenchmarks();
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "NoiseBenchmarks.h"
+#include "ImageBenchmarks.h"
+#include "MipChainBenchmarks.h"
+#include "../Console/Log.h"
+#include <string_view>
+
+// Runs the micro-benchmarks. Passing "--verify" only runs the golden value checks,
+// which makes the program usable as a quick check after an optimization. The
+// program exits with a failure status if any output differs from its golden value.
+int main(int argc, char* argv[])
+{
+	const bool onlyVerify = argc > 1 && std::string_view(argv[1]) == "--verify";
+
+	if (!microbenchmark::VerifyNoiseGoldenValues())
+	{
+		LOG("The noise does not match the golden values" << std::endl);
+		return EXIT_FAILURE;
+	}
+	LOG("The noise matches the golden values" << std::endl);
+
+	if (!microbenchmark::VerifyImageDecoding())
+	{
+		LOG("The flipped image decoding does not match the reference" << std::endl);
+		return EXIT_FAILURE;
+	}
+	LOG("The flipped image decoding matches the reference" << std::endl);
+
+	if (!microbenchmark::VerifyMipChains())
+	{
+		LOG("The mip chains do not have the expected properties" << std::endl);
+		return EXIT_FAILURE;
+	}
+	LOG("The mip chains have the expected properties" << std::endl);
+
+	if (!onlyVerify)
+	{
+		LOG(std::endl);
+		microbenchmark::RunNoiseBenchmarks();
+
+		LOG(std::endl);
+		microbenchmark::RunImageBenchmarks();
+
+		LOG(std::endl);
+		microbenchmark::RunMipChainBenchmarks();
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
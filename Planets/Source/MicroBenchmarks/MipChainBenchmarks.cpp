@@ -0,0 +1,230 @@
+#include "MipChainBenchmarks.h"
+#include "../Rendering/MipChain.h"
+#include "../Rendering/PngLoader.h"
+#include "../Console/Log.h"
+#include "../Timer.h"
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <limits>
+
+namespace
+{
+	// Every measurement is repeated, and the fastest repetition is the one that gets reported
+	constexpr int N_REPETITIONS = 3;
+
+	// The directory of the textures, relative to the directory that the program runs in
+	const std::string TEXTURE_DIRECTORY = "Source/Textures/";
+
+	// Returns pseudo random 8-bit RGBA pixels
+	std::vector<unsigned char> GeneratePixels(const int width, const int height)
+	{
+		std::vector<unsigned char> pixels((size_t)width * height * 4);
+		unsigned int random = 1234;
+		for (unsigned char& channel : pixels)
+		{
+			// A linear congruential generator
+			random = random * 1664525u + 1013904223u;
+			channel = (unsigned char)(random >> 24);
+		}
+		return pixels;
+	}
+
+	// Returns the fastest of "N_REPETITIONS" calls to "function", in milliseconds
+	template<class F>
+	double Measure(const F& function)
+	{
+		double milliseconds = std::numeric_limits<double>::max();
+		Timer timer;
+		for (int i = 0; i < N_REPETITIONS; ++i)
+		{
+			// Restart the timer
+			timer.Time();
+			function();
+			milliseconds = std::min(milliseconds, timer.Time() * 1e+3);
+		}
+		return milliseconds;
+	}
+}
+
+namespace microbenchmark
+{
+	bool VerifyMipChains()
+	{
+		bool succeeded = true;
+
+		// An odd size, so that the destination pixels do not line up with the source pixels
+		const int width = 255;
+		const int height = 37;
+		const std::vector<unsigned char> pixels = GeneratePixels(width, height);
+
+		const std::vector<mipchain::MipLevel> mipChain =
+			mipchain::BuildRgba8(pixels.data(), width, height, TextureKind::Colour, mipchain::FULL_CHAIN);
+		if (mipChain.size() != 8 || mipChain.back().width != 1 || mipChain.back().height != 1
+			|| mipChain[1].width != 127 || mipChain[1].height != 18 || mipChain[0].pixels != pixels)
+		{
+			LOG("The full mip chain of a " << width << "x" << height << " image has the wrong mip levels" << std::endl);
+			succeeded = false;
+		}
+
+		// A box filtered float image, with even sides, is the exact average of 2x2 pixels
+		std::vector<float> floats(64 * 64);
+		for (size_t i = 0; i < floats.size(); ++i)
+		{
+			floats[i] = (float)pixels[i] / 255.0f;
+		}
+		const std::vector<mipchain::MipLevel> floatMipChain = mipchain::BuildR32f(floats.data(), 64, 64, 2,
+			MipFilter::Box);
+		const float* const averages = reinterpret_cast<const float*>(floatMipChain[1].pixels.data());
+		for (int y = 0; y < 32; ++y)
+		{
+			for (int x = 0; x < 32; ++x)
+			{
+				const float average = (floats[(y * 2) * 64 + x * 2] + floats[(y * 2) * 64 + x * 2 + 1]
+					+ floats[(y * 2 + 1) * 64 + x * 2] + floats[(y * 2 + 1) * 64 + x * 2 + 1]) / 4.0f;
+				if (std::abs(averages[y * 32 + x] - average) > 1e-6f)
+				{
+					LOG("The box filtered pixel (" << x << ", " << y << ") is not the average of its 2x2 pixels"
+						<< std::endl);
+					succeeded = false;
+				}
+			}
+		}
+
+		// The colour, which goes through the linear space and back, and
+		// the normal, which gets renormalized, should not change at all
+		for (const TextureKind kind : { TextureKind::Colour, TextureKind::NormalMap })
+		{
+			// The normal is (0.6, 0, 0.8), as close as 8 bits get to it
+			const std::array<unsigned char, 4> flatPixel = kind == TextureKind::Colour
+				? std::array<unsigned char, 4>{ 200, 90, 230, 255 } : std::array<unsigned char, 4>{ 204, 128, 230, 255 };
+			std::vector<unsigned char> flatPixels((size_t)width * height * 4);
+			for (size_t i = 0; i < flatPixels.size(); ++i)
+			{
+				flatPixels[i] = flatPixel[i % 4];
+			}
+
+			for (const mipchain::MipLevel& mipLevel :
+				mipchain::BuildRgba8(flatPixels.data(), width, height, kind, mipchain::FULL_CHAIN))
+			{
+				for (size_t i = 0; i < mipLevel.pixels.size(); ++i)
+				{
+					if (std::abs((int)mipLevel.pixels[i] - (int)flatPixel[i % 4]) > (kind == TextureKind::Colour ? 0 : 1))
+					{
+						LOG("The " << mipLevel.width << "x" << mipLevel.height << " mip level of a flat "
+							<< (kind == TextureKind::Colour ? "colour" : "normal") << " image is not flat" << std::endl);
+						succeeded = false;
+						break;
+					}
+				}
+			}
+		}
+
+		const std::vector<mipchain::MipLevel> normalMipChain =
+			mipchain::BuildRgba8(pixels.data(), width, height, TextureKind::NormalMap, mipchain::FULL_CHAIN);
+		// The first mip level is the image itself, whose pixels are not normalized
+		for (size_t level = 1; level < normalMipChain.size(); ++level)
+		{
+			const mipchain::MipLevel& mipLevel = normalMipChain[level];
+			for (size_t i = 0; i < mipLevel.pixels.size(); i += 4)
+			{
+				float lengthSquared = 0.0f;
+				for (int c = 0; c < 3; ++c)
+				{
+					const float component = (float)mipLevel.pixels[i + c] / 127.5f - 1.0f;
+					lengthSquared += component * component;
+				}
+
+				// The quantization to 8 bits moves every component by up to half a step
+				if (std::abs(std::sqrt(lengthSquared) - 1.0f) > 0.02f)
+				{
+					LOG("A normal of the " << mipLevel.width << "x" << mipLevel.height
+						<< " mip level of a normal map is not normalized" << std::endl);
+					succeeded = false;
+					break;
+				}
+			}
+		}
+
+		ThreadPool threadPool;
+		for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+		{
+			const std::vector<mipchain::MipLevel> parallelMipChain = mipchain::BuildRgba8(pixels.data(), width,
+				height, TextureKind::Colour, mipchain::FULL_CHAIN, filter, &threadPool);
+			const std::vector<mipchain::MipLevel> serialMipChain =
+				mipchain::BuildRgba8(pixels.data(), width, height, TextureKind::Colour, mipchain::FULL_CHAIN, filter);
+
+			for (size_t i = 0; i < serialMipChain.size(); ++i)
+			{
+				if (parallelMipChain[i].pixels != serialMipChain[i].pixels)
+				{
+					LOG("The mip level " << i << ", built on a thread pool, does not match the one built on a single"
+						<< " thread" << std::endl);
+					succeeded = false;
+				}
+			}
+		}
+
+		return succeeded;
+	}
+
+	void RunMipChainBenchmarks()
+	{
+		LOG("Building the full mip chains of the PNG textures, fastest of " << N_REPETITIONS
+			<< " repetitions" << std::endl);
+		LOG("The throughput is in megapixels of the first mip level per second" << std::endl);
+		LOG(std::right << std::setw(24) << "Texture" << std::setw(14) << "Size" << std::setw(14) << "Box"
+			<< std::setw(14) << "Box (pool)" << std::setw(14) << "Kaiser" << std::setw(16) << "Kaiser (pool)"
+			<< std::endl);
+
+		ThreadPool threadPool;
+
+		std::error_code errorCode;
+		for (const auto& entry : std::filesystem::directory_iterator(TEXTURE_DIRECTORY, errorCode))
+		{
+			if (entry.path().extension() != ".png")
+			{
+				continue;
+			}
+
+			std::vector<unsigned char> pixels;
+			unsigned int width = 0;
+			unsigned int height = 0;
+			if (const unsigned int error = lodepng::decode(pixels, width, height, entry.path().string()))
+			{
+				LOG("Failed to decode " << entry.path().string() << ": " << lodepng_error_text(error) << std::endl);
+				continue;
+			}
+
+			// The textures whose names end with "Normal" are normal maps
+			const TextureKind kind = entry.path().stem().string().ends_with("Normal") ? TextureKind::NormalMap
+				: TextureKind::Colour;
+			const double megapixels = (double)width * height / 1e+6;
+
+			LOG(std::right << std::fixed << std::setprecision(1)
+				<< std::setw(24) << entry.path().filename().string()
+				<< std::setw(14) << std::to_string(width) + "x" + std::to_string(height));
+			for (const MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+			{
+				for (ThreadPool* const pool : { (ThreadPool*)nullptr, &threadPool })
+				{
+					const double milliseconds = Measure(
+						[&]()
+						{
+							mipchain::BuildRgba8(pixels.data(), (int)width, (int)height, kind, mipchain::FULL_CHAIN,
+								filter, pool);
+						});
+					LOG(std::setw(filter == MipFilter::Kaiser && pool ? 16 : 14) << megapixels / (milliseconds * 1e-3));
+				}
+			}
+			LOG(std::endl);
+		}
+		if (errorCode)
+		{
+			LOG("Failed to open " << TEXTURE_DIRECTORY << ", the benchmarks need to run in the Planets directory"
+				<< std::endl);
+		}
+		LOG(std::defaultfloat);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace microbenchmark
+{
+	// Builds mip chains of generated images and checks the properties that every chain should
+	// have: the sizes of the mip levels, box filtered levels that are exact averages, flat images
+	// that stay flat, normals that stay normalized, and parallel builds that match the serial
+	// ones. Every mismatch gets logged. Returns false if there was at least one mismatch.
+	bool VerifyMipChains();
+
+	// Measures how fast the full mip chains of the PNG textures in "Source/Textures" get
+	// built, with the box and the Kaiser filter, on one thread and on a thread pool, and
+	// logs the results
+	void RunMipChainBenchmarks();
+}
\ No newline at end of file
@@ -0,0 +1,464 @@
+#include "NoiseBenchmarks.h"
+#include "../Noise/PerlinNoise.h"
+#include "../Noise/ValueNoise.h"
+#include "../Noise/NoiseTableRegistry.h"
+#include "../Threading/ThreadPool.h"
+#include "../CelestialBody/FaceGridNoise.h"
+#include "../Console/Log.h"
+#include "../Timer.h"
+#include <array>
+#include <iomanip>
+#include <numeric>
+#include <limits>
+
+namespace
+{
+	// The seed of all the tables. The golden values below are only valid for this seed.
+	constexpr unsigned int SEED = 1234;
+
+	// The amount of samples per measurement
+	constexpr size_t N_SAMPLES = 1 << 18;
+
+	// Every measurement is repeated, and the fastest repetition is the one that gets
+	// reported, since it is the one that got disturbed the least by the rest of the system
+	constexpr int N_REPETITIONS = 5;
+
+	// The random positions are spread out over this many lattice cells along each axis
+	constexpr float RANDOM_POSITION_RANGE = 4096.0f;
+
+	// The amount of samples that a task of the thread pool evaluates
+	constexpr size_t N_SAMPLES_PER_TASK = 4096;
+
+	// Written to after every measurement, so that the compiler can not
+	// optimize away the noise evaluations whose results we never read
+	volatile float gSink = 0.0f;
+
+	enum class AccessPattern
+	{
+		// The positions form a raster, like the texels of a texture, which means that
+		// consecutive samples mostly fall inside the same lattice cell
+		Coherent,
+		// The positions are scattered over thousands of lattice cells, which means that
+		// consecutive samples read unrelated parts of the tables
+		Random
+	};
+
+	// The positions are returned as a structure of arrays, i.e., "positions[i][j]"
+	// is the i-th coordinate of the j-th position
+	template<int N>
+	std::array<std::vector<float>, N> GetPositions(const AccessPattern accessPattern, const size_t count)
+	{
+		std::array<std::vector<float>, N> positions;
+		positions.fill(std::vector<float>(count));
+
+		if (accessPattern == AccessPattern::Coherent)
+		{
+			// 512 samples per row and 16 samples per lattice cell along each axis
+			const size_t rowLength = 512;
+			const float step = 1.0f / 16.0f;
+			for (size_t j = 0; j < count; ++j)
+			{
+				positions[0][j] = (float)(j % rowLength) * step;
+				positions[1][j] = (float)(j / rowLength) * step;
+				for (int i = 2; i < N; ++i)
+				{
+					positions[i][j] = 0.5f;
+				}
+			}
+		}
+		else
+		{
+			std::mt19937 randomNumberEngine(SEED);
+			for (size_t j = 0; j < count; ++j)
+			{
+				for (int i = 0; i < N; ++i)
+				{
+					positions[i][j] = (float)(randomNumberEngine() >> 8) / 16777216.0f * RANDOM_POSITION_RANGE;
+				}
+			}
+		}
+
+		return positions;
+	}
+
+	template<int N>
+	BasicVector<float, N> GetPosition(const std::array<std::vector<float>, N>& positions, const size_t index)
+	{
+		BasicVector<float, N> position;
+		for (int i = 0; i < N; ++i)
+		{
+			position[i] = positions[i][index];
+		}
+		return position;
+	}
+
+	template<int N>
+	std::array<const float*, N> GetPointersToCoordinates(const std::array<std::vector<float>, N>& positions,
+		const size_t offset = 0)
+	{
+		std::array<const float*, N> coordinates;
+		for (int i = 0; i < N; ++i)
+		{
+			coordinates[i] = positions[i].data() + offset;
+		}
+		return coordinates;
+	}
+
+	// Returns the time, in nanoseconds, that "evaluate" spent per sample, for
+	// the fastest of "N_REPETITIONS" calls. "evaluate" should write the results
+	// of the "count" samples to "output".
+	template<class F>
+	double MeasureNanosecondsPerSample(const size_t count, std::vector<float>& output, const F& evaluate)
+	{
+		Timer timer;
+		double fastestSeconds = std::numeric_limits<double>::max();
+		for (int i = 0; i < N_REPETITIONS; ++i)
+		{
+			// Restart the timer
+			timer.Time();
+			evaluate();
+			fastestSeconds = std::min(fastestSeconds, timer.Time());
+		}
+
+		gSink = gSink + std::accumulate(output.begin(), output.end(), 0.0f);
+
+		return fastestSeconds * 1e+9 / (double)count;
+	}
+
+	struct NanosecondsPerSample
+	{
+		double coherent = 0.0;
+		double random = 0.0;
+	};
+
+	void LogRow(const std::string& noise, const int nDimensions, const int nRandomValues,
+		const NanosecondsPerSample& nanosecondsPerSample)
+	{
+		LOG(std::left << std::setw(22) << noise << std::right
+			<< std::setw(4) << nDimensions
+			<< std::setw(9) << nRandomValues
+			<< std::fixed << std::setprecision(1)
+			<< std::setw(12) << nanosecondsPerSample.coherent
+			<< std::setw(12) << nanosecondsPerSample.random
+			<< std::setprecision(2)
+			<< std::setw(18) << nanosecondsPerSample.random / nanosecondsPerSample.coherent
+			<< std::defaultfloat << std::endl);
+	}
+
+	// Measures and logs all the noise templates for one combination of dimension and table size
+	template<int N, int N_RANDOM_VALUES>
+	void BenchmarkNoise()
+	{
+		auto permutationTable = NoiseTableRegistry::Get().GetPermutationTable<N_RANDOM_VALUES>(SEED);
+		auto randomValues = NoiseTableRegistry::Get().GetRandomValueTable<N_RANDOM_VALUES>(SEED);
+		const PerlinNoise<N, N_RANDOM_VALUES> perlinNoise(permutationTable);
+		const ValueNoise<N, N_RANDOM_VALUES> valueNoise(randomValues, permutationTable);
+
+		NanosecondsPerSample perlin;
+		NanosecondsPerSample batchedPerlin;
+		NanosecondsPerSample value;
+
+		std::vector<float> output(N_SAMPLES);
+		for (const AccessPattern accessPattern : { AccessPattern::Coherent, AccessPattern::Random })
+		{
+			const auto positions = GetPositions<N>(accessPattern, N_SAMPLES);
+			const bool coherent = accessPattern == AccessPattern::Coherent;
+
+			(coherent ? perlin.coherent : perlin.random) = MeasureNanosecondsPerSample(N_SAMPLES, output,
+				[&]()
+				{
+					for (size_t j = 0; j < N_SAMPLES; ++j)
+					{
+						output[j] = perlinNoise.Get(GetPosition<N>(positions, j));
+					}
+				});
+
+			(coherent ? batchedPerlin.coherent : batchedPerlin.random) = MeasureNanosecondsPerSample(N_SAMPLES, output,
+				[&]()
+				{
+					perlinNoise.Get(GetPointersToCoordinates<N>(positions), output.data(), N_SAMPLES);
+				});
+
+			(coherent ? value.coherent : value.random) = MeasureNanosecondsPerSample(N_SAMPLES, output,
+				[&]()
+				{
+					for (size_t j = 0; j < N_SAMPLES; ++j)
+					{
+						output[j] = valueNoise.Get(GetPosition<N>(positions, j));
+					}
+				});
+		}
+
+		LogRow("PerlinNoise", N, N_RANDOM_VALUES, perlin);
+		LogRow("PerlinNoise (batched)", N, N_RANDOM_VALUES, batchedPerlin);
+		LogRow("ValueNoise", N, N_RANDOM_VALUES, value);
+	}
+
+	template<int N>
+	void BenchmarkTableSizes()
+	{
+		// 256 random values is what the game uses. The tables of the larger sizes no
+		// longer fit inside the L1 cache (and eventually not inside the L2 cache either),
+		// which shows up as a growing random / coherent ratio.
+		BenchmarkNoise<N, 16>();
+		BenchmarkNoise<N, 256>();
+		BenchmarkNoise<N, 4096>();
+		BenchmarkNoise<N, 65536>();
+	}
+
+	void BenchmarkThreadCounts()
+	{
+		auto permutationTable = NoiseTableRegistry::Get().GetPermutationTable<256>(SEED);
+		const PerlinNoise<2> perlinNoise(permutationTable);
+
+		// More samples than for the other measurements, so that every thread gets plenty of tasks
+		const size_t nSamples = N_SAMPLES * 8;
+		const auto positions = GetPositions<2>(AccessPattern::Random, nSamples);
+		std::vector<float> output(nSamples);
+
+		LOG(std::left << std::setw(22) << "Noise" << std::right << std::setw(9) << "Threads"
+			<< std::setw(12) << "ns/sample" << std::setw(10) << "Speedup" << std::endl);
+
+		const unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		double singleThreadedNanosecondsPerSample = 0.0;
+		for (unsigned int nThreads = 1; ; nThreads = std::min(nThreads * 2, maxThreads))
+		{
+			ThreadPool threadPool(nThreads);
+
+			const double nanosecondsPerSample = MeasureNanosecondsPerSample(nSamples, output,
+				[&]()
+				{
+					std::vector<std::future<void>> futures;
+					for (size_t offset = 0; offset < nSamples; offset += N_SAMPLES_PER_TASK)
+					{
+						futures.push_back(threadPool.Submit(
+							[&, offset]()
+							{
+								perlinNoise.Get(GetPointersToCoordinates<2>(positions, offset), output.data() + offset,
+									std::min(N_SAMPLES_PER_TASK, nSamples - offset));
+							}));
+					}
+					std::for_each(futures.begin(), futures.end(),
+						[](std::future<void>& future)
+						{
+							future.get();
+						});
+				});
+
+			if (nThreads == 1)
+			{
+				singleThreadedNanosecondsPerSample = nanosecondsPerSample;
+			}
+
+			LOG(std::left << std::setw(22) << "PerlinNoise (batched)" << std::right
+				<< std::setw(9) << nThreads
+				<< std::fixed << std::setprecision(2)
+				<< std::setw(12) << nanosecondsPerSample
+				<< std::setw(10) << singleThreadedNanosecondsPerSample / nanosecondsPerSample
+				<< std::defaultfloat << std::endl);
+
+			if (nThreads == maxThreads)
+			{
+				return;
+			}
+		}
+	}
+
+	// The front face of a celestial body with the same resolution as the ones in the game
+	FaceGrid GetFrontFaceGrid()
+	{
+		const float cellSideLength = 0.02f;
+		const int sideLengthInCells = (int)(2.0f / cellSideLength);
+		return FaceGrid{ { -1.0f, -1.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+			2.0f / (float)sideLengthInCells, sideLengthInCells };
+	}
+
+	void BenchmarkFaceGrid()
+	{
+		const FaceGridNoise faceGridNoise(NoiseTableRegistry::Get().GetPermutationTable<256>(SEED));
+		const FaceGrid grid = GetFrontFaceGrid();
+		const size_t nPoints = (size_t)grid.GetSideLengthInPoints() * grid.GetSideLengthInPoints();
+
+		LOG("Single octave perlin noise over a face grid of " << nPoints << " points" << std::endl);
+		LOG(std::right << std::setw(10) << "Frequency" << std::setw(12) << "Uncached" << std::setw(12) << "Cached"
+			<< std::setw(16) << "Hashed cells" << std::setw(26) << "Skipped corner hashes" << std::endl);
+
+		// 1.7 and 2 are the frequencies of the mountains and the rough
+		// terrain of the celestial bodies. The higher frequencies show where
+		// the caching stops paying off.
+		for (const float frequency : { 1.7f, 2.0f, 8.0f, 32.0f, 128.0f })
+		{
+			// Measured outside of the timed runs, so that it only counts one evaluation
+			PerlinNoise<3>::CellCacheStatistics statistics;
+			faceGridNoise.GetFractalNoise(grid, 1, frequency, true, statistics);
+
+			std::vector<float> noise;
+			PerlinNoise<3>::CellCacheStatistics ignoredStatistics;
+			const double uncachedNanosecondsPerSample = MeasureNanosecondsPerSample(nPoints, noise,
+				[&]()
+				{
+					noise = faceGridNoise.GetFractalNoise(grid, 1, frequency, false, ignoredStatistics);
+				});
+			const double cachedNanosecondsPerSample = MeasureNanosecondsPerSample(nPoints, noise,
+				[&]()
+				{
+					noise = faceGridNoise.GetFractalNoise(grid, 1, frequency, true, ignoredStatistics);
+				});
+
+			const size_t nCells = statistics.nHashedCells + statistics.nReusedCells;
+			// Every reused cell skips hashing its 8 corners
+			const size_t nSkippedCornerHashes = statistics.nReusedCells * 8;
+
+			LOG(std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << frequency
+				<< std::setw(12) << uncachedNanosecondsPerSample
+				<< std::setw(12) << cachedNanosecondsPerSample
+				<< std::setw(15) << 100.0 * (double)statistics.nHashedCells / (double)nCells << "%"
+				<< std::setw(16) << nSkippedCornerHashes << " of " << std::setw(6) << nCells * 8
+				<< std::defaultfloat << std::endl);
+		}
+	}
+
+	// vvv Golden values vvv
+
+	// The golden values were generated with "SEED" and tables of 256 random values.
+	// Each row contains the results for the positions returned by "GetGoldenPosition".
+	constexpr int N_GOLDEN_POSITIONS = 8;
+	constexpr float PERLIN_GOLDEN_VALUES[3][N_GOLDEN_POSITIONS] =
+	{
+		{ 0.426757812f, 0.66809082f, 0.295288086f, 0.4375f, 0.506469727f, 0.450439453f, 0.407576084f, 0.538818359f },
+		{ 0.612060547f, 0.577575684f, 0.158688068f, 0.471984863f, 0.239888191f, 0.375f, 0.465121269f, 0.612060547f },
+		{ 0.251821041f, 0.66686511f, 0.45652321f, 0.72088623f, 0.320081711f, 0.51940918f, 0.756888449f, 0.612060547f }
+	};
+	constexpr float VALUE_GOLDEN_VALUES[3][N_GOLDEN_POSITIONS] =
+	{
+		{ 0.133558914f, 0.286508501f, 0.617819011f, 0.46997869f, 0.491255462f, 0.762331128f, 0.504536152f, 0.0923495591f },
+		{ 0.591010451f, 0.506367862f, 0.597368062f, 0.683307886f, 0.824167728f, 0.539571166f, 0.548478127f, 0.513341904f },
+		{ 0.733884513f, 0.488060653f, 0.598766804f, 0.623234928f, 0.389445275f, 0.397765845f, 0.766756594f, 0.440813214f }
+	};
+
+	// The results may differ in the last bits between compilers, since they are allowed
+	// to, for example, contract a multiplication and an addition into one instruction
+	constexpr float GOLDEN_VALUE_TOLERANCE = 1e-5f;
+
+	// The positions include negative coordinates and coordinates that lie exactly on
+	// the lattice, since those are the cases where the flooring and the wrapping of
+	// the coordinates are the easiest to get wrong
+	template<int N>
+	BasicVector<float, N> GetGoldenPosition(const int index)
+	{
+		BasicVector<float, N> position;
+		for (int i = 0; i < N; ++i)
+		{
+			position[i] = (float)((index * 7 + i * 3) % 11) * 0.75f - 3.0f + (float)index * 41.0f;
+		}
+		return position;
+	}
+
+	bool IsEqual(const float value, const float goldenValue)
+	{
+		return std::abs(value - goldenValue) <= GOLDEN_VALUE_TOLERANCE;
+	}
+
+	template<int N>
+	bool VerifyGoldenValues()
+	{
+		// Enough digits to be able to paste the logged values back into the tables above
+		LOG(std::setprecision(9));
+
+		auto permutationTable = NoiseTableRegistry::Get().GetPermutationTable<256>(SEED);
+		auto randomValues = NoiseTableRegistry::Get().GetRandomValueTable<256>(SEED);
+		const PerlinNoise<N> perlinNoise(permutationTable);
+		const ValueNoise<N> valueNoise(randomValues, permutationTable);
+
+		std::array<std::vector<float>, N> positions;
+		positions.fill(std::vector<float>(N_GOLDEN_POSITIONS));
+		for (int j = 0; j < N_GOLDEN_POSITIONS; ++j)
+		{
+			const BasicVector<float, N> position = GetGoldenPosition<N>(j);
+			for (int i = 0; i < N; ++i)
+			{
+				positions[i][j] = position[i];
+			}
+		}
+		std::vector<float> batchedPerlinValues(N_GOLDEN_POSITIONS);
+		perlinNoise.Get(GetPointersToCoordinates<N>(positions), batchedPerlinValues.data(), N_GOLDEN_POSITIONS);
+
+		bool succeeded = true;
+		for (int j = 0; j < N_GOLDEN_POSITIONS; ++j)
+		{
+			const BasicVector<float, N> position = GetGoldenPosition<N>(j);
+			const float perlinValue = perlinNoise.Get(position);
+			const float valueNoiseValue = valueNoise.Get(position);
+
+			if (!IsEqual(perlinValue, PERLIN_GOLDEN_VALUES[N - 2][j]))
+			{
+				LOG("PerlinNoise<" << N << "> at position " << j << " returned " << perlinValue
+					<< ", expected " << PERLIN_GOLDEN_VALUES[N - 2][j] << std::endl);
+				succeeded = false;
+			}
+			// The batched "Get" is supposed to give exactly the same results, on any compiler
+			if (batchedPerlinValues[j] != perlinValue)
+			{
+				LOG("The batched PerlinNoise<" << N << "> at position " << j << " returned "
+					<< batchedPerlinValues[j] << ", expected " << perlinValue << std::endl);
+				succeeded = false;
+			}
+			if (!IsEqual(valueNoiseValue, VALUE_GOLDEN_VALUES[N - 2][j]))
+			{
+				LOG("ValueNoise<" << N << "> at position " << j << " returned " << valueNoiseValue
+					<< ", expected " << VALUE_GOLDEN_VALUES[N - 2][j] << std::endl);
+				succeeded = false;
+			}
+		}
+
+		LOG(std::setprecision(6));
+		return succeeded;
+	}
+
+	// ^^^ Golden values ^^^
+}
+
+namespace microbenchmark
+{
+	bool VerifyNoiseGoldenValues()
+	{
+		// Verify all the dimensions, even if an earlier one fails, so that all
+		// the mismatches get logged
+		const bool succeeded2 = VerifyGoldenValues<2>();
+		const bool succeeded3 = VerifyGoldenValues<3>();
+		const bool succeeded4 = VerifyGoldenValues<4>();
+
+		// The cell cache is supposed to give exactly the same results as the batched "Get"
+		bool succeededCellCache = true;
+		const FaceGridNoise faceGridNoise(NoiseTableRegistry::Get().GetPermutationTable<256>(SEED));
+		PerlinNoise<3>::CellCacheStatistics statistics;
+		if (faceGridNoise.GetFractalNoise(GetFrontFaceGrid(), 4, 2.0f, true, statistics)
+			!= faceGridNoise.GetFractalNoise(GetFrontFaceGrid(), 4, 2.0f, false, statistics))
+		{
+			LOG("The cell cached PerlinNoise<3> does not match the batched PerlinNoise<3>" << std::endl);
+			succeededCellCache = false;
+		}
+
+		return succeeded2 && succeeded3 && succeeded4 && succeededCellCache;
+	}
+
+	void RunNoiseBenchmarks()
+	{
+		LOG("Samples per measurement: " << N_SAMPLES << ", fastest of " << N_REPETITIONS
+			<< " repetitions" << std::endl);
+		LOG(std::left << std::setw(22) << "Noise" << std::right << std::setw(4) << "N"
+			<< std::setw(9) << "Values" << std::setw(12) << "Coherent" << std::setw(12) << "Random"
+			<< std::setw(18) << "Random/Coherent" << std::endl);
+
+		BenchmarkTableSizes<2>();
+		BenchmarkTableSizes<3>();
+		BenchmarkTableSizes<4>();
+
+		LOG(std::endl);
+		BenchmarkThreadCounts();
+
+		LOG(std::endl);
+		BenchmarkFaceGrid();
+	}
+}
\ No newline at end of file
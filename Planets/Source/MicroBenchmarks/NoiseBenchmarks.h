@@ -0,0 +1,14 @@
+#pragma once
+
+namespace microbenchmark
+{
+	// Evaluates the noise templates, created with fixed seeds, at fixed positions and
+	// compares the results with golden values. Every mismatch gets logged. Returns
+	// false if there was at least one mismatch.
+	bool VerifyNoiseGoldenValues();
+
+	// Measures the time per sample of the noise templates for a range of dimensions,
+	// table sizes ("N_RANDOM_VALUES"), access patterns and thread counts, and logs
+	// the results
+	void RunNoiseBenchmarks();
+}
\ No newline at end of file
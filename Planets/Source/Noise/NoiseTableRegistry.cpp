@@ -0,0 +1,7 @@
+#include "NoiseTableRegistry.h"
+
+NoiseTableRegistry& NoiseTableRegistry::Get()
+{
+	static NoiseTableRegistry instance;
+	return instance;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "PermutationTable.h"
+#include "RandomValueTable.h"
+#include <map>
+#include <mutex>
+
+// Singleton. Hands out the permutation tables and random value tables, so that everyone
+// who asks for a table with the same seed and size shares the same (immutable) instance.
+// The tables are seeded, which makes the noise identical between runs.
+class NoiseTableRegistry
+{
+public:
+	// Thread-safe
+	static NoiseTableRegistry& Get();
+
+	// Thread-safe
+	template<int N>
+	std::shared_ptr<const PermutationTable<N>> GetPermutationTable(const unsigned int seed)
+	{
+		return GetTable<PermutationTable<N>>(mPermutationTables, seed, N);
+	}
+	// Thread-safe
+	template<int N>
+	std::shared_ptr<const RandomValueTable<N>> GetRandomValueTable(const unsigned int seed)
+	{
+		return GetTable<RandomValueTable<N>>(mRandomValueTables, seed, N);
+	}
+
+	// The seed that the game uses for all of its noise
+	static constexpr unsigned int DEFAULT_SEED = 1234;
+private:
+	NoiseTableRegistry() = default;
+
+	// The key is the seed and the size of the table
+	using Tables = std::map<std::pair<unsigned int, int>, std::shared_ptr<const void>>;
+
+	template<class T>
+	std::shared_ptr<const T> GetTable(Tables& tables, const unsigned int seed, const int size)
+	{
+		std::lock_guard lockGuard(mMutex);
+
+		std::shared_ptr<const void>& table = tables[{ seed, size }];
+		if (!table)
+		{
+			// Create the table the first time somebody asks for it
+			table = std::shared_ptr<const T>(std::make_shared<T>(seed));
+		}
+
+		return std::static_pointer_cast<const T>(table);
+	}
+private:
+	std::mutex mMutex;
+	Tables mPermutationTables;
+	Tables mRandomValueTables;
+};
\ No newline at end of file
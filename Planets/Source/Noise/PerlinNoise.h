@@ -4,6 +4,7 @@
 #include "../Mathematics/Algorithms.h"
 #include "PermutationTable.h"
 #include "../CustomConcepts.h"
+#include <array>
 
 // "VECTOR_SIZE" is the dimension of the diagonal pointing vectors. In order to not
 // make the amount of diagonal vectors too few, we make sure that the value is at least 3.
@@ -14,12 +15,13 @@ requires(IsPowerOfTwo(N_RANDOM_VALUES))
 class PerlinNoise
 {
 public:
-	PerlinNoise(const std::shared_ptr<PermutationTable<N_RANDOM_VALUES>> permutationTable)
+	PerlinNoise(const std::shared_ptr<const PermutationTable<N_RANDOM_VALUES>> permutationTable)
 		:
 		mPermutationTable(permutationTable)
 	{
 		InitializeCornerOffets();
 		InitializeDiagonalVectors();
+		InitializeBatchData();
 	}
 
 	float Get(const BasicVector<float, N>& position) const
@@ -73,6 +75,144 @@ public:
 		// and 1 by first adding 1 to the value and then dividing the result by 2.
 		return (Interpolate(cornerValues, interpolationAmounts) + 1.0f) / 2.0f;
 	}
+
+	// Evaluates the noise at "count" positions at once. The positions are passed as a
+	// structure of arrays, i.e., "coordinates[i][j]" is the i-th coordinate of the j-th
+	// position. The results are identical to calling the above "Get" once per position,
+	// but the loop only works on plain floats and integers, which removes the per sample
+	// overhead of the vector class and lets the compiler keep everything in registers.
+	void Get(const std::array<const float*, N>& coordinates, float* const output, const size_t count) const
+	{
+		const auto* const permutationTable = mPermutationTable->GetPointerToData();
+		const size_t nDiagonalVectors = mDiagonalVectors.size();
+
+		for (size_t j = 0; j < count; ++j)
+		{
+			int location[N];
+			float toPosition[N];
+			float interpolationAmounts[N];
+			for (int i = 0; i < N; ++i)
+			{
+				const float value = coordinates[i][j];
+				location[i] = (int)std::floor(value);
+				toPosition[i] = value - (float)location[i];
+				interpolationAmounts[i] = Smoothstep(toPosition[i]);
+			}
+
+			float cornerValues[N_CORNERS];
+			for (int c = 0; c < N_CORNERS; ++c)
+			{
+				const int* const cornerOffset = mBatchCornerOffsets[c];
+
+				// Hash the corner location, in the same way as "GetRandomIndex"
+				size_t index = 0;
+				for (int i = 0; i < N; ++i)
+				{
+					index = permutationTable[((location[i] + cornerOffset[i]) & (N_RANDOM_VALUES - 1)) + index];
+				}
+
+				// Take the dot product between the diagonal vector and the vector pointing from the
+				// corner to the position. The elements beyond "N" are zero, just like the elements
+				// of "cornerToPositionSizeCorrected" inside "Get".
+				const float* const diagonalVector = &mBatchDiagonalVectors[(index % nDiagonalVectors) * VECTOR_SIZE];
+				float dot = 0.0f;
+				for (int i = 0; i < VECTOR_SIZE; ++i)
+				{
+					dot += diagonalVector[i] * (i < N ? toPosition[i] - (float)cornerOffset[i] : 0.0f);
+				}
+				cornerValues[c] = dot;
+			}
+
+			output[j] = (Interpolate(cornerValues, interpolationAmounts) + 1.0f) / 2.0f;
+		}
+	}
+
+	// Counts how many lattice cells "GetUsingCellCache" had to hash, and how many
+	// it could reuse from its cache
+	struct CellCacheStatistics
+	{
+		size_t nHashedCells = 0;
+		size_t nReusedCells = 0;
+	};
+
+	// The same as the batched "Get", but made for coherent positions, e.g., the points of a
+	// grid, walked tile by tile. At low frequencies, many consecutive positions fall inside
+	// the same lattice cell. The diagonal vectors of a cell's corners are therefore cached,
+	// so that the corners only get hashed the first time a cell is visited. The results
+	// are identical to the batched "Get".
+	void GetUsingCellCache(const std::array<const float*, N>& coordinates, float* const output,
+		const size_t count, CellCacheStatistics& statistics) const
+	{
+		struct CachedCell
+		{
+			int location[N] = {};
+			bool isValid = false;
+			// Points to the diagonal vector of each corner of the cell
+			const float* diagonalVectors[N_CORNERS] = {};
+		};
+		// A direct mapped cache, i.e., every cell can only be stored in one of the slots
+		CachedCell cache[CELL_CACHE_SIZE];
+
+		const auto* const permutationTable = mPermutationTable->GetPointerToData();
+		const size_t nDiagonalVectors = mDiagonalVectors.size();
+
+		for (size_t j = 0; j < count; ++j)
+		{
+			int location[N];
+			float toPosition[N];
+			float interpolationAmounts[N];
+			// Combines the elements of the location into the index of the cache slot
+			unsigned int slot = 0;
+			for (int i = 0; i < N; ++i)
+			{
+				const float value = coordinates[i][j];
+				location[i] = (int)std::floor(value);
+				toPosition[i] = value - (float)location[i];
+				interpolationAmounts[i] = Smoothstep(toPosition[i]);
+				slot = slot * 31u + (unsigned int)location[i];
+			}
+
+			CachedCell& cell = cache[slot & (CELL_CACHE_SIZE - 1)];
+			if (cell.isValid && std::equal(location, location + N, cell.location))
+			{
+				++statistics.nReusedCells;
+			}
+			else
+			{
+				++statistics.nHashedCells;
+
+				std::copy(location, location + N, cell.location);
+				cell.isValid = true;
+				for (int c = 0; c < N_CORNERS; ++c)
+				{
+					const int* const cornerOffset = mBatchCornerOffsets[c];
+
+					// Hash the corner location, in the same way as "GetRandomIndex"
+					size_t index = 0;
+					for (int i = 0; i < N; ++i)
+					{
+						index = permutationTable[((location[i] + cornerOffset[i]) & (N_RANDOM_VALUES - 1)) + index];
+					}
+					cell.diagonalVectors[c] = &mBatchDiagonalVectors[(index % nDiagonalVectors) * VECTOR_SIZE];
+				}
+			}
+
+			float cornerValues[N_CORNERS];
+			for (int c = 0; c < N_CORNERS; ++c)
+			{
+				const int* const cornerOffset = mBatchCornerOffsets[c];
+				const float* const diagonalVector = cell.diagonalVectors[c];
+				float dot = 0.0f;
+				for (int i = 0; i < VECTOR_SIZE; ++i)
+				{
+					dot += diagonalVector[i] * (i < N ? toPosition[i] - (float)cornerOffset[i] : 0.0f);
+				}
+				cornerValues[c] = dot;
+			}
+
+			output[j] = (Interpolate(cornerValues, interpolationAmounts) + 1.0f) / 2.0f;
+		}
+	}
 private:
 	float GetPerlinValue(const size_t index, const BasicVector<float, VECTOR_SIZE>& cornerToPosition) const
 	{
@@ -80,10 +220,15 @@ private:
 		return mDiagonalVectors[index % mDiagonalVectors.size()].Dot(cornerToPosition);
 	}
 	float Interpolate(float* cornerValues, const BasicVector<float, N>& interpolationAmounts) const
+	{
+		return Interpolate(cornerValues, interpolationAmounts.GetPointerToData());
+	}
+	float Interpolate(float* cornerValues, const float* interpolationAmounts) const
 	{
 		auto end = cornerValues + N_CORNERS;
-		for(auto interpolationAmount : interpolationAmounts)
+		for (int i = 0; i < N; ++i)
 		{
+			const float interpolationAmount = interpolationAmounts[i];
 			auto currentDestination = cornerValues;
 			for (auto iterator = cornerValues; iterator != end; std::advance(iterator, 2), ++currentDestination)
 			{
@@ -185,6 +330,19 @@ private:
 			}
 		}
 	}
+	void InitializeBatchData()
+	{
+		// The batched "Get" reads the corner offsets and the diagonal vectors
+		// as plain arrays, so we copy them out of the vector classes once
+		for (int i = 0; i < N_CORNERS; ++i)
+		{
+			std::copy(mCornerOffsets[i].begin(), mCornerOffsets[i].end(), mBatchCornerOffsets[i]);
+		}
+		for (const auto& diagonalVector : mDiagonalVectors)
+		{
+			mBatchDiagonalVectors.insert(mBatchDiagonalVectors.end(), diagonalVector.begin(), diagonalVector.end());
+		}
+	}
 	bool GetBit(unsigned char number, int bitIndex) const
 	{
 		// Make sure that the "bitIndex" does not exceed the 
@@ -197,12 +355,21 @@ private:
 private:
 	static constexpr size_t N_CORNERS = Power(2, N);
 
+	// The amount of lattice cells that "GetUsingCellCache" remembers. A tile of a
+	// grid rarely spans more than a handful of cells, at the frequencies where
+	// caching pays off.
+	static constexpr unsigned int CELL_CACHE_SIZE = 64;
+
 	// Store the permutation table as a shared pointer so that we do not have to
 	// allocate a permutation table for every instance of this class. Instances of
 	// PerlinNoise<2> and PerlinNoise<3> can now for example share the same
 	// permutation table.
-	std::shared_ptr<PermutationTable<N_RANDOM_VALUES>> mPermutationTable;
+	std::shared_ptr<const PermutationTable<N_RANDOM_VALUES>> mPermutationTable;
 
 	std::vector<BasicVector<int, N>> mCornerOffsets;
 	std::vector<BasicVector<float, VECTOR_SIZE>> mDiagonalVectors;
+
+	// The same data as above, stored without the vector classes, for the batched "Get"
+	int mBatchCornerOffsets[N_CORNERS][N] = {};
+	std::vector<float> mBatchDiagonalVectors;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <random>
+#include <type_traits>
 
 template<class T, int N>
 class BasicPermutationTable
@@ -17,6 +18,19 @@ public:
 				return (T)distributor(randomNumberEngine);
 			});
 	}
+	// Creates the same table for the same seed, on every platform. The standard
+	// distributions are implementation-defined, hence we use the output of the engine
+	// directly. Since N is a power of two, the %-operator does not introduce a bias.
+	explicit BasicPermutationTable(const unsigned int seed)
+	{
+		std::mt19937 randomNumberEngine(seed);
+
+		std::generate(std::begin(mPermutationTable), std::end(mPermutationTable),
+			[&]()
+			{
+				return (T)(randomNumberEngine() % N);
+			});
+	}
 	T operator[](const size_t index) const
 	{
 		assert(index >= 0 && index < Size());
@@ -34,9 +48,12 @@ private:
 	// Contains random indices that ranges from 0 to N - 1. The input into the 
 	// table is the sum of two values that both range between 0 to N - 1 and therefore 
 	// has a maximum value of N - 1 + N - 1 = N * 2 - 2. 
-	// The table therefore needs a size of N * 2 - 1 (including the value 0).
-	T mPermutationTable[N * 2 - 1];
+	// The table therefore needs a size of N * 2 - 1 (including the value 0). The table
+	// starts at a cache line boundary, so that small tables occupy as few cache lines as possible.
+	alignas(64) T mPermutationTable[N * 2 - 1];
 };
 
+// The indices range from 0 to N - 1, so tables with more than 256 random
+// values need more than one byte per index
 template<int N>
-using PermutationTable = BasicPermutationTable<unsigned char, N>;
\ No newline at end of file
+using PermutationTable = BasicPermutationTable<std::conditional_t<(N <= 256), unsigned char, unsigned short>, N>;
\ No newline at end of file
@@ -14,11 +14,26 @@ public:
 		std::generate(std::begin(mRandomValues), std::end(mRandomValues),
 			std::bind(distributor, std::ref(randomNumberEngine)));
 	}
+	// Creates the same table for the same seed, on every platform. The standard
+	// distributions are implementation-defined, hence we turn the 24 highest bits
+	// of the engine's output into a float ranging from 0 to 1 ourselves.
+	explicit RandomValueTable(const unsigned int seed)
+	{
+		std::mt19937 randomNumberEngine(seed);
+
+		std::generate(std::begin(mRandomValues), std::end(mRandomValues),
+			[&]()
+			{
+				return (float)(randomNumberEngine() >> 8) / 16777216.0f;
+			});
+	}
 	float operator[](const size_t index) const
 	{
 		assert(index >= 0 && index < N);
 		return mRandomValues[index];
 	}
 private:
-	float mRandomValues[N];
+	// The table starts at a cache line boundary, so that small
+	// tables occupy as few cache lines as possible
+	alignas(64) float mRandomValues[N];
 };
\ No newline at end of file
@@ -13,8 +13,8 @@ requires(IsPowerOfTwo(N_RANDOM_VALUES))
 class ValueNoise
 {
 public:
-	ValueNoise(const std::shared_ptr<RandomValueTable<N_RANDOM_VALUES>> randomValues, 
-		const std::shared_ptr<PermutationTable<N_RANDOM_VALUES>> permutationTable)
+	ValueNoise(const std::shared_ptr<const RandomValueTable<N_RANDOM_VALUES>> randomValues, 
+		const std::shared_ptr<const PermutationTable<N_RANDOM_VALUES>> permutationTable)
 		:
 		mRandomValues(randomValues),
 		mPermutationTable(permutationTable)
@@ -139,8 +139,8 @@ private:
 	// allocate a new permutation table and new random values for every instance of this class. Instances of
 	// ValueNoise<2> and ValueNoise<3> can now for example share the same
 	// permutation table and random values.
-	std::shared_ptr<RandomValueTable<N_RANDOM_VALUES>> mRandomValues;
-	std::shared_ptr<PermutationTable<N_RANDOM_VALUES>> mPermutationTable;
+	std::shared_ptr<const RandomValueTable<N_RANDOM_VALUES>> mRandomValues;
+	std::shared_ptr<const PermutationTable<N_RANDOM_VALUES>> mPermutationTable;
 
 	std::vector<BasicVector<int, N>> mCornerOffsets;
 };
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "AssetCache.h"
+#include "../Console/Log.h"
+
+AssetCache::AssetCache(const size_t vramBudget)
+	:
+	mVramBudget(vramBudget)
+{
+	// There should only be one instance of this class
+	assert(!msAssetCache);
+	msAssetCache = this;
+}
+
+AssetCache::~AssetCache()
+{
+	msAssetCache = nullptr;
+}
+
+AssetCache& AssetCache::Get()
+{
+	assert(msAssetCache);
+	return *msAssetCache;
+}
+
+std::shared_ptr<const Texture> AssetCache::GetTexture(const std::string& name, const TextureKind kind)
+{
+	TextureEntry& entry = mTextures[{ name, kind }];
+	if (entry.texture)
+	{
+		++mStatistics.hits;
+	}
+	else
+	{
+		++mStatistics.misses;
+		entry.texture = std::make_shared<const Texture>(name, kind);
+	}
+
+	entry.lastRequest = ++mRequestCounter;
+	return entry.texture;
+}
+
+std::shared_ptr<const Sampler> AssetCache::GetSampler(const SamplerParameters& parameters)
+{
+	// The samplers hardly use any memory, so they are never evicted
+	std::shared_ptr<const Sampler>& sampler = mSamplers[parameters];
+	if (sampler)
+	{
+		++mStatistics.hits;
+	}
+	else
+	{
+		++mStatistics.misses;
+		sampler = std::make_shared<const Sampler>(parameters);
+	}
+
+	return sampler;
+}
+
+void AssetCache::SetVramBudget(const size_t vramBudget)
+{
+	mVramBudget = vramBudget;
+	Update();
+}
+
+void AssetCache::Update()
+{
+	size_t residentBytes = GetResidentBytes();
+	while (residentBytes > mVramBudget)
+	{
+		// Find the least recently requested texture that is only held by the cache
+		auto leastRecentlyRequested = mTextures.end();
+		for (auto it = mTextures.begin(); it != mTextures.end(); ++it)
+		{
+			if (it->second.texture.use_count() == 1 && (leastRecentlyRequested == mTextures.end()
+				|| it->second.lastRequest < leastRecentlyRequested->second.lastRequest))
+			{
+				leastRecentlyRequested = it;
+			}
+		}
+
+		// Every texture is in use, so there is nothing left to evict
+		if (leastRecentlyRequested == mTextures.end())
+		{
+			break;
+		}
+
+		residentBytes -= leastRecentlyRequested->second.texture->GetResidentBytes();
+		mTextures.erase(leastRecentlyRequested);
+		++mStatistics.evictions;
+	}
+}
+
+AssetCache::Statistics AssetCache::GetStatistics() const
+{
+	Statistics statistics = mStatistics;
+	statistics.residentBytes = GetResidentBytes();
+	statistics.nTextures = mTextures.size();
+	statistics.nSamplers = mSamplers.size();
+	return statistics;
+}
+
+void AssetCache::LogStatistics() const
+{
+	const Statistics statistics = GetStatistics();
+	LOG("Asset cache: " << statistics.hits << " hits, " << statistics.misses << " misses, "
+		<< statistics.evictions << " evictions, " << statistics.nTextures << " textures and "
+		<< statistics.nSamplers << " samplers, " << statistics.residentBytes / 1024 << " KiB of "
+		<< mVramBudget / 1024 << " KiB resident" << std::endl);
+}
+
+size_t AssetCache::GetResidentBytes() const
+{
+	size_t residentBytes = 0;
+	for (const auto& [key, entry] : mTextures)
+	{
+		residentBytes += entry.texture->GetResidentBytes();
+	}
+	return residentBytes;
+}
\ No newline at end of file
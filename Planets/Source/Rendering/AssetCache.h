@@ -0,0 +1,73 @@
+#pragma once
+#include "Texture.h"
+#include "Sampler.h"
+#include <map>
+
+// Singleton. Hands out the textures, by name and kind, and the samplers, by parameters,
+// so that everyone who asks for the same texture or sampler shares the same instance,
+// and every PNG image is only decoded and uploaded once. The cache keeps the textures
+// around after their last owner has let go of them, in case somebody asks for them
+// again, for as long as the video memory of the textures stays within the budget.
+// Should only be used by the thread that owns the OpenGL context.
+class AssetCache
+{
+public:
+	struct Statistics
+	{
+		// The number of requests that were, and were not, served by an existing instance
+		size_t hits = 0;
+		size_t misses = 0;
+		// The number of textures that have been evicted to stay within the budget
+		size_t evictions = 0;
+		// The video memory of the cached textures that have finished loading
+		size_t residentBytes = 0;
+		size_t nTextures = 0;
+		size_t nSamplers = 0;
+	};
+
+	// Needs to be constructed after the "TextureLoader"
+	AssetCache(size_t vramBudget = DEFAULT_VRAM_BUDGET);
+	~AssetCache();
+
+	// One should not be able to copy nor move an "AssetCache" instance
+	AssetCache(const AssetCache& other) = delete;
+	AssetCache& operator=(const AssetCache& other) = delete;
+
+	static AssetCache& Get();
+
+	// Returns the texture of the PNG image "Source/Textures/<name>.png", which
+	// is queued for loading by the "TextureLoader" the first time it is asked for
+	std::shared_ptr<const Texture> GetTexture(const std::string& name, TextureKind kind = TextureKind::Colour);
+	std::shared_ptr<const Sampler> GetSampler(const SamplerParameters& parameters);
+
+	// The budget is a soft limit, since a texture that is still in use is never evicted
+	void SetVramBudget(size_t vramBudget);
+
+	// Evicts the least recently requested textures, that nobody but the cache holds on
+	// to, until the resident bytes are within the budget. Should be called once per frame,
+	// since the resident bytes grow whenever the "TextureLoader" uploads a texture.
+	void Update();
+
+	Statistics GetStatistics() const;
+	void LogStatistics() const;
+private:
+	struct TextureEntry
+	{
+		std::shared_ptr<const Texture> texture;
+		// The value of "mRequestCounter" when the texture was last requested
+		size_t lastRequest = 0;
+	};
+
+	size_t GetResidentBytes() const;
+private:
+	std::map<std::pair<std::string, TextureKind>, TextureEntry> mTextures;
+	std::map<SamplerParameters, std::shared_ptr<const Sampler>> mSamplers;
+
+	size_t mVramBudget = 0;
+	size_t mRequestCounter = 0;
+	Statistics mStatistics;
+
+	static inline AssetCache* msAssetCache = nullptr;
+
+	static constexpr size_t DEFAULT_VRAM_BUDGET = 256 * 1024 * 1024;
+};
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "BlockCompression.h"
+#include "../CustomException.h"
+#include <array>
+#include <cmath>
+
+namespace
+{
+	// The 16 pixels of a 4x4 block, in row-major order, each with the channels RGBA
+	using Block = std::array<std::array<unsigned char, 4>, 16>;
+	using Colour = std::array<float, 3>;
+
+	Block GetBlock(const unsigned char* const pixels, const int width, const int height,
+		const int blockX, const int blockY)
+	{
+		Block block;
+		for (int y = 0; y < 4; ++y)
+		{
+			for (int x = 0; x < 4; ++x)
+			{
+				// The blocks along the right and bottom edges may reach outside
+				// the image, in which case the edge pixels are repeated
+				const int pixelX = std::min(blockX * 4 + x, width - 1);
+				const int pixelY = std::min(blockY * 4 + y, height - 1);
+				std::copy_n(&pixels[((size_t)pixelY * width + pixelX) * 4], 4, block[y * 4 + x].data());
+			}
+		}
+		return block;
+	}
+
+	// vvv Colour blocks vvv
+
+	uint16_t ToRgb565(const Colour& colour)
+	{
+		const auto quantize = [](const float value, const int maxValue)
+		{
+			return (uint16_t)std::clamp((int)std::lround(value * (float)maxValue / 255.0f), 0, maxValue);
+		};
+		return (uint16_t)((quantize(colour[0], 31) << 11) | (quantize(colour[1], 63) << 5) | quantize(colour[2], 31));
+	}
+
+	// Expands the colour the same way that the GPU does, i.e., by repeating the high bits
+	Colour FromRgb565(const uint16_t colour)
+	{
+		const int r = colour >> 11;
+		const int g = (colour >> 5) & 63;
+		const int b = colour & 31;
+		return { (float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)) };
+	}
+
+	float GetSquaredDistance(const Colour& colour, const std::array<unsigned char, 4>& pixel)
+	{
+		float squaredDistance = 0.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float difference = colour[i] - (float)pixel[i];
+			squaredDistance += difference * difference;
+		}
+		return squaredDistance;
+	}
+
+	// Picks the closest of the four palette colours for every pixel and
+	// returns the total squared error of the block
+	float ChooseColourIndices(const Block& block, const uint16_t endpoint0, const uint16_t endpoint1,
+		std::array<int, 16>& indices)
+	{
+		const Colour colour0 = FromRgb565(endpoint0);
+		const Colour colour1 = FromRgb565(endpoint1);
+
+		// Index 0 and 1 are the endpoints, while index 2 and 3 lie a third
+		// and two thirds of the way from the first to the second endpoint
+		std::array<Colour, 4> palette = { colour0, colour1 };
+		for (int i = 0; i < 3; ++i)
+		{
+			palette[2][i] = (2.0f * colour0[i] + colour1[i]) / 3.0f;
+			palette[3][i] = (colour0[i] + 2.0f * colour1[i]) / 3.0f;
+		}
+
+		float error = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			float smallestDistance = std::numeric_limits<float>::max();
+			for (int j = 0; j < 4; ++j)
+			{
+				const float distance = GetSquaredDistance(palette[j], block[i]);
+				if (distance < smallestDistance)
+				{
+					smallestDistance = distance;
+					indices[i] = j;
+				}
+			}
+			error += smallestDistance;
+		}
+		return error;
+	}
+
+	// Returns the direction along which the colours of the block vary the most
+	Colour GetPrincipalAxis(const Block& block, const Colour& mean)
+	{
+		// The covariance matrix is symmetric, so we only need 6 of its elements
+		float covariance[3][3] = {};
+		for (const auto& pixel : block)
+		{
+			const Colour difference = { pixel[0] - mean[0], pixel[1] - mean[1], pixel[2] - mean[2] };
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = i; j < 3; ++j)
+				{
+					covariance[i][j] += difference[i] * difference[j];
+				}
+			}
+		}
+		covariance[1][0] = covariance[0][1];
+		covariance[2][0] = covariance[0][2];
+		covariance[2][1] = covariance[1][2];
+
+		// A few iterations of the power method converge well enough on the eigenvector
+		// with the largest eigenvalue, which is the principal axis
+		Colour axis = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			Colour product = {};
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = 0; j < 3; ++j)
+				{
+					product[i] += covariance[i][j] * axis[j];
+				}
+			}
+
+			const float length = std::sqrt(product[0] * product[0] + product[1] * product[1]
+				+ product[2] * product[2]);
+			if (length < 1e-6f)
+			{
+				// All the pixels have (almost) the same colour
+				break;
+			}
+			axis = { product[0] / length, product[1] / length, product[2] / length };
+		}
+		return axis;
+	}
+
+	// Returns the endpoints that minimize the squared error for the given indices, or
+	// false if the indices do not determine the endpoints (e.g., they are all the same)
+	bool FitEndpoints(const Block& block, const std::array<int, 16>& indices, Colour& endpoint0, Colour& endpoint1)
+	{
+		// How much of the first endpoint that the palette colour of every index consists of
+		constexpr float WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		// The normal equations of the least squares problem
+		float alphaAlpha = 0.0f;
+		float alphaBeta = 0.0f;
+		float betaBeta = 0.0f;
+		Colour alphaColour = {};
+		Colour betaColour = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			const float alpha = WEIGHTS[indices[i]];
+			const float beta = 1.0f - alpha;
+			alphaAlpha += alpha * alpha;
+			alphaBeta += alpha * beta;
+			betaBeta += beta * beta;
+			for (int j = 0; j < 3; ++j)
+			{
+				alphaColour[j] += alpha * (float)block[i][j];
+				betaColour[j] += beta * (float)block[i][j];
+			}
+		}
+
+		const float determinant = alphaAlpha * betaBeta - alphaBeta * alphaBeta;
+		if (std::abs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+
+		for (int j = 0; j < 3; ++j)
+		{
+			endpoint0[j] = (alphaColour[j] * betaBeta - betaColour[j] * alphaBeta) / determinant;
+			endpoint1[j] = (betaColour[j] * alphaAlpha - alphaColour[j] * alphaBeta) / determinant;
+		}
+		return true;
+	}
+
+	// Encodes the colour of the block into 8 bytes, using the four colour mode
+	void EncodeColourBlock(const Block& block, unsigned char* const output)
+	{
+		Colour mean = {};
+		for (const auto& pixel : block)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				mean[i] += (float)pixel[i] / 16.0f;
+			}
+		}
+
+		// The initial endpoints are the extremes of the pixels, projected onto the principal axis
+		const Colour axis = GetPrincipalAxis(block, mean);
+		float minProjection = std::numeric_limits<float>::max();
+		float maxProjection = std::numeric_limits<float>::lowest();
+		for (const auto& pixel : block)
+		{
+			const float projection = (pixel[0] - mean[0]) * axis[0] + (pixel[1] - mean[1]) * axis[1]
+				+ (pixel[2] - mean[2]) * axis[2];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		Colour endpoint0;
+		Colour endpoint1;
+		for (int i = 0; i < 3; ++i)
+		{
+			endpoint0[i] = mean[i] + axis[i] * maxProjection;
+			endpoint1[i] = mean[i] + axis[i] * minProjection;
+		}
+
+		uint16_t bestEndpoint0 = ToRgb565(endpoint0);
+		uint16_t bestEndpoint1 = ToRgb565(endpoint1);
+		std::array<int, 16> bestIndices = {};
+		float bestError = ChooseColourIndices(block, bestEndpoint0, bestEndpoint1, bestIndices);
+
+		// Refine the endpoints with a least squares fit to the chosen indices, for as long as it helps
+		for (int iteration = 0; iteration < 2; ++iteration)
+		{
+			if (!FitEndpoints(block, bestIndices, endpoint0, endpoint1))
+			{
+				break;
+			}
+
+			const uint16_t fittedEndpoint0 = ToRgb565(endpoint0);
+			const uint16_t fittedEndpoint1 = ToRgb565(endpoint1);
+			std::array<int, 16> indices;
+			const float error = ChooseColourIndices(block, fittedEndpoint0, fittedEndpoint1, indices);
+			if (error >= bestError)
+			{
+				break;
+			}
+
+			bestEndpoint0 = fittedEndpoint0;
+			bestEndpoint1 = fittedEndpoint1;
+			bestIndices = indices;
+			bestError = error;
+		}
+
+		// The four colour mode requires the first endpoint to be the greater one. Swapping
+		// the endpoints swaps index 0 with 1, and index 2 with 3.
+		if (bestEndpoint0 < bestEndpoint1)
+		{
+			std::swap(bestEndpoint0, bestEndpoint1);
+			for (int& index : bestIndices)
+			{
+				index ^= 1;
+			}
+		}
+		else if (bestEndpoint0 == bestEndpoint1)
+		{
+			// Every index is the same colour anyway, but only index 0 means
+			// the same thing in both the four and the three colour modes
+			bestIndices.fill(0);
+		}
+
+		uint32_t packedIndices = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			packedIndices |= (uint32_t)bestIndices[i] << (2 * i);
+		}
+
+		// Everything is stored in little-endian order
+		output[0] = (unsigned char)(bestEndpoint0 & 0xFF);
+		output[1] = (unsigned char)(bestEndpoint0 >> 8);
+		output[2] = (unsigned char)(bestEndpoint1 & 0xFF);
+		output[3] = (unsigned char)(bestEndpoint1 >> 8);
+		for (int i = 0; i < 4; ++i)
+		{
+			output[4 + i] = (unsigned char)(packedIndices >> (8 * i));
+		}
+	}
+
+	// ^^^ Colour blocks ^^^
+
+	// Encodes one channel of the block into 8 bytes, i.e., the BC4 block that Bc3 uses for
+	// the alpha and Bc5 uses for the red and the green channels
+	void EncodeChannelBlock(const Block& block, const int channel, unsigned char* const output)
+	{
+		unsigned char minValue = 255;
+		unsigned char maxValue = 0;
+		for (const auto& pixel : block)
+		{
+			minValue = std::min(minValue, pixel[channel]);
+			maxValue = std::max(maxValue, pixel[channel]);
+		}
+
+		// With the first endpoint being the greater one, the palette consists of the two
+		// endpoints, followed by the six values evenly spaced between them
+		std::array<float, 8> palette = { (float)maxValue, (float)minValue };
+		for (int i = 2; i < 8; ++i)
+		{
+			palette[i] = ((float)(8 - i) * maxValue + (float)(i - 1) * minValue) / 7.0f;
+		}
+
+		uint64_t packedIndices = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			uint64_t bestIndex = 0;
+			float smallestDistance = std::numeric_limits<float>::max();
+			for (int j = 0; j < 8; ++j)
+			{
+				const float distance = std::abs(palette[j] - (float)block[i][channel]);
+				if (distance < smallestDistance)
+				{
+					smallestDistance = distance;
+					bestIndex = (uint64_t)j;
+				}
+			}
+			packedIndices |= bestIndex << (3 * i);
+		}
+
+		output[0] = maxValue;
+		output[1] = minValue;
+		// The 48 bits of indices, in little-endian order
+		for (int i = 0; i < 6; ++i)
+		{
+			output[2 + i] = (unsigned char)(packedIndices >> (8 * i));
+		}
+	}
+}
+
+std::vector<unsigned char> blockcompression::Compress(const TextureFormat format, const unsigned char* const pixels,
+	const int width, const int height)
+{
+	if (!textureformat::IsCompressed(format))
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not block compress an image into the format "
+			+ std::to_string((uint32_t)format));
+	}
+
+	std::vector<unsigned char> output(textureformat::GetImageSize(format, width, height));
+	unsigned char* outputBlock = output.data();
+
+	const int nBlocksX = (width + 3) / 4;
+	const int nBlocksY = (height + 3) / 4;
+	for (int blockY = 0; blockY < nBlocksY; ++blockY)
+	{
+		for (int blockX = 0; blockX < nBlocksX; ++blockX)
+		{
+			const Block block = GetBlock(pixels, width, height, blockX, blockY);
+
+			switch (format)
+			{
+			case TextureFormat::Bc1:
+				EncodeColourBlock(block, outputBlock);
+				outputBlock += 8;
+				break;
+			case TextureFormat::Bc3:
+				// The alpha block comes before the colour block
+				EncodeChannelBlock(block, 3, outputBlock);
+				EncodeColourBlock(block, outputBlock + 8);
+				outputBlock += 16;
+				break;
+			case TextureFormat::Bc5:
+				EncodeChannelBlock(block, 0, outputBlock);
+				EncodeChannelBlock(block, 1, outputBlock + 8);
+				outputBlock += 16;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	return output;
+}
+
+bool blockcompression::IsOpaque(const unsigned char* const pixels, const int width, const int height)
+{
+	const size_t nPixels = (size_t)width * height;
+	for (size_t i = 0; i < nPixels; ++i)
+	{
+		if (pixels[i * 4 + 3] != 255)
+		{
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include "TextureContainer.h"
+#include <vector>
+
+// A CPU encoder for the block compressed texture formats. Every block of 4x4 pixels is
+// encoded independently, as two endpoints and an index per pixel that selects a value
+// on the line between the endpoints.
+namespace blockcompression
+{
+	// Compresses an 8-bit RGBA image into the block compressed format "format", i.e., Bc1,
+	// Bc3 or Bc5. Bc1 only keeps the colour, Bc3 keeps the colour and the alpha, and Bc5
+	// keeps the red and green channels. The edge pixels are repeated along the sides of
+	// the image that are not a multiple of 4.
+	std::vector<unsigned char> Compress(TextureFormat format, const unsigned char* pixels, int width, int height);
+
+	// Returns true if every pixel of the 8-bit RGBA image is fully opaque
+	bool IsOpaque(const unsigned char* pixels, int width, int height);
+}
\ No newline at end of file
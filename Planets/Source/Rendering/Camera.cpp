@@ -81,6 +81,12 @@ void Camera::UpdatePosition(const float deltaTime)
     mPosition += movementDirection * MOVEMENT_SPEED * deltaTime;
 }
 
+void Camera::SetPose(const Vector3& position, const float xRotation, const float yRotation)
+{
+    mPosition = position;
+    mXRotation = xRotation;
+    mYRotation = yRotation;
+}
 
 const Vector3& Camera::GetPosition() const
 {
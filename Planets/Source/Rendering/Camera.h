@@ -6,6 +6,8 @@ public:
 	Camera();
 	void UpdateRotation(double xOffset, double yOffset);
 	void UpdatePosition(float deltaTime);
+	// Places the camera without any input from the user. The rotations are in radians.
+	void SetPose(const Vector3& position, float xRotation, float yRotation);
 	const Vector3& GetPosition() const;
 
 	float GetXRotation() const;
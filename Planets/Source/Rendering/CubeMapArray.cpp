@@ -0,0 +1,85 @@
+#include "CubeMapArray.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+
+CubeMapArray::CubeMapArray(const GLenum internalFormat, const GLsizei size, const GLsizei nMipLevels)
+	:
+	mInternalFormat(internalFormat),
+	mSize(size),
+	mNMipLevels(nMipLevels)
+{
+	Reallocate(1);
+}
+
+CubeMapArray::~CubeMapArray()
+{
+	// Destructors should not throw exception, hence no GL macro
+	glDeleteTextures(1, &mTexture);
+	GlStateCache::ForgetTexture(mTexture);
+}
+
+int CubeMapArray::AllocateLayer()
+{
+	if (mFreeLayers.empty())
+	{
+		Reallocate(mNLayers * 2);
+	}
+
+	const int layer = mFreeLayers.back();
+	mFreeLayers.pop_back();
+	return layer;
+}
+
+void CubeMapArray::FreeLayer(const int layer)
+{
+	assert(layer >= 0 && layer < mNLayers);
+	mFreeLayers.push_back(layer);
+}
+
+GLuint CubeMapArray::CreateLayerView(const int layer) const
+{
+	assert(layer >= 0 && layer < mNLayers);
+
+	GLuint view = 0;
+	// Views can not be created with "glCreateTextures", since the name needs to be unused
+	GL(glGenTextures(1, &view));
+	GL(glTextureView(view, GL_TEXTURE_CUBE_MAP, mTexture, mInternalFormat, 0, mNMipLevels, layer * 6, 6));
+	return view;
+}
+
+GLuint CubeMapArray::GetTexture() const
+{
+	return mTexture;
+}
+
+void CubeMapArray::Reallocate(const int nLayers)
+{
+	assert(nLayers > mNLayers);
+
+	GLuint texture = 0;
+	GL(glCreateTextures(GL_TEXTURE_CUBE_MAP_ARRAY, 1, &texture));
+	// The depth of a cube map array counts the faces, rather than the layers
+	GL(glTextureStorage3D(texture, mNMipLevels, mInternalFormat, mSize, mSize, nLayers * 6));
+	GL(glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+	GL(glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+	if (mTexture != 0)
+	{
+		for (GLsizei mipLevel = 0; mipLevel < mNMipLevels; ++mipLevel)
+		{
+			const GLsizei mipLevelSize = std::max(mSize >> mipLevel, 1);
+			GL(glCopyImageSubData(mTexture, GL_TEXTURE_CUBE_MAP_ARRAY, mipLevel, 0, 0, 0,
+				texture, GL_TEXTURE_CUBE_MAP_ARRAY, mipLevel, 0, 0, 0, mipLevelSize, mipLevelSize, mNLayers * 6));
+		}
+		GL(glDeleteTextures(1, &mTexture));
+		GlStateCache::ForgetTexture(mTexture);
+	}
+	mTexture = texture;
+
+	// Hand out the lowest layers first
+	for (int layer = nLayers - 1; layer >= mNLayers; --layer)
+	{
+		mFreeLayers.push_back(layer);
+	}
+	mNLayers = nLayers;
+}
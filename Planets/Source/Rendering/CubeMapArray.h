@@ -0,0 +1,39 @@
+#pragma once
+#include "GL/glew.h"
+#include <vector>
+
+// A cube map array, whose layers are handed out to different users, so that the users
+// can share the same texture binding. The array grows when it runs out of layers, which
+// replaces the texture, so the texture should be looked up again after a layer has been
+// allocated. Should only be used by the thread that owns the OpenGL context.
+class CubeMapArray
+{
+public:
+	// Needs to be constructed after the OpenGL context has been created
+	CubeMapArray(GLenum internalFormat, GLsizei size, GLsizei nMipLevels);
+	~CubeMapArray();
+
+	// One should not be able to copy a "CubeMapArray" instance
+	CubeMapArray(const CubeMapArray& other) = delete;
+	CubeMapArray& operator=(const CubeMapArray& other) = delete;
+
+	int AllocateLayer();
+	void FreeLayer(int layer);
+
+	// Returns a cube map that views the faces of the layer, which can be bound as an image
+	// or have its mip chain generated on its own. The caller is responsible for deleting it.
+	GLuint CreateLayerView(int layer) const;
+
+	GLuint GetTexture() const;
+private:
+	// Moves the layers into a new texture, with room for "nLayers" layers
+	void Reallocate(int nLayers);
+private:
+	GLenum mInternalFormat = 0;
+	GLsizei mSize = 0;
+	GLsizei mNMipLevels = 0;
+
+	GLuint mTexture = 0;
+	int mNLayers = 0;
+	std::vector<int> mFreeLayers;
+};
@@ -0,0 +1,104 @@
+#include "DynamicResolution.h"
+#include "GlMacro.h"
+#include <cmath>
+
+DynamicResolution::DynamicResolution(const double targetMilliseconds)
+	:
+	mTargetMilliseconds(targetMilliseconds)
+{
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	// Destructors should not throw exception, hence no GL macro(s)
+	for (const PendingFrame& frame : mPendingFrames)
+	{
+		glDeleteQueries(1, &frame.beginQuery);
+		glDeleteQueries(1, &frame.endQuery);
+	}
+	glDeleteQueries((GLsizei)mFreeQueries.size(), mFreeQueries.data());
+}
+
+void DynamicResolution::BeginFrame()
+{
+	if (mFreeQueries.size() < 2)
+	{
+		// Timestamp queries, unlike time elapsed queries, may be written
+		// while other timings, such as those of the benchmarks, are going on
+		std::vector<GLuint> queries(8);
+		GL(glCreateQueries(GL_TIMESTAMP, (GLsizei)queries.size(), queries.data()));
+		mFreeQueries.insert(mFreeQueries.end(), queries.begin(), queries.end());
+	}
+
+	PendingFrame frame;
+	frame.beginQuery = mFreeQueries.back();
+	mFreeQueries.pop_back();
+	frame.endQuery = mFreeQueries.back();
+	mFreeQueries.pop_back();
+	frame.scale = mScale;
+
+	GL(glQueryCounter(frame.beginQuery, GL_TIMESTAMP));
+	mPendingFrames.push_back(frame);
+}
+
+void DynamicResolution::EndFrame()
+{
+	assert(!mPendingFrames.empty());
+	GL(glQueryCounter(mPendingFrames.back().endQuery, GL_TIMESTAMP));
+
+	while (!mPendingFrames.empty())
+	{
+		const PendingFrame& frame = mPendingFrames.front();
+		// The end query is written after the begin query, so it is enough to check it
+		GLint isAvailable = GL_FALSE;
+		GL(glGetQueryObjectiv(frame.endQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable));
+		if (!isAvailable)
+		{
+			// The later frames are not done either
+			break;
+		}
+
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		GL(glGetQueryObjectui64v(frame.beginQuery, GL_QUERY_RESULT, &begin));
+		GL(glGetQueryObjectui64v(frame.endQuery, GL_QUERY_RESULT, &end));
+		Adjust(frame, (double)(end - begin) / 1e+6);
+
+		mFreeQueries.push_back(frame.beginQuery);
+		mFreeQueries.push_back(frame.endQuery);
+		mPendingFrames.pop_front();
+	}
+
+	QuantizeScale();
+}
+
+float DynamicResolution::GetScale() const
+{
+	return mScale;
+}
+
+void DynamicResolution::Adjust(const PendingFrame& frame, const double milliseconds)
+{
+	if (milliseconds <= 0.0)
+	{
+		return;
+	}
+
+	// Most of the GPU time is spent on the pixels, whose number grows with the square of
+	// the scale. The frame was rendered at its own scale, which might not be the current
+	// one, since the times are read a couple of frames after they were measured.
+	const float wantedScale = frame.scale * (float)std::sqrt(mTargetMilliseconds / milliseconds);
+	mContinuousScale += (wantedScale - mContinuousScale) * GAIN;
+	mContinuousScale = std::clamp(mContinuousScale, MIN_SCALE, MAX_SCALE);
+}
+
+void DynamicResolution::QuantizeScale()
+{
+	if (std::abs(mContinuousScale - mScale) < SCALE_STEP * HYSTERESIS)
+	{
+		return;
+	}
+
+	mScale = std::round(mContinuousScale / SCALE_STEP) * SCALE_STEP;
+	mScale = std::clamp(mScale, MIN_SCALE, MAX_SCALE);
+}
\ No newline at end of file
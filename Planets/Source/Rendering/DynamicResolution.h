@@ -0,0 +1,61 @@
+#pragma once
+#include "GL/glew.h"
+#include <deque>
+#include <vector>
+
+// Picks the scale of the resolution that the scene gets rendered at, relative to the window, so
+// that the GPU time of a frame stays close to a target. The GPU time of every frame is measured
+// by timestamp queries, which are read a couple of frames later, without stalling. The scale
+// follows the measured times smoothly, but the scale that gets handed out only moves between
+// quantized steps, since every change of the resolution reallocates the render targets.
+// Should only be used by the thread that owns the OpenGL context.
+class DynamicResolution
+{
+public:
+	DynamicResolution(double targetMilliseconds);
+	~DynamicResolution();
+
+	// One should not be able to copy nor move a "DynamicResolution" instance
+	DynamicResolution(const DynamicResolution& other) = delete;
+	DynamicResolution& operator=(const DynamicResolution& other) = delete;
+
+	// Need to surround the GPU work of every frame, which gets rendered at "GetScale"
+	void BeginFrame();
+	// Updates the scale from the GPU times that have become available
+	void EndFrame();
+
+	// The scale of the width and the height of the scene, which is one of the quantized steps
+	float GetScale() const;
+
+	static constexpr float MIN_SCALE = 0.5f;
+	static constexpr float MAX_SCALE = 1.0f;
+	static constexpr float SCALE_STEP = 0.125f;
+private:
+	struct PendingFrame
+	{
+		// Written at the beginning and at the end of the frame
+		GLuint beginQuery = 0;
+		GLuint endQuery = 0;
+		// The scale that the frame was rendered at
+		float scale = 0.0f;
+	};
+
+	// Moves the continuous scale towards the scale at which "frame" would have met the target
+	void Adjust(const PendingFrame& frame, double milliseconds);
+	void QuantizeScale();
+private:
+	double mTargetMilliseconds = 0.0;
+
+	// The scale that the controller wants, which the quantized scale follows
+	float mContinuousScale = MAX_SCALE;
+	float mScale = MAX_SCALE;
+
+	std::deque<PendingFrame> mPendingFrames;
+	std::vector<GLuint> mFreeQueries;
+
+	// How far, out of 1, the continuous scale moves towards the wanted scale every frame
+	static constexpr float GAIN = 0.1f;
+	// How far, in steps, the continuous scale needs to be from the quantized scale, in order for
+	// the quantized scale to change. Keeps the scale from flickering between two adjacent steps.
+	static constexpr float HYSTERESIS = 0.75f;
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "FrameConstantsBuffer.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "StreamBuffer.h"
+
+FrameConstantsBuffer::FrameConstantsBuffer(const float verticalFieldOfView, const float near, const float far)
+	:
+	mVerticalFieldOfView(verticalFieldOfView),
+	mNear(near),
+	mFar(far)
+{
+}
+
+void FrameConstantsBuffer::Update(const Camera& camera)
+{
+	// The projection is rebuilt every frame, so that it follows the aspect ratio of the window
+	mProjection = matrix::GetProjection(mVerticalFieldOfView, mNear, mFar);
+	mViewRotation = matrix::GetRotation(-camera.GetXRotation(), -camera.GetYRotation(), 0.0f);
+	const Matrix4& projection = mProjection;
+	const Matrix4 viewRotation = (Matrix4)mViewRotation;
+
+	const std::optional<Matrix4> projectionInverse = projection.GetInverse();
+	const std::optional<Matrix4> viewRotationInverse = viewRotation.GetInverse();
+	// Make sure that the inversions succeeded
+	assert(projectionInverse && viewRotationInverse);
+
+	StreamBuffer& streamBuffer = StreamBuffer::Get();
+	const StreamBuffer::Allocation allocation =
+		streamBuffer.Allocate(sizeof(Constants), streamBuffer.GetUniformBufferAlignment());
+
+	// The constants are gathered on the stack, rather than written to the mapped memory
+	// one by one, since the mapped memory is slow to write to in small pieces
+	Constants constants;
+	Store(viewRotation, constants.viewRotation);
+	Store(*viewRotationInverse, constants.viewRotationInverse);
+	Store(projection, constants.projection);
+	Store(*projectionInverse, constants.projectionInverse);
+	std::copy_n(camera.GetPosition().GetPointerToData(), 3, constants.cameraPosition);
+	constants.near = mNear;
+	constants.far = mFar;
+
+	*static_cast<Constants*>(allocation.data) = constants;
+	GlStateCache::Get().BindBufferRange(GL_UNIFORM_BUFFER, BINDING, streamBuffer.GetBuffer(), allocation.offset,
+		sizeof(Constants));
+}
+
+const Matrix3& FrameConstantsBuffer::GetViewRotation() const
+{
+	return mViewRotation;
+}
+
+const Matrix4& FrameConstantsBuffer::GetProjection() const
+{
+	return mProjection;
+}
+
+float FrameConstantsBuffer::GetNear() const
+{
+	return mNear;
+}
+
+void FrameConstantsBuffer::Store(const Matrix4& matrix, float (&destination)[16])
+{
+	// The matrices are stored column by column, just like std140 wants them
+	std::copy_n(matrix.GetPointerToData(), 16, destination);
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "GL/glew.h"
+#include "Camera.h"
+#include "../Mathematics/Matrix/Matrix.h"
+
+// The constants that stay the same during a whole frame, i.e., the view, the projection
+// and the camera position. They are streamed to the GPU once per frame, through the
+// "StreamBuffer", and bound to the binding point "BINDING", where every program, including
+// the post-processing ones, reads them as the uniform block "FrameConstants".
+class FrameConstantsBuffer
+{
+public:
+	// "verticalFieldOfView" is in radians, and the aspect ratio of the projection follows the window
+	FrameConstantsBuffer(float verticalFieldOfView, float near, float far);
+
+	// Uploads the constants of the current frame, and binds them.
+	// Needs to be called once per frame, before anything gets rendered.
+	void Update(const Camera& camera);
+
+	// The view rotation and the projection of the current frame, for culling on the CPU
+	const Matrix3& GetViewRotation() const;
+	const Matrix4& GetProjection() const;
+	float GetNear() const;
+
+	// Needs to match the binding of the uniform block "FrameConstants" inside the shaders
+	static constexpr GLuint BINDING = 3;
+private:
+	// The content of the uniform block "FrameConstants", stored
+	// according to the std140 storage layout
+	struct Constants
+	{
+		// Rotates world space into view space. The translation, by the camera position,
+		// is left to the shaders, so that the positions stay precise far from the origin.
+		float viewRotation[16];
+		float viewRotationInverse[16];
+		float projection[16];
+		float projectionInverse[16];
+		float cameraPosition[3];
+		float near = 0.0f;
+		float far = 0.0f;
+	};
+	static_assert(sizeof(Constants) == 4 * 4 * 16 + 4 * 5);
+
+	static void Store(const Matrix4& matrix, float (&destination)[16]);
+private:
+	float mVerticalFieldOfView = 0.0f;
+	float mNear = 0.0f;
+	float mFar = 0.0f;
+
+	Matrix3 mViewRotation;
+	Matrix4 mProjection;
+};
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "GlStateCache.h"
+#include "GlMacro.h"
+#include "../Benchmark/BenchmarkMacros.h"
+
+GlStateCache::GlStateCache()
+{
+	// There should only be one instance of this class
+	assert(!msGlStateCache);
+	msGlStateCache = this;
+}
+
+GlStateCache::~GlStateCache()
+{
+	msGlStateCache = nullptr;
+}
+
+GlStateCache& GlStateCache::Get()
+{
+	assert(msGlStateCache);
+	return *msGlStateCache;
+}
+
+void GlStateCache::UseProgram(const GLuint program)
+{
+	if (Change(mProgram, program))
+	{
+		GL(glUseProgram(program));
+	}
+}
+
+void GlStateCache::BindVertexArray(const GLuint vertexArray)
+{
+	if (Change(mVertexArray, vertexArray))
+	{
+		GL(glBindVertexArray(vertexArray));
+	}
+}
+
+void GlStateCache::BindTextureUnit(const GLuint unit, const GLuint texture)
+{
+	if (Change(GetUnit(mTextureUnits, unit), texture))
+	{
+		GL(glBindTextureUnit(unit, texture));
+	}
+}
+
+void GlStateCache::BindSampler(const GLuint unit, const GLuint sampler)
+{
+	if (Change(GetUnit(mSamplerUnits, unit), sampler))
+	{
+		GL(glBindSampler(unit, sampler));
+	}
+}
+
+void GlStateCache::BindImageTexture(const GLuint unit, const GLuint texture, const GLint level,
+	const GLboolean layered, const GLint layer, const GLenum access, const GLenum format)
+{
+	if (Change(GetUnit(mImageUnits, unit), ImageBinding{ texture, level, layered, layer, access, format }))
+	{
+		GL(glBindImageTexture(unit, texture, level, layered, layer, access, format));
+	}
+}
+
+void GlStateCache::BindBuffer(const GLenum target, const GLuint buffer)
+{
+	if (Change(mBuffers[target], buffer))
+	{
+		GL(glBindBuffer(target, buffer));
+	}
+}
+
+void GlStateCache::BindBufferBase(const GLenum target, const GLuint index, const GLuint buffer)
+{
+	if (Change(GetUnit(mIndexedBuffers[target], index), BufferBinding{ buffer, 0, 0 }))
+	{
+		GL(glBindBufferBase(target, index, buffer));
+		// The buffer also gets bound to the target itself
+		mBuffers[target] = buffer;
+	}
+}
+
+void GlStateCache::BindBufferRange(const GLenum target, const GLuint index, const GLuint buffer,
+	const GLintptr offset, const GLsizeiptr size)
+{
+	if (Change(GetUnit(mIndexedBuffers[target], index), BufferBinding{ buffer, offset, size }))
+	{
+		GL(glBindBufferRange(target, index, buffer, offset, size));
+		// The buffer also gets bound to the target itself
+		mBuffers[target] = buffer;
+	}
+}
+
+void GlStateCache::BindFramebuffer(const GLuint framebuffer)
+{
+	if (Change(mFramebuffer, framebuffer))
+	{
+		GL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+	}
+}
+
+void GlStateCache::SetEnabled(const GLenum capability, const bool isEnabled)
+{
+	if (!Change(mCapabilities[capability], isEnabled))
+	{
+		return;
+	}
+
+	if (isEnabled)
+	{
+		GL(glEnable(capability));
+	}
+	else
+	{
+		GL(glDisable(capability));
+	}
+}
+
+void GlStateCache::ForgetProgram(const GLuint program)
+{
+	if (msGlStateCache && msGlStateCache->mProgram == program)
+	{
+		msGlStateCache->mProgram.reset();
+	}
+}
+
+void GlStateCache::ForgetVertexArray(const GLuint vertexArray)
+{
+	if (msGlStateCache && msGlStateCache->mVertexArray == vertexArray)
+	{
+		msGlStateCache->mVertexArray.reset();
+	}
+}
+
+void GlStateCache::ForgetTexture(const GLuint texture)
+{
+	if (!msGlStateCache)
+	{
+		return;
+	}
+
+	Forget(msGlStateCache->mTextureUnits, [texture](const GLuint bound) { return bound == texture; });
+	Forget(msGlStateCache->mImageUnits, [texture](const ImageBinding& bound) { return bound.texture == texture; });
+}
+
+void GlStateCache::ForgetSampler(const GLuint sampler)
+{
+	if (msGlStateCache)
+	{
+		Forget(msGlStateCache->mSamplerUnits, [sampler](const GLuint bound) { return bound == sampler; });
+	}
+}
+
+void GlStateCache::ForgetBuffer(const GLuint buffer)
+{
+	if (!msGlStateCache)
+	{
+		return;
+	}
+
+	for (auto& [target, bound] : msGlStateCache->mBuffers)
+	{
+		if (bound == buffer)
+		{
+			bound.reset();
+		}
+	}
+	for (auto& [target, bindings] : msGlStateCache->mIndexedBuffers)
+	{
+		Forget(bindings, [buffer](const BufferBinding& bound) { return bound.buffer == buffer; });
+	}
+}
+
+void GlStateCache::ForgetFramebuffer(const GLuint framebuffer)
+{
+	if (msGlStateCache && msGlStateCache->mFramebuffer == framebuffer)
+	{
+		msGlStateCache->mFramebuffer.reset();
+	}
+}
+
+void GlStateCache::EndFrame()
+{
+	BENCHMARK_COUNTER("OpenGL state calls", { "Issued", mNIssuedCalls }, { "Elided", mNElidedCalls });
+	mNIssuedCalls = 0;
+	mNElidedCalls = 0;
+}
+
+template<typename T>
+bool GlStateCache::Change(std::optional<T>& state, const T& value)
+{
+	if (state == value)
+	{
+		++mNElidedCalls;
+		return false;
+	}
+
+	state = value;
+	++mNIssuedCalls;
+	return true;
+}
+
+template<typename T>
+std::optional<T>& GlStateCache::GetUnit(std::vector<std::optional<T>>& units, const GLuint index)
+{
+	if (index >= units.size())
+	{
+		units.resize((size_t)index + 1);
+	}
+	return units[index];
+}
+
+template<typename T, typename Predicate>
+void GlStateCache::Forget(std::vector<std::optional<T>>& states, Predicate isBoundTo)
+{
+	for (std::optional<T>& state : states)
+	{
+		if (state && isBoundTo(*state))
+		{
+			state.reset();
+		}
+	}
+}
\ No newline at end of file
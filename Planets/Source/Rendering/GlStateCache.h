@@ -0,0 +1,101 @@
+#pragma once
+#include "GL/glew.h"
+#include <optional>
+
+// Singleton. Keeps track of what is bound to the OpenGL context, and of which capabilities are
+// enabled, so that the binds that would not change anything never reach the driver. Every bind
+// needs to go through the cache, since the cache would otherwise skip binds that are needed.
+// A state that the cache has not seen yet is unknown, and always gets set. The calls that were
+// issued, and the ones that were elided, are counted and recorded to the benchmark trace once
+// per frame. Should only be used by the thread that owns the OpenGL context.
+class GlStateCache
+{
+public:
+	// Needs to be constructed after the OpenGL context has been created
+	GlStateCache();
+	~GlStateCache();
+
+	// One should not be able to copy nor move a "GlStateCache" instance
+	GlStateCache(const GlStateCache& other) = delete;
+	GlStateCache& operator=(const GlStateCache& other) = delete;
+
+	static GlStateCache& Get();
+
+	// Each of these does the same as the OpenGL function of the same name,
+	// unless the state already is what the call would set it to
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	void BindTextureUnit(GLuint unit, GLuint texture);
+	void BindSampler(GLuint unit, GLuint sampler);
+	void BindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+		GLenum access, GLenum format);
+	void BindBuffer(GLenum target, GLuint buffer);
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	// Binds "framebuffer" to "GL_FRAMEBUFFER", i.e., for both drawing and reading
+	void BindFramebuffer(GLuint framebuffer);
+	// Calls "glEnable" or "glDisable"
+	void SetEnabled(GLenum capability, bool isEnabled);
+
+	// Deleting an object unbinds it, and a new object might then get the same name, so the
+	// deletions of the objects that might be bound need to be reported to the cache. These
+	// do nothing if there is no cache, e.g., when called by the destructors of static objects.
+	static void ForgetProgram(GLuint program);
+	static void ForgetVertexArray(GLuint vertexArray);
+	static void ForgetTexture(GLuint texture);
+	static void ForgetSampler(GLuint sampler);
+	static void ForgetBuffer(GLuint buffer);
+	static void ForgetFramebuffer(GLuint framebuffer);
+
+	// Records the number of issued and elided calls of the frame to the
+	// benchmark trace, and starts over. Needs to be called once per frame.
+	void EndFrame();
+private:
+	struct ImageBinding
+	{
+		GLuint texture = 0;
+		GLint level = 0;
+		GLboolean layered = GL_FALSE;
+		GLint layer = 0;
+		GLenum access = 0;
+		GLenum format = 0;
+
+		bool operator==(const ImageBinding& other) const = default;
+	};
+
+	// A range whose size is 0 binds the whole buffer, just like "glBindBufferBase" does
+	struct BufferBinding
+	{
+		GLuint buffer = 0;
+		GLintptr offset = 0;
+		GLsizeiptr size = 0;
+
+		bool operator==(const BufferBinding& other) const = default;
+	};
+
+	// Returns whether the call that sets "state" to "value" needs to be issued, and counts the call
+	template<typename T>
+	bool Change(std::optional<T>& state, const T& value);
+	// Returns the state of the unit "index", which is unknown until it has been set
+	template<typename T>
+	static std::optional<T>& GetUnit(std::vector<std::optional<T>>& units, GLuint index);
+	// Makes every state, out of "states", for which "isBoundTo" returns true, unknown
+	template<typename T, typename Predicate>
+	static void Forget(std::vector<std::optional<T>>& states, Predicate isBoundTo);
+private:
+	std::optional<GLuint> mProgram;
+	std::optional<GLuint> mVertexArray;
+	std::optional<GLuint> mFramebuffer;
+	std::vector<std::optional<GLuint>> mTextureUnits;
+	std::vector<std::optional<GLuint>> mSamplerUnits;
+	std::vector<std::optional<ImageBinding>> mImageUnits;
+	std::unordered_map<GLenum, std::optional<GLuint>> mBuffers;
+	std::unordered_map<GLenum, std::vector<std::optional<BufferBinding>>> mIndexedBuffers;
+	std::unordered_map<GLenum, std::optional<bool>> mCapabilities;
+
+	// The calls of the current frame
+	long long mNIssuedCalls = 0;
+	long long mNElidedCalls = 0;
+
+	static inline GlStateCache* msGlStateCache = nullptr;
+};
\ No newline at end of file
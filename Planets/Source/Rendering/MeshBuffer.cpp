@@ -0,0 +1,116 @@
+#include "MeshBuffer.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "StreamBuffer.h"
+
+MeshBuffer::MeshBuffer(const GLsizei vertexSize)
+	:
+	mVertexSize(vertexSize)
+{
+	GL(glCreateVertexArrays(1, &mVertexArray));
+}
+
+MeshBuffer::~MeshBuffer()
+{
+	// Destructors should not throw exception, hence no GL macro(s)
+	glDeleteVertexArrays(1, &mVertexArray);
+	glDeleteBuffers(1, &mVertexBuffer);
+	GlStateCache::ForgetVertexArray(mVertexArray);
+	GlStateCache::ForgetBuffer(mVertexBuffer);
+}
+
+MeshBuffer::MeshId MeshBuffer::Add(const void* const vertices, const GLsizei nVertices)
+{
+	const Range range = { Allocate(nVertices), nVertices };
+	StreamBuffer::Get().CopyToBuffer(mVertexBuffer, (GLintptr)range.first * mVertexSize, vertices,
+		(size_t)nVertices * mVertexSize);
+
+	mMeshes.insert({ mNextMeshId, range });
+	return mNextMeshId++;
+}
+
+void MeshBuffer::Update(const MeshId meshId, const void* const vertices, const GLsizei nVertices)
+{
+	assert(mMeshes.contains(meshId));
+
+	// The mesh is moved to the end of the buffer, if it does not fit where it is.
+	// It is removed first, so that a reallocation does not copy its old vertices.
+	if (nVertices > mMeshes[meshId].count)
+	{
+		mMeshes.erase(meshId);
+		mMeshes.insert({ meshId, Range{ Allocate(nVertices), nVertices } });
+	}
+
+	Range& range = mMeshes[meshId];
+	range.count = nVertices;
+	StreamBuffer::Get().CopyToBuffer(mVertexBuffer, (GLintptr)range.first * mVertexSize, vertices,
+		(size_t)nVertices * mVertexSize);
+}
+
+void MeshBuffer::Remove(const MeshId meshId)
+{
+	assert(mMeshes.contains(meshId));
+	mMeshes.erase(meshId);
+}
+
+void MeshBuffer::Read(const MeshId meshId, void* const vertices) const
+{
+	const Range range = GetRange(meshId);
+	GL(glGetNamedBufferSubData(mVertexBuffer, (GLintptr)range.first * mVertexSize,
+		(GLsizeiptr)range.count * mVertexSize, vertices));
+}
+
+MeshBuffer::Range MeshBuffer::GetRange(const MeshId meshId) const
+{
+	assert(mMeshes.contains(meshId));
+	return mMeshes.at(meshId);
+}
+
+GLuint MeshBuffer::GetVertexArray() const
+{
+	return mVertexArray;
+}
+
+GLint MeshBuffer::Allocate(const GLsizei nVertices)
+{
+	if (mEnd + nVertices > mCapacity)
+	{
+		GLsizei nUsedVertices = nVertices;
+		for (const auto& [meshId, range] : mMeshes)
+		{
+			nUsedVertices += range.count;
+		}
+
+		// Double the capacity, so that adding meshes one by one only
+		// causes a logarithmic amount of reallocations
+		Reallocate(std::max(nUsedVertices, mCapacity * 2));
+	}
+
+	const GLint first = mEnd;
+	mEnd += nVertices;
+	return first;
+}
+
+void MeshBuffer::Reallocate(const GLsizei nVertices)
+{
+	GLuint vertexBuffer = 0;
+	GL(glCreateBuffers(1, &vertexBuffer));
+	GL(glNamedBufferStorage(vertexBuffer, (GLsizeiptr)nVertices * mVertexSize, NULL, 0));
+
+	// The meshes are copied on the GPU, without any gaps between them
+	mEnd = 0;
+	for (auto& [meshId, range] : mMeshes)
+	{
+		GL(glCopyNamedBufferSubData(mVertexBuffer, vertexBuffer, (GLintptr)range.first * mVertexSize,
+			(GLintptr)mEnd * mVertexSize, (GLsizeiptr)range.count * mVertexSize));
+		range.first = mEnd;
+		mEnd += range.count;
+	}
+
+	GL(glDeleteBuffers(1, &mVertexBuffer));
+	GlStateCache::ForgetBuffer(mVertexBuffer);
+	mVertexBuffer = vertexBuffer;
+	mCapacity = nVertices;
+
+	GL(glVertexArrayVertexBuffer(mVertexArray, 0, mVertexBuffer, 0, mVertexSize));
+}
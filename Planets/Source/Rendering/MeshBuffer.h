@@ -0,0 +1,62 @@
+#pragma once
+#include "GL/glew.h"
+#include <unordered_map>
+
+// Holds the vertices of many meshes, which share the same vertex format, inside a single
+// vertex buffer. All the meshes are drawn with the same vertex array object, which is what
+// lets the "RenderQueue" draw them together, with a single multi-draw call. The vertices are
+// copied into the vertex buffer through the "StreamBuffer", so replacing the vertices of a mesh
+// never waits for the draws that use the old ones. Should only be used by the thread that owns
+// the OpenGL context.
+class MeshBuffer
+{
+public:
+	using MeshId = size_t;
+
+	// The vertices of a mesh, inside the vertex buffer
+	struct Range
+	{
+		GLint first = 0;
+		GLsizei count = 0;
+	};
+
+	// Needs to be constructed after the OpenGL context has been created. The attribute
+	// formats of the vertex array object are up to the user, and the vertex buffer is
+	// bound to its binding index 0.
+	MeshBuffer(GLsizei vertexSize);
+	~MeshBuffer();
+
+	// One should not be able to copy a "MeshBuffer" instance
+	MeshBuffer(const MeshBuffer& other) = delete;
+	MeshBuffer& operator=(const MeshBuffer& other) = delete;
+
+	MeshId Add(const void* vertices, GLsizei nVertices);
+	// Replaces the vertices of the mesh, which may move it inside the vertex buffer
+	void Update(MeshId meshId, const void* vertices, GLsizei nVertices);
+	void Remove(MeshId meshId);
+	// Reads back the vertices of the mesh, which stalls until the GPU is done with them
+	void Read(MeshId meshId, void* vertices) const;
+
+	Range GetRange(MeshId meshId) const;
+	GLuint GetVertexArray() const;
+private:
+	// Places "nVertices" vertices after the last mesh, and makes room for
+	// them if needed. Returns the index of the first vertex.
+	GLint Allocate(GLsizei nVertices);
+	// Moves the meshes into a new vertex buffer, that fits "nVertices" vertices,
+	// without any gaps between them
+	void Reallocate(GLsizei nVertices);
+private:
+	GLsizei mVertexSize = 0;
+	GLuint mVertexArray = 0;
+	GLuint mVertexBuffer = 0;
+
+	// The number of vertices that fit in the vertex buffer
+	GLsizei mCapacity = 0;
+	// The vertices after this index are unused. The meshes that have been removed or
+	// grown leave gaps behind, which are only reclaimed when the buffer is reallocated.
+	GLsizei mEnd = 0;
+
+	std::unordered_map<MeshId, Range> mMeshes;
+	MeshId mNextMeshId = 0;
+};
@@ -0,0 +1,379 @@
+#include "MipChain.h"
+#include "../CustomException.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace
+{
+	// The weights of the source pixels that make up one destination pixel
+	struct FilterTaps
+	{
+		std::vector<int> indices;
+		std::vector<float> weights;
+	};
+
+	// The radius of the Kaiser filter, in destination pixels, and the
+	// shape of its window, where a higher alpha makes the window narrower
+	constexpr float KAISER_RADIUS = 3.0f;
+	constexpr float KAISER_ALPHA = 4.0f;
+
+	float GetSinc(float x)
+	{
+		if (std::abs(x) < 1e-5f)
+		{
+			return 1.0f;
+		}
+		x *= std::numbers::pi_v<float>;
+		return std::sin(x) / x;
+	}
+
+	// The modified Bessel function of the first kind, of order 0
+	float GetBesselI0(const float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int i = 1; term > sum * 1e-7f; ++i)
+		{
+			term *= (x * x) / (4.0f * (float)i * (float)i);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float GetKaiserWeight(const float distance)
+	{
+		if (std::abs(distance) >= KAISER_RADIUS)
+		{
+			return 0.0f;
+		}
+
+		const float t = distance / KAISER_RADIUS;
+		const float window = GetBesselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / GetBesselI0(KAISER_ALPHA);
+		return GetSinc(distance) * window;
+	}
+
+	// Returns the taps of every destination pixel along an axis. The source pixels
+	// outside the image are clamped to the edge of the image.
+	std::vector<FilterTaps> GetFilterTaps(const int sourceSize, const int destinationSize, const MipFilter filter)
+	{
+		// The amount of source pixels that a destination pixel covers
+		const float scale = (float)sourceSize / (float)destinationSize;
+		const float radius = filter == MipFilter::Box ? scale / 2.0f : KAISER_RADIUS * scale;
+
+		std::vector<FilterTaps> taps(destinationSize);
+		for (int i = 0; i < destinationSize; ++i)
+		{
+			const float centre = ((float)i + 0.5f) * scale;
+			const int first = (int)std::floor(centre - radius);
+			const int last = (int)std::ceil(centre + radius);
+
+			float weightSum = 0.0f;
+			for (int j = first; j <= last; ++j)
+			{
+				float weight = 0.0f;
+				if (filter == MipFilter::Box)
+				{
+					// The part of the source pixel that the destination pixel covers
+					weight = std::max(0.0f, std::min((float)j + 1.0f, centre + radius) - std::max((float)j, centre - radius));
+				}
+				else
+				{
+					weight = GetKaiserWeight(((float)j + 0.5f - centre) / scale);
+				}
+
+				if (weight != 0.0f)
+				{
+					taps[i].indices.push_back(std::clamp(j, 0, sourceSize - 1));
+					taps[i].weights.push_back(weight);
+					weightSum += weight;
+				}
+			}
+
+			for (float& weight : taps[i].weights)
+			{
+				weight /= weightSum;
+			}
+		}
+
+		return taps;
+	}
+
+	// Calls "function(firstRow, endRow)" for blocks of the "nRows" rows, in parallel if there is a thread pool
+	template<class F>
+	void ForEachRowBlock(const int nRows, ThreadPool* const threadPool, const F& function)
+	{
+		if (!threadPool || nRows < 16)
+		{
+			function(0, nRows);
+			return;
+		}
+
+		// A couple of blocks per thread evens out the work, when some threads start later than others
+		const int nBlocks = std::min(nRows, (int)threadPool->GetThreadCount() * 4);
+		std::vector<std::future<void>> blocks;
+		blocks.reserve(nBlocks);
+		for (int i = 0; i < nBlocks; ++i)
+		{
+			const int firstRow = nRows * i / nBlocks;
+			const int endRow = nRows * (i + 1) / nBlocks;
+			blocks.push_back(threadPool->Submit([&function, firstRow, endRow]() { function(firstRow, endRow); }));
+		}
+
+		for (std::future<void>& block : blocks)
+		{
+			block.get();
+		}
+	}
+
+	// A floating-point image, with "nChannels" interleaved channels per pixel
+	struct Image
+	{
+		std::vector<float> pixels;
+		int width = 0;
+		int height = 0;
+		int nChannels = 0;
+	};
+
+	// Filters the image down to the size of the next mip level, as a horizontal pass followed by a vertical pass
+	Image GetNextMipLevel(const Image& source, const MipFilter filter, ThreadPool* const threadPool)
+	{
+		const int nChannels = source.nChannels;
+		Image destination{ {}, std::max(1, source.width / 2), std::max(1, source.height / 2), nChannels };
+
+		const std::vector<FilterTaps> horizontalTaps = GetFilterTaps(source.width, destination.width, filter);
+		const std::vector<FilterTaps> verticalTaps = GetFilterTaps(source.height, destination.height, filter);
+
+		// The source rows, filtered horizontally
+		std::vector<float> rows((size_t)destination.width * source.height * nChannels);
+		ForEachRowBlock(source.height, threadPool, [&](const int firstRow, const int endRow)
+			{
+				for (int y = firstRow; y < endRow; ++y)
+				{
+					const float* const sourceRow = &source.pixels[(size_t)y * source.width * nChannels];
+					float* const row = &rows[(size_t)y * destination.width * nChannels];
+					for (int x = 0; x < destination.width; ++x)
+					{
+						const FilterTaps& taps = horizontalTaps[x];
+						for (size_t i = 0; i < taps.indices.size(); ++i)
+						{
+							for (int c = 0; c < nChannels; ++c)
+							{
+								row[x * nChannels + c] += sourceRow[taps.indices[i] * nChannels + c] * taps.weights[i];
+							}
+						}
+					}
+				}
+			});
+
+		destination.pixels.resize((size_t)destination.width * destination.height * nChannels);
+		const size_t rowSize = (size_t)destination.width * nChannels;
+		ForEachRowBlock(destination.height, threadPool, [&](const int firstRow, const int endRow)
+			{
+				for (int y = firstRow; y < endRow; ++y)
+				{
+					float* const destinationRow = &destination.pixels[y * rowSize];
+					const FilterTaps& taps = verticalTaps[y];
+					for (size_t i = 0; i < taps.indices.size(); ++i)
+					{
+						const float* const row = &rows[taps.indices[i] * rowSize];
+						for (size_t j = 0; j < rowSize; ++j)
+						{
+							destinationRow[j] += row[j] * taps.weights[i];
+						}
+					}
+				}
+			});
+
+		return destination;
+	}
+
+	float ConvertSrgbToLinear(const float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	unsigned char Quantize(const float value)
+	{
+		return (unsigned char)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+	}
+
+	// Returns the 8-bit sRGB value that a linear value rounds to. Looks the value up, instead of
+	// raising it to the power of 1/2.4, since that dominates the time it takes to store a mip level.
+	unsigned char QuantizeToSrgb(const float value)
+	{
+		// The linear values that lie halfway between two consecutive 8-bit sRGB values.
+		// The sRGB value is the number of halfway values that are below the value.
+		static const std::array<float, 255> halfwayValues = []()
+		{
+			std::array<float, 255> values = {};
+			for (int i = 0; i < 255; ++i)
+			{
+				values[i] = ConvertSrgbToLinear(((float)i + 0.5f) / 255.0f);
+			}
+			return values;
+		}();
+
+		return (unsigned char)(std::upper_bound(halfwayValues.begin(), halfwayValues.end(), value)
+			- halfwayValues.begin());
+	}
+
+	// The 8-bit RGBA image, in the space that it gets filtered in
+	Image GetFilterableImage(const unsigned char* const pixels, const int width, const int height,
+		const TextureKind kind, ThreadPool* const threadPool)
+	{
+		// Every 8-bit value, converted from sRGB to linear
+		static const std::array<float, 256> linearValues = []()
+		{
+			std::array<float, 256> values = {};
+			for (int i = 0; i < 256; ++i)
+			{
+				values[i] = ConvertSrgbToLinear((float)i / 255.0f);
+			}
+			return values;
+		}();
+
+		Image image{ std::vector<float>((size_t)width * height * 4), width, height, 4 };
+		ForEachRowBlock(height, threadPool, [&](const int firstRow, const int endRow)
+			{
+				for (size_t i = (size_t)firstRow * width; i < (size_t)endRow * width; ++i)
+				{
+					const unsigned char* const pixel = &pixels[i * 4];
+					float* const filterablePixel = &image.pixels[i * 4];
+					const float alpha = (float)pixel[3] / 255.0f;
+
+					for (int c = 0; c < 3; ++c)
+					{
+						// The channels of normal maps store the components of the normals, mapped from [-1, 1]
+						// to [0, 255]. The colours are premultiplied, so that the colours of transparent pixels
+						// do not bleed into the opaque ones.
+						filterablePixel[c] = kind == TextureKind::NormalMap ? (float)pixel[c] / 127.5f - 1.0f
+							: linearValues[pixel[c]] * alpha;
+					}
+					filterablePixel[3] = alpha;
+				}
+			});
+
+		return image;
+	}
+
+	// Renormalizes the normals of a filtered normal map, in place
+	void Renormalize(Image& image)
+	{
+		for (size_t i = 0; i < image.pixels.size(); i += 4)
+		{
+			float* const normal = &image.pixels[i];
+			const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 1e-6f)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					normal[c] /= length;
+				}
+			}
+		}
+	}
+
+	// Converts a filtered image back to 8-bit RGBA
+	std::vector<unsigned char> GetRgba8Pixels(const Image& image, const TextureKind kind, ThreadPool* const threadPool)
+	{
+		std::vector<unsigned char> pixels(image.pixels.size());
+		const size_t rowSize = (size_t)image.width * 4;
+		ForEachRowBlock(image.height, threadPool, [&](const int firstRow, const int endRow)
+			{
+				for (size_t i = firstRow * rowSize; i < endRow * rowSize; i += 4)
+				{
+					const float* const filteredPixel = &image.pixels[i];
+					const float alpha = std::clamp(filteredPixel[3], 0.0f, 1.0f);
+
+					for (int c = 0; c < 3; ++c)
+					{
+						pixels[i + c] = kind == TextureKind::NormalMap ? Quantize((filteredPixel[c] + 1.0f) / 2.0f)
+							: alpha > 0.0f ? QuantizeToSrgb(filteredPixel[c] / alpha) : 0;
+					}
+					pixels[i + 3] = Quantize(alpha);
+				}
+			});
+
+		return pixels;
+	}
+}
+
+int mipchain::GetMipLevelCount(const int width, const int height, const int nMipLevels)
+{
+	if (nMipLevels != FULL_CHAIN)
+	{
+		return nMipLevels;
+	}
+
+	int nFullChainMipLevels = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2)
+	{
+		++nFullChainMipLevels;
+	}
+	return nFullChainMipLevels;
+}
+
+std::vector<mipchain::MipLevel> mipchain::BuildRgba8(const unsigned char* const pixels, const int width,
+	const int height, const TextureKind kind, int nMipLevels, const MipFilter filter, ThreadPool* const threadPool)
+{
+	nMipLevels = GetMipLevelCount(width, height, nMipLevels);
+	if (width < 1 || height < 1 || nMipLevels < 1)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not build a mip chain of " + std::to_string(nMipLevels)
+			+ " mip levels, for an image with the size " + std::to_string(width) + "x" + std::to_string(height));
+	}
+
+	std::vector<MipLevel> mipChain;
+	mipChain.reserve(nMipLevels);
+	mipChain.push_back(MipLevel{ std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4),
+		width, height });
+
+	Image image = GetFilterableImage(pixels, width, height, kind, threadPool);
+	for (int i = 1; i < nMipLevels; ++i)
+	{
+		image = GetNextMipLevel(image, filter, threadPool);
+		if (kind == TextureKind::NormalMap)
+		{
+			// The next mip level is filtered from the renormalized
+			// normals, just like the GPU would have sampled them
+			Renormalize(image);
+		}
+
+		mipChain.push_back(MipLevel{ GetRgba8Pixels(image, kind, threadPool), image.width, image.height });
+	}
+
+	return mipChain;
+}
+
+std::vector<mipchain::MipLevel> mipchain::BuildR32f(const float* const pixels, const int width, const int height,
+	int nMipLevels, const MipFilter filter, ThreadPool* const threadPool)
+{
+	nMipLevels = GetMipLevelCount(width, height, nMipLevels);
+	if (width < 1 || height < 1 || nMipLevels < 1)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not build a mip chain of " + std::to_string(nMipLevels)
+			+ " mip levels, for an image with the size " + std::to_string(width) + "x" + std::to_string(height));
+	}
+
+	Image image{ std::vector<float>(pixels, pixels + (size_t)width * height), width, height, 1 };
+
+	std::vector<MipLevel> mipChain;
+	mipChain.reserve(nMipLevels);
+	for (int i = 0; i < nMipLevels; ++i)
+	{
+		if (i > 0)
+		{
+			image = GetNextMipLevel(image, filter, threadPool);
+		}
+
+		// The floats are stored as they are, since the payload has the same layout as the image
+		MipLevel mipLevel{ std::vector<unsigned char>(image.pixels.size() * sizeof(float)), image.width, image.height };
+		std::memcpy(mipLevel.pixels.data(), image.pixels.data(), mipLevel.pixels.size());
+		mipChain.push_back(std::move(mipLevel));
+	}
+
+	return mipChain;
+}
\ No newline at end of file
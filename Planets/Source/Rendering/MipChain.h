@@ -0,0 +1,45 @@
+#pragma once
+#include "TextureCache.h"
+#include "../Threading/ThreadPool.h"
+
+// How the pixels of a mip level get weighted, when they are averaged into the next mip level
+enum class MipFilter
+{
+	// Averages the pixels that the destination pixel covers
+	Box,
+	// A Kaiser windowed sinc, which keeps the mip levels sharper than the box
+	// filter does, without the aliasing of a plain sinc
+	Kaiser
+};
+
+// Builds the mip chains of textures on the CPU. Every mip level is filtered from the
+// previous one, in floating-point, and only gets quantized when it is stored. Colours are
+// filtered in linear space, with premultiplied alpha, and the normals of normal maps are
+// renormalized after filtering.
+namespace mipchain
+{
+	struct MipLevel
+	{
+		// The payload of the mip level, in the format of the chain
+		std::vector<unsigned char> pixels;
+		int width = 0;
+		int height = 0;
+	};
+
+	// When passed as the number of mip levels, the chain goes all the way down to 1x1
+	constexpr int FULL_CHAIN = 0;
+
+	// Returns the number of mip levels that a chain of "nMipLevels" levels, or of a full chain
+	// when "nMipLevels" is "FULL_CHAIN", has for an image of the size "width" x "height"
+	int GetMipLevelCount(int width, int height, int nMipLevels);
+
+	// Builds the mip chain of an 8-bit RGBA image, whose first mip level is the image itself.
+	// When "threadPool" is not null, the rows of every mip level are filtered in parallel on
+	// it, in which case this should not be called from one of the pool's own threads.
+	std::vector<MipLevel> BuildRgba8(const unsigned char* pixels, int width, int height, TextureKind kind,
+		int nMipLevels, MipFilter filter = MipFilter::Kaiser, ThreadPool* threadPool = nullptr);
+
+	// Builds the mip chain of a single channel, floating-point, image
+	std::vector<MipLevel> BuildR32f(const float* pixels, int width, int height, int nMipLevels,
+		MipFilter filter = MipFilter::Kaiser, ThreadPool* threadPool = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "PermutationUniformBuffer.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "../Noise/NoiseTableRegistry.h"
+
+PermutationUniformBuffer::PermutationUniformBuffer(const PermutationTable<256>& permutationTable)
+{
+	GL(glCreateBuffers(1, &mUniformBufferObject));
+
+	struct Vector4AlignedInt
+	{
+		int alignas(4 * 4) value = 0;
+	};
+	// We are aligning each element of the permutation table as a "vec4", to
+	// conform to the std140 storage layout
+	std::vector<Vector4AlignedInt> alignedPermutationTable(permutationTable.Size());
+	for (size_t i = 0; i < permutationTable.Size(); ++i)
+	{
+		alignedPermutationTable[i].value = (int)permutationTable[i];
+	}
+
+	// The "stride" (in memory) between each element is 4 * 4 bytes. The start of the last element
+	// is therefore "(permutationTable.Size() - 1) * 4 * 4". The total size is the start of the
+	// last element + the size of the last element, i.e, "(permutationTable.Size() - 1) * 4 * 4 + sizeof(int)"
+	GL(glNamedBufferData(mUniformBufferObject, (permutationTable.Size() - 1) * 4 * 4 + sizeof(int),
+		alignedPermutationTable.data(), GL_STATIC_DRAW));
+}
+
+PermutationUniformBuffer::~PermutationUniformBuffer()
+{
+	// We do not want to throw an exception inside a destructor. 
+	// Hence, we do not use the macro "GL".
+	glDeleteBuffers(1, &mUniformBufferObject);
+	GlStateCache::ForgetBuffer(mUniformBufferObject);
+}
+
+std::shared_ptr<const PermutationUniformBuffer> PermutationUniformBuffer::Get(const unsigned int seed)
+{
+	std::weak_ptr<const PermutationUniformBuffer>& weakUniformBuffer = msUniformBuffers[seed];
+
+	std::shared_ptr<const PermutationUniformBuffer> uniformBuffer = weakUniformBuffer.lock();
+	if (!uniformBuffer)
+	{
+		uniformBuffer = std::make_shared<PermutationUniformBuffer>(
+			*NoiseTableRegistry::Get().GetPermutationTable<256>(seed));
+		weakUniformBuffer = uniformBuffer;
+	}
+
+	return uniformBuffer;
+}
+
+void PermutationUniformBuffer::Bind(const GLuint bindingIndex) const
+{
+	GlStateCache::Get().BindBufferBase(GL_UNIFORM_BUFFER, bindingIndex, mUniformBufferObject);
+}
\ No newline at end of file
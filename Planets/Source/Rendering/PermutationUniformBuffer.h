@@ -0,0 +1,33 @@
+#pragma once
+#include "GL/glew.h"
+#include "../Noise/PermutationTable.h"
+#include <unordered_map>
+
+// A uniform buffer object that contains a permutation table, stored according to the
+// std140 storage layout. It is used by the shaders' perlin noise, i.e., the uniform
+// block "PermutationBuffer".
+class PermutationUniformBuffer
+{
+public:
+	PermutationUniformBuffer(const PermutationTable<256>& permutationTable);
+	~PermutationUniformBuffer();
+
+	// One should not be able to copy a "PermutationUniformBuffer" instance
+	PermutationUniformBuffer(const PermutationUniformBuffer& other) = delete;
+	PermutationUniformBuffer& operator=(const PermutationUniformBuffer& other) = delete;
+
+	// Returns the uniform buffer object that contains the permutation table, of 256 random
+	// values, that "NoiseTableRegistry" hands out for "seed". Everyone who asks for the same
+	// seed shares the same uniform buffer object, which is only uploaded once and lives for
+	// as long as somebody holds on to it.
+	static std::shared_ptr<const PermutationUniformBuffer> Get(unsigned int seed);
+
+	// Binds the uniform buffer object to the uniform buffer binding point "bindingIndex"
+	void Bind(GLuint bindingIndex) const;
+private:
+	GLuint mUniformBufferObject = 0;
+
+	// We only store weak pointers, since the uniform buffer objects need to get
+	// deleted before the OpenGL context gets destroyed
+	static inline std::unordered_map<unsigned int, std::weak_ptr<const PermutationUniformBuffer>> msUniformBuffers;
+};
\ No newline at end of file
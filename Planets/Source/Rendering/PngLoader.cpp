@@ -34,6 +34,12 @@ Rename this file to lodepng.cpp to use it for C++, or to lodepng.c to use it for
 #include <stdio.h>
 #include <stdlib.h>
 
+/*SSE2 is part of every x86-64 processor, so the SSE2 unfilters need no runtime check nor extra compiler flags*/
+#if !defined(LODEPNG_NO_SSE2) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LODEPNG_SSE2
+#include <emmintrin.h>
+#endif /*SSE2*/
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1310) /*Visual Studio: A few warning types are not desired here.*/
 #pragma warning( disable : 4244 ) /*implicit conversions: not warned by gcc -Wall -Wextra and requires too much casts*/
 #pragma warning( disable : 4996 ) /*VS does not like fopen, but fopen_s is not standard C so unusable here*/
@@ -451,15 +457,18 @@ static unsigned char readBitFromStream(size_t* bitpointer, const unsigned char*
 	return result;
 }
 
+/*reads the bits a whole byte at a time instead of one by one, it only touches the bytes that contain the bits,
+so nbits must be at most 25 and the caller must make sure that the bits are inside the bitstream*/
 static unsigned readBitsFromStream(size_t* bitpointer, const unsigned char* bitstream, size_t nbits)
 {
+	size_t bytepos = *bitpointer >> 3;
+	unsigned shift = (unsigned)(*bitpointer & 0x7);
+	unsigned numbytes = (unsigned)((shift + nbits + 7) >> 3);
 	unsigned result = 0, i;
-	for (i = 0; i != nbits; ++i)
-	{
-		result += ((unsigned)READBIT(*bitpointer, bitstream)) << i;
-		++(*bitpointer);
-	}
-	return result;
+	if (nbits == 0) return 0;
+	for (i = 0; i != numbytes; ++i) result |= (unsigned)bitstream[bytepos + i] << (8 * i);
+	*bitpointer += nbits;
+	return (result >> shift) & ((1u << nbits) - 1u);
 }
 #endif /*LODEPNG_COMPILE_DECODER*/
 
@@ -513,8 +522,14 @@ typedef struct HuffmanTree
 	unsigned* lengths; /*the lengths of the codes of the 1d-tree*/
 	unsigned maxbitlen; /*maximum number of bits a single code can get*/
 	unsigned numcodes; /*number of symbols in the alphabet = number of codes*/
+	unsigned* table; /*lookup table of the decoder for the first HUFFMAN_TABLE_BITS bits, see HuffmanTree_makeTable*/
 } HuffmanTree;
 
+/*the number of bits that the decoder looks up at once, which covers most codes of a typical deflate stream*/
+#define HUFFMAN_TABLE_BITS 9
+/*the low bits of a table entry hold the number of bits it consumes, the high bits hold the value*/
+#define HUFFMAN_TABLE_LENGTH_BITS 5
+
 /*function used for debug purposes to draw the tree in ascii art with C++*/
 /*
 static void HuffmanTree_draw(HuffmanTree* tree)
@@ -533,6 +548,7 @@ static void HuffmanTree_init(HuffmanTree* tree)
 	tree->tree2d = 0;
 	tree->tree1d = 0;
 	tree->lengths = 0;
+	tree->table = 0;
 }
 
 static void HuffmanTree_cleanup(HuffmanTree* tree)
@@ -540,6 +556,7 @@ static void HuffmanTree_cleanup(HuffmanTree* tree)
 	lodepng_free(tree->tree2d);
 	lodepng_free(tree->tree1d);
 	lodepng_free(tree->lengths);
+	lodepng_free(tree->table);
 }
 
 /*the tree representation used by the decoder. return value is error*/
@@ -603,6 +620,49 @@ static unsigned HuffmanTree_make2DTree(HuffmanTree* tree)
 	return 0;
 }
 
+#ifdef LODEPNG_COMPILE_DECODER
+/*
+the lookup table used by the decoder. It is indexed by the next HUFFMAN_TABLE_BITS bits of the stream, in the
+order they are read, and is made by walking the 2D tree, so the decoder gives exactly the same results as when
+walking the tree bit by bit. An entry is one of:
+*) length 1 to HUFFMAN_TABLE_BITS: the code of that length is decoded, the value is the symbol
+*) length HUFFMAN_TABLE_BITS + 1: the code is longer, the value is the tree position after HUFFMAN_TABLE_BITS bits
+*) length 0: the bits lead outside of the tree, the decoder walks the tree bit by bit to report the error
+return value is error
+*/
+static unsigned HuffmanTree_makeTable(HuffmanTree* tree)
+{
+	unsigned index;
+	tree->table = (unsigned*)lodepng_malloc((1u << HUFFMAN_TABLE_BITS) * sizeof(unsigned));
+	if (!tree->table) return 83; /*alloc fail*/
+
+	for (index = 0; index != (1u << HUFFMAN_TABLE_BITS); ++index)
+	{
+		unsigned treepos = 0, i, entry = HUFFMAN_TABLE_BITS + 1;
+		for (i = 0; i != HUFFMAN_TABLE_BITS; ++i)
+		{
+			unsigned ct = tree->tree2d[(treepos << 1) + ((index >> i) & 1)];
+			if (ct < tree->numcodes)
+			{
+				treepos = ct;
+				entry = i + 1;
+				break;
+			}
+			treepos = ct - tree->numcodes;
+			if (treepos >= tree->numcodes)
+			{
+				treepos = 0;
+				entry = 0;
+				break;
+			}
+		}
+		tree->table[index] = (treepos << HUFFMAN_TABLE_LENGTH_BITS) | entry;
+	}
+
+	return 0;
+}
+#endif /*LODEPNG_COMPILE_DECODER*/
+
 /*
 Second step for the ...makeFromLengths and ...makeFromFrequencies functions.
 numcodes, lengths and maxbitlen must already be filled in correctly. return
@@ -644,8 +704,11 @@ static unsigned HuffmanTree_makeFromLengths2(HuffmanTree* tree)
 	uivector_cleanup(&blcount);
 	uivector_cleanup(&nextcode);
 
-	if (!error) return HuffmanTree_make2DTree(tree);
-	else return error;
+	if (!error) error = HuffmanTree_make2DTree(tree);
+#ifdef LODEPNG_COMPILE_DECODER
+	if (!error) error = HuffmanTree_makeTable(tree);
+#endif /*LODEPNG_COMPILE_DECODER*/
+	return error;
 }
 
 /*
@@ -948,6 +1011,31 @@ static unsigned huffmanDecodeSymbol(const unsigned char* in, size_t* bp,
 	const HuffmanTree* codetree, size_t inbitlength)
 {
 	unsigned treepos = 0, ct;
+
+	/*the first bits are decoded with a single table lookup, as long as the input has enough bits left. The
+	HUFFMAN_TABLE_BITS bits span at most 2 bytes, which are both inside the input because of the check.*/
+	if (*bp + HUFFMAN_TABLE_BITS <= inbitlength)
+	{
+		size_t bytepos = *bp >> 3;
+		unsigned shift = (unsigned)(*bp & 0x7);
+		unsigned bits = in[bytepos];
+		unsigned entry, length;
+		if (shift + HUFFMAN_TABLE_BITS > 8) bits |= (unsigned)in[bytepos + 1] << 8;
+		entry = codetree->table[(bits >> shift) & ((1u << HUFFMAN_TABLE_BITS) - 1u)];
+		length = entry & ((1u << HUFFMAN_TABLE_LENGTH_BITS) - 1u);
+		if (length != 0 && length <= HUFFMAN_TABLE_BITS)
+		{
+			*bp += length;
+			return entry >> HUFFMAN_TABLE_LENGTH_BITS;
+		}
+		else if (length != 0)
+		{
+			/*continue walking the tree where the table ended*/
+			*bp += HUFFMAN_TABLE_BITS;
+			treepos = entry >> HUFFMAN_TABLE_LENGTH_BITS;
+		}
+	}
+
 	for (;;)
 	{
 		if (*bp >= inbitlength) return (unsigned)(-1); /*error: end of input memory reached without endcode*/
@@ -3970,6 +4058,147 @@ unsigned lodepng_inspect(unsigned* w, unsigned* h, LodePNGState* state,
 	return state->error;
 }
 
+#ifdef LODEPNG_SSE2
+/*
+SSE2 versions of the filters that have a previous scanline, for 3 and 4 bytes per pixel, i.e. 8-bit RGB and RGBA.
+Sub and Up work on 16 bytes at a time. Avg and Paeth depend on the pixel to the left, so they work on one pixel
+at a time, but on all its channels at once, and without the branches of the scalar Paeth predictor.
+Like unfilterScanline, recon and scanline MAY be the same memory address, since every byte of scanline is read
+before the same byte of recon is written, and nothing is written past length.
+*/
+
+/*loads the bytewidth (3 or 4) bytes of one pixel into the low bytes of the register*/
+static __m128i loadPixelSSE2(const unsigned char* p, size_t bytewidth)
+{
+	int value = 0;
+	memcpy(&value, p, bytewidth);
+	return _mm_cvtsi32_si128(value);
+}
+
+static void storePixelSSE2(unsigned char* p, __m128i pixel, size_t bytewidth)
+{
+	int value = _mm_cvtsi128_si32(pixel);
+	memcpy(p, &value, bytewidth);
+}
+
+static void unfilterSubSSE2(unsigned char* recon, const unsigned char* scanline, size_t bytewidth, size_t length)
+{
+	size_t i = 0;
+	/*the sum of the pixels to the left, i.e. the last unfiltered pixel, in every pixel of the register*/
+	__m128i left = _mm_setzero_si128();
+	if (bytewidth == 4)
+	{
+		/*a prefix sum over the 4 pixels of the register*/
+		for (; i + 16 <= length; i += 16)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, left);
+			_mm_storeu_si128((__m128i*)(recon + i), x);
+			left = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	}
+	else
+	{
+		/*the same prefix sum over 4 pixels of 3 bytes, the last 4 bytes of the register are not stored*/
+		const __m128i firstpixelmask = _mm_cvtsi32_si128(0x00FFFFFF);
+		for (; i + 16 <= length; i += 12)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 3));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 6));
+			x = _mm_add_epi8(x, left);
+			_mm_storel_epi64((__m128i*)(recon + i), x);
+			storePixelSSE2(recon + i + 8, _mm_srli_si128(x, 8), 4);
+			left = _mm_and_si128(_mm_srli_si128(x, 9), firstpixelmask);
+			left = _mm_or_si128(left, _mm_slli_si128(left, 3));
+			left = _mm_or_si128(left, _mm_slli_si128(left, 6));
+		}
+	}
+	if (i == 0)
+	{
+		for (; i != bytewidth && i < length; ++i) recon[i] = scanline[i];
+	}
+	for (; i < length; ++i) recon[i] = scanline[i] + recon[i - bytewidth];
+}
+
+static void unfilterUpSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+	size_t length)
+{
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(precon + i));
+		_mm_storeu_si128((__m128i*)(recon + i), _mm_add_epi8(x, b));
+	}
+	for (; i < length; ++i) recon[i] = scanline[i] + precon[i];
+}
+
+static void unfilterAvgSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+	size_t bytewidth, size_t length)
+{
+	size_t i;
+	const __m128i ones = _mm_set1_epi8(1);
+	/*the first pixel has no pixel to the left, which is the same as a left pixel of 0*/
+	__m128i a = _mm_setzero_si128();
+	for (i = 0; i + bytewidth <= length; i += bytewidth)
+	{
+		__m128i b = loadPixelSSE2(precon + i, bytewidth);
+		__m128i x = loadPixelSSE2(scanline + i, bytewidth);
+		/*_mm_avg_epu8 rounds up, while the filter rounds down, so 1 is subtracted when the sum is odd*/
+		__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+		a = _mm_add_epi8(x, average);
+		storePixelSSE2(recon + i, a, bytewidth);
+	}
+}
+
+/*the absolute value of 16-bit integers*/
+static __m128i absSSE2(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+/*selects a where the mask is set and b elsewhere*/
+static __m128i selectSSE2(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void unfilterPaethSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
+	size_t bytewidth, size_t length)
+{
+	size_t i;
+	const __m128i zero = _mm_setzero_si128();
+	/*the pixels to the left, above and above left, as 16-bit integers. The first pixel has no pixels to the left,
+	and the predictor of 0, precon[i] and 0 is always precon[i], which is what the zeroes give*/
+	__m128i a = zero, c = zero;
+	for (i = 0; i + bytewidth <= length; i += bytewidth)
+	{
+		__m128i b = _mm_unpacklo_epi8(loadPixelSSE2(precon + i, bytewidth), zero);
+		__m128i x = loadPixelSSE2(scanline + i, bytewidth);
+
+		/*the same distances as in paethPredictor, where p = a + b - c*/
+		__m128i pa = _mm_sub_epi16(b, c);
+		__m128i pb = _mm_sub_epi16(a, c);
+		__m128i pc = absSSE2(_mm_add_epi16(pa, pb));
+		__m128i smallest;
+		pa = absSSE2(pa);
+		pb = absSSE2(pb);
+		smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+		/*paethPredictor prefers a over b and b over c when the distances are equal*/
+		x = _mm_add_epi8(x, _mm_packus_epi16(selectSSE2(_mm_cmpeq_epi16(smallest, pa), a,
+			selectSSE2(_mm_cmpeq_epi16(smallest, pb), b, c)), zero));
+		storePixelSSE2(recon + i, x, bytewidth);
+
+		a = _mm_unpacklo_epi8(x, zero);
+		c = b;
+	}
+}
+#endif /*LODEPNG_SSE2*/
+
 static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon,
 	size_t bytewidth, unsigned char filterType, size_t length)
 {
@@ -3983,6 +4212,34 @@ static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scan
 	*/
 
 	size_t i;
+
+#ifdef LODEPNG_SSE2
+	/*the 8-bit RGB and RGBA scanlines, which is what most textures are, use the SSE2 unfilters*/
+	if (bytewidth == 3 || bytewidth == 4)
+	{
+		if (filterType == 1)
+		{
+			unfilterSubSSE2(recon, scanline, bytewidth, length);
+			return 0;
+		}
+		else if (precon && filterType == 2)
+		{
+			unfilterUpSSE2(recon, scanline, precon, length);
+			return 0;
+		}
+		else if (precon && filterType == 3)
+		{
+			unfilterAvgSSE2(recon, scanline, precon, bytewidth, length);
+			return 0;
+		}
+		else if (precon && filterType == 4)
+		{
+			unfilterPaethSSE2(recon, scanline, precon, bytewidth, length);
+			return 0;
+		}
+	}
+#endif /*LODEPNG_SSE2*/
+
 	switch (filterType)
 	{
 	case 0:
@@ -4044,14 +4301,17 @@ static unsigned unfilterScanline(unsigned char* recon, const unsigned char* scan
 	return 0;
 }
 
-static unsigned unfilter(unsigned char* out, const unsigned char* in, unsigned w, unsigned h, unsigned bpp)
+static unsigned unfilter(unsigned char* out, const unsigned char* in, unsigned w, unsigned h, unsigned bpp,
+	unsigned flip_vertically)
 {
 	/*
 	For PNG filter method 0
 	this function unfilters a single image (e.g. without interlacing this is called once, with Adam7 seven times)
 	out must have enough bytes allocated already, in must have the scanlines + 1 filtertype byte per scanline
 	w and h are image dimensions or dimensions of reduced image, bpp is bits per pixel
-	in and out are allowed to be the same memory address (but aren't the same size since in has the extra filter bytes)
+	in and out are allowed to be the same memory address (but aren't the same size since in has the extra filter bytes),
+	but only if flip_vertically is 0
+	if flip_vertically is 1, the scanlines are written to out bottom-up, so that the first scanline ends up last
 	*/
 
 	unsigned y;
@@ -4063,7 +4323,7 @@ static unsigned unfilter(unsigned char* out, const unsigned char* in, unsigned w
 
 	for (y = 0; y < h; ++y)
 	{
-		size_t outindex = linebytes * y;
+		size_t outindex = linebytes * (flip_vertically ? h - 1 - y : y);
 		size_t inindex = (1 + linebytes) * y; /*the extra filterbyte added to each row*/
 		unsigned char filterType = in[inindex];
 
@@ -4086,7 +4346,8 @@ out must be big enough AND must be 0 everywhere if bpp < 8 in the current implem
 (because that's likely a little bit faster)
 NOTE: comments about padding bits are only relevant if bpp < 8
 */
-static void Adam7_deinterlace(unsigned char* out, const unsigned char* in, unsigned w, unsigned h, unsigned bpp)
+static void Adam7_deinterlace(unsigned char* out, const unsigned char* in, unsigned w, unsigned h, unsigned bpp,
+	unsigned flip_vertically)
 {
 	unsigned passw[7], passh[7];
 	size_t filter_passstart[8], padded_passstart[8], passstart[8];
@@ -4104,7 +4365,8 @@ static void Adam7_deinterlace(unsigned char* out, const unsigned char* in, unsig
 				for (x = 0; x < passw[i]; ++x)
 				{
 					size_t pixelinstart = passstart[i] + (y * passw[i] + x) * bytewidth;
-					size_t pixeloutstart = ((ADAM7_IY[i] + y * ADAM7_DY[i]) * w + ADAM7_IX[i] + x * ADAM7_DX[i]) * bytewidth;
+					size_t outy = ADAM7_IY[i] + y * ADAM7_DY[i];
+					size_t pixeloutstart = ((flip_vertically ? h - 1 - outy : outy) * w + ADAM7_IX[i] + x * ADAM7_DX[i]) * bytewidth;
 					for (b = 0; b < bytewidth; ++b)
 					{
 						out[pixeloutstart + b] = in[pixelinstart + b];
@@ -4124,7 +4386,8 @@ static void Adam7_deinterlace(unsigned char* out, const unsigned char* in, unsig
 				for (x = 0; x < passw[i]; ++x)
 				{
 					ibp = (8 * passstart[i]) + (y * ilinebits + x * bpp);
-					obp = (ADAM7_IY[i] + y * ADAM7_DY[i]) * olinebits + (ADAM7_IX[i] + x * ADAM7_DX[i]) * bpp;
+					size_t outy = ADAM7_IY[i] + y * ADAM7_DY[i];
+					obp = (flip_vertically ? h - 1 - outy : outy) * olinebits + (ADAM7_IX[i] + x * ADAM7_DX[i]) * bpp;
 					for (b = 0; b < bpp; ++b)
 					{
 						unsigned char bit = readBitFromReversedStream(&ibp, in);
@@ -4163,11 +4426,30 @@ static void removePaddingBits(unsigned char* out, const unsigned char* in,
 	}
 }
 
+/*swaps the scanlines of the image in place, so that the first scanline ends up last*/
+static void flipScanlines(unsigned char* buffer, size_t linebytes, unsigned h)
+{
+	unsigned y;
+	for (y = 0; y < h / 2; ++y)
+	{
+		unsigned char* top = &buffer[linebytes * y];
+		unsigned char* bottom = &buffer[linebytes * (h - 1 - y)];
+		size_t i;
+		for (i = 0; i != linebytes; ++i)
+		{
+			unsigned char temp = top[i];
+			top[i] = bottom[i];
+			bottom[i] = temp;
+		}
+	}
+}
+
 /*out must be buffer big enough to contain full image, and in must contain the full decompressed data from
 the IDAT chunks (with filter index bytes and possible padding bits)
+if flip_vertically is 1, the scanlines of out are stored bottom-up
 return value is error*/
 static unsigned postProcessScanlines(unsigned char* out, unsigned char* in,
-	unsigned w, unsigned h, const LodePNGInfo* info_png)
+	unsigned w, unsigned h, const LodePNGInfo* info_png, unsigned flip_vertically)
 {
 	/*
 	This function converts the filtered-padded-interlaced data into pure 2D image buffer with the PNG's colortype.
@@ -4183,11 +4465,13 @@ static unsigned postProcessScanlines(unsigned char* out, unsigned char* in,
 	{
 		if (bpp < 8 && w * bpp != ((w * bpp + 7) / 8) * 8)
 		{
-			CERROR_TRY_RETURN(unfilter(in, in, w, h, bpp));
+			CERROR_TRY_RETURN(unfilter(in, in, w, h, bpp, 0));
+			/*the padded scanlines still start at a byte, so they can be swapped bytewise*/
+			if (flip_vertically) flipScanlines(in, (w * bpp + 7) / 8, h);
 			removePaddingBits(out, in, w * bpp, ((w * bpp + 7) / 8) * 8, h);
 		}
-		/*we can immediately filter into the out buffer, no other steps needed*/
-		else CERROR_TRY_RETURN(unfilter(out, in, w, h, bpp));
+		/*we can immediately filter into the out buffer, no other steps needed, the flip is done while unfiltering*/
+		else CERROR_TRY_RETURN(unfilter(out, in, w, h, bpp, flip_vertically));
 	}
 	else /*interlace_method is 1 (Adam7)*/
 	{
@@ -4198,7 +4482,7 @@ static unsigned postProcessScanlines(unsigned char* out, unsigned char* in,
 
 		for (i = 0; i != 7; ++i)
 		{
-			CERROR_TRY_RETURN(unfilter(&in[padded_passstart[i]], &in[filter_passstart[i]], passw[i], passh[i], bpp));
+			CERROR_TRY_RETURN(unfilter(&in[padded_passstart[i]], &in[filter_passstart[i]], passw[i], passh[i], bpp, 0));
 			/*TODO: possible efficiency improvement: if in this reduced image the bits fit nicely in 1 scanline,
 			move bytes instead of bits or move not at all*/
 			if (bpp < 8)
@@ -4210,7 +4494,8 @@ static unsigned postProcessScanlines(unsigned char* out, unsigned char* in,
 			}
 		}
 
-		Adam7_deinterlace(out, in, w, h, bpp);
+		/*the flip is done while deinterlacing*/
+		Adam7_deinterlace(out, in, w, h, bpp, flip_vertically);
 	}
 
 	return 0;
@@ -4523,7 +4808,8 @@ static unsigned readChunk_pHYs(LodePNGInfo* info, const unsigned char* data, siz
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
 /*read a PNG, the result will be in the same color type as the PNG (hence "generic")*/
-static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
+/*reads the chunks and decompresses the IDAT data into scanlines, which the caller must clean up, also on error*/
+static void decodeScanlines(ucvector* scanlines, unsigned* w, unsigned* h,
 	LodePNGState* state,
 	const unsigned char* in, size_t insize)
 {
@@ -4531,10 +4817,8 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 	const unsigned char* chunk;
 	size_t i;
 	ucvector idat; /*the data from idat chunks*/
-	ucvector scanlines;
 	size_t predict;
 	size_t numpixels;
-	size_t outsize = 0;
 
 	/*for unknown chunk order*/
 	unsigned unknown = 0;
@@ -4542,8 +4826,7 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 	unsigned critical_pos = 1; /*1 = after IHDR, 2 = after PLTE, 3 = after IDAT*/
 #endif /*LODEPNG_COMPILE_ANCILLARY_CHUNKS*/
 
-							   /*provide some proper output values if error will happen*/
-	*out = 0;
+	ucvector_init(scanlines);
 
 	state->error = lodepng_inspect(w, h, state, in, insize); /*reads header and resets other parameters in state->info_png*/
 	if (state->error) return;
@@ -4691,7 +4974,6 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 		if (!IEND) chunk = lodepng_chunk_next_const(chunk);
 	}
 
-	ucvector_init(&scanlines);
 	/*predict output size, to allocate exact size for output buffer to avoid more dynamic allocation.
 	If the decompressed size does not match the prediction, the image must be corrupt.*/
 	if (state->info_png.interlace_method == 0)
@@ -4712,14 +4994,28 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 		if (*w > 1) predict += lodepng_get_raw_size_idat((*w + 0) >> 1, (*h + 1) >> 1, color) + ((*h + 1) >> 1);
 		predict += lodepng_get_raw_size_idat((*w + 0), (*h + 0) >> 1, color) + ((*h + 0) >> 1);
 	}
-	if (!state->error && !ucvector_reserve(&scanlines, predict)) state->error = 83; /*alloc fail*/
+	if (!state->error && !ucvector_reserve(scanlines, predict)) state->error = 83; /*alloc fail*/
 	if (!state->error)
 	{
-		state->error = zlib_decompress(&scanlines.data, &scanlines.size, idat.data,
+		state->error = zlib_decompress(&scanlines->data, &scanlines->size, idat.data,
 			idat.size, &state->decoder.zlibsettings);
-		if (!state->error && scanlines.size != predict) state->error = 91; /*decompressed size doesn't match prediction*/
+		if (!state->error && scanlines->size != predict) state->error = 91; /*decompressed size doesn't match prediction*/
 	}
 	ucvector_cleanup(&idat);
+}
+
+static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
+	LodePNGState* state,
+	const unsigned char* in, size_t insize)
+{
+	ucvector scanlines;
+	size_t i;
+	size_t outsize = 0;
+
+	/*provide some proper output values if error will happen*/
+	*out = 0;
+
+	decodeScanlines(&scanlines, w, h, state, in, insize);
 
 	if (!state->error)
 	{
@@ -4730,7 +5026,8 @@ static void decodeGeneric(unsigned char** out, unsigned* w, unsigned* h,
 	if (!state->error)
 	{
 		for (i = 0; i < outsize; i++) (*out)[i] = 0;
-		state->error = postProcessScanlines(*out, scanlines.data, *w, *h, &state->info_png);
+		state->error = postProcessScanlines(*out, scanlines.data, *w, *h, &state->info_png,
+			state->decoder.flip_vertically);
 	}
 	ucvector_cleanup(&scanlines);
 }
@@ -4780,6 +5077,113 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
 	return state->error;
 }
 
+unsigned lodepng_decode_rows(LodePNGRowCallback callback, void* user, unsigned* w, unsigned* h,
+	LodePNGState* state,
+	const unsigned char* in, size_t insize)
+{
+	const LodePNGColorMode* mode_out;
+	unsigned convert;
+	size_t rowsize;
+	unsigned y;
+
+	state->error = lodepng_inspect(w, h, state, in, insize);
+	if (state->error) return state->error;
+
+	mode_out = state->decoder.color_convert ? &state->info_raw : &state->info_png.color;
+	convert = state->decoder.color_convert && !lodepng_color_mode_equal(&state->info_raw, &state->info_png.color);
+	/*the rows are emitted as whole bytes*/
+	if (lodepng_get_bpp(mode_out) < 8) CERROR_RETURN_ERROR(state->error, 95);
+	/*the same conversions as lodepng_decode supports*/
+	if (convert && !(state->info_raw.colortype == LCT_RGB || state->info_raw.colortype == LCT_RGBA)
+		&& !(state->info_raw.bitdepth == 8))
+	{
+		CERROR_RETURN_ERROR(state->error, 56);
+	}
+	rowsize = lodepng_get_raw_size(*w, 1, mode_out);
+
+	if (state->info_png.interlace_method == 0)
+	{
+		/*the scanlines are unfiltered in place, each one right after the one above it, and are emitted right away,
+		so the image is never stored in the color type of the PNG as a whole*/
+		ucvector scanlines;
+		unsigned char* row = 0;
+		unsigned bpp = lodepng_get_bpp(&state->info_png.color);
+		size_t bytewidth = (bpp + 7) / 8;
+		size_t linebytes = ((size_t)*w * bpp + 7) / 8;
+		unsigned char* prevline = 0;
+
+		decodeScanlines(&scanlines, w, h, state, in, insize);
+		if (!state->error && convert)
+		{
+			row = (unsigned char*)lodepng_malloc(rowsize);
+			if (!row) state->error = 83; /*alloc fail*/
+		}
+
+		for (y = 0; y < *h && !state->error; ++y)
+		{
+			unsigned char* line = &scanlines.data[(1 + linebytes) * y + 1];
+			state->error = unfilterScanline(line, line, prevline, bytewidth, line[-1], linebytes);
+			if (state->error) break;
+			prevline = line;
+
+			if (convert)
+			{
+				/*an unfiltered scanline starts at a byte, so it can be converted as an image that is 1 pixel high*/
+				state->error = lodepng_convert(row, line, &state->info_raw, &state->info_png.color, *w, 1);
+				if (state->error) break;
+			}
+			callback(user, state->decoder.flip_vertically ? *h - 1 - y : y, convert ? row : line, rowsize);
+		}
+
+		lodepng_free(row);
+		ucvector_cleanup(&scanlines);
+	}
+	else
+	{
+		/*Adam7 needs all 7 reduced images before any row is complete, so the image is decoded as a whole*/
+		unsigned char* image = 0;
+		state->error = lodepng_decode(&image, w, h, state, in, insize);
+		for (y = 0; y < *h && !state->error; ++y) callback(user, y, &image[rowsize * y], rowsize);
+		lodepng_free(image);
+		return state->error;
+	}
+
+	/*like lodepng_decode, info_raw reflects the color type of the rows*/
+	if (!state->error && !state->decoder.color_convert)
+	{
+		state->error = lodepng_color_mode_copy(&state->info_raw, &state->info_png.color);
+	}
+	return state->error;
+}
+
+/*the destination of the rows of lodepng_decode_into*/
+typedef struct DecodeIntoBuffer
+{
+	unsigned char* out;
+} DecodeIntoBuffer;
+
+static void copyRowIntoBuffer(void* user, unsigned y, const unsigned char* row, size_t rowsize)
+{
+	memcpy(((DecodeIntoBuffer*)user)->out + rowsize * y, row, rowsize);
+}
+
+unsigned lodepng_decode_into(unsigned char* out, size_t outsize, unsigned* w, unsigned* h,
+	LodePNGState* state,
+	const unsigned char* in, size_t insize)
+{
+	DecodeIntoBuffer buffer;
+	const LodePNGColorMode* mode_out;
+
+	state->error = lodepng_inspect(w, h, state, in, insize);
+	if (state->error) return state->error;
+
+	mode_out = state->decoder.color_convert ? &state->info_raw : &state->info_png.color;
+	if (lodepng_get_raw_size(*w, *h, mode_out) > outsize) CERROR_RETURN_ERROR(state->error, 96);
+
+	buffer.out = out;
+	return lodepng_decode_rows(copyRowIntoBuffer, &buffer, w, h, state, in, insize);
+}
+
 unsigned lodepng_decode_memory(unsigned char** out, unsigned* w, unsigned* h, const unsigned char* in,
 	size_t insize, LodePNGColorType colortype, unsigned bitdepth)
 {
@@ -4830,6 +5234,7 @@ unsigned lodepng_decode24_file(unsigned char** out, unsigned* w, unsigned* h, co
 void lodepng_decoder_settings_init(LodePNGDecoderSettings* settings)
 {
 	settings->color_convert = 1;
+	settings->flip_vertically = 0;
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
 	settings->read_text_chunks = 1;
 	settings->remember_unknown_chunks = 0;
@@ -6015,6 +6420,8 @@ const char* lodepng_error_text(unsigned code)
 	case 92: return "too many pixels, not supported";
 	case 93: return "zero width or height is invalid";
 	case 94: return "header chunk must have a size of 13 bytes";
+	case 95: return "decoding rows requires at least 8 bits per pixel in the output color type";
+	case 96: return "the output buffer is too small for the decoded image";
 	}
 	return "unknown error code";
 }
@@ -6164,6 +6571,20 @@ namespace lodepng
 		return decode(out, w, h, state, in.empty() ? 0 : &in[0], in.size());
 	}
 
+	unsigned decode(unsigned char* out, size_t outsize, unsigned& w, unsigned& h,
+		State& state,
+		const unsigned char* in, size_t insize)
+	{
+		return lodepng_decode_into(out, outsize, &w, &h, &state, in, insize);
+	}
+
+	unsigned decode(unsigned char* out, size_t outsize, unsigned& w, unsigned& h,
+		State& state,
+		const std::vector<unsigned char>& in)
+	{
+		return decode(out, outsize, w, h, state, in.empty() ? 0 : &in[0], in.size());
+	}
+
 #ifdef LODEPNG_COMPILE_DISK
 	unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h, const std::string& filename,
 		LodePNGColorType colortype, unsigned bitdepth)
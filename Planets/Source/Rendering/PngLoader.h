@@ -529,6 +529,11 @@ typedef struct LodePNGDecoderSettings
 
 	unsigned color_convert; /*whether to convert the PNG to the color type you want. Default: yes*/
 
+	/*whether to store the scanlines bottom-up, i.e., the first pixel of the output is the lower left
+	corner of the image, which is where OpenGL expects it to be. The flip is done while unfiltering or
+	deinterlacing, so it costs no extra pass nor buffer. Default: no*/
+	unsigned flip_vertically;
+
 #ifdef LODEPNG_COMPILE_ANCILLARY_CHUNKS
 	unsigned read_text_chunks; /*if false but remember_unknown_chunks is true, they're stored in the unknown chunks*/
 							   /*store all bytes from unknown chunks in the LodePNGInfo (off by default, useful for a png editor)*/
@@ -656,6 +661,31 @@ unsigned lodepng_decode(unsigned char** out, unsigned* w, unsigned* h,
 	LodePNGState* state,
 	const unsigned char* in, size_t insize);
 
+/*
+Called by lodepng_decode_rows for every row of the decoded image. y is the index of the row in the output
+image, i.e. counted from the bottom if flip_vertically is set, row holds rowsize bytes in the color type of
+info_raw (or of the PNG if color_convert is off), and is only valid during the call.
+*/
+typedef void (*LodePNGRowCallback)(void* user, unsigned y, const unsigned char* row, size_t rowsize);
+
+/*
+Same as lodepng_decode, but emits the decoded image row by row to the callback, instead of allocating it.
+Without interlacing, every scanline is unfiltered in place in the decompressed data and converted on its own,
+so neither the image in the color type of the PNG, nor the output image, is ever allocated as a whole. The
+output color type must have at least 8 bits per pixel. The order of the rows is not specified, only y is.
+*/
+unsigned lodepng_decode_rows(LodePNGRowCallback callback, void* user, unsigned* w, unsigned* h,
+	LodePNGState* state,
+	const unsigned char* in, size_t insize);
+
+/*
+Same as lodepng_decode, but decodes into the caller's buffer "out" of outsize bytes, which must be large
+enough for the whole image in the color type of info_raw, see lodepng_get_raw_size.
+*/
+unsigned lodepng_decode_into(unsigned char* out, size_t outsize, unsigned* w, unsigned* h,
+	LodePNGState* state,
+	const unsigned char* in, size_t insize);
+
 /*
 Read the PNG header, but not the actual data. This returns only the information
 that is in the header chunk of the PNG, such as width, height and color type. The
@@ -839,6 +869,14 @@ namespace lodepng
 	unsigned decode(std::vector<unsigned char>& out, unsigned& w, unsigned& h,
 		State& state,
 		const std::vector<unsigned char>& in);
+
+	/* Same as lodepng_decode_into, i.e. decodes into the caller's buffer of outsize bytes. */
+	unsigned decode(unsigned char* out, size_t outsize, unsigned& w, unsigned& h,
+		State& state,
+		const unsigned char* in, size_t insize);
+	unsigned decode(unsigned char* out, size_t outsize, unsigned& w, unsigned& h,
+		State& state,
+		const std::vector<unsigned char>& in);
 #endif /*LODEPNG_COMPILE_DECODER*/
 
 #ifdef LODEPNG_COMPILE_ENCODER
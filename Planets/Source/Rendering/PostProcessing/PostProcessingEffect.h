@@ -2,7 +2,12 @@
 #include "GL/glew.h"
 #include "../GlMacro.h"
 #include "../Program.h"
+#include "ScreenRectangle.h"
+#include <optional>
 
+// A node of the post-processing graph. Its input is the colour that the previous effect
+// output, or the rendered scene if it is the first effect, together with the depth of the
+// scene, and it outputs a colour for every pixel.
 class PostProcessingEffect
 {
 public:
@@ -12,15 +17,75 @@ public:
 		mPreparationFunction(preparationFunction)
 	{}
 
-	void Render(GLuint colourTexture, GLuint depthTexture) const
+	// "boundsFunction" returns the region of the screen that the effect can change,
+	// every frame. The pixels outside of it are copied, instead of running the effect.
+	PostProcessingEffect(Program program, std::function<void(GLuint, GLuint)> preparationFunction,
+		std::function<ScreenRectangle()> boundsFunction)
+		:
+		mProgram(std::move(program)),
+		mPreparationFunction(preparationFunction),
+		mBoundsFunction(boundsFunction)
+	{}
+
+	// Creates an effect that only reads its input at the pixel that it outputs, which lets
+	// the "PostProcessor" fuse it with the per-pixel effects next to it, into a single pass.
+	// The file "filename" should only contain a fragment shader, which defines the function
+	// "vec4 <filename>(vec4 colour, vec2 uv)". Since the fused effects get linked into the same
+	// program, their uniform locations, texture units and function names must not overlap.
+	static PostProcessingEffect CreatePerPixel(const std::string& filename,
+		std::function<void(GLuint, GLuint)> preparationFunction,
+		std::function<ScreenRectangle()> boundsFunction = {})
 	{
-		mProgram.Bind();
-		mPreparationFunction(colourTexture, depthTexture);
+		PostProcessingEffect effect(filename, preparationFunction);
+		effect.mBoundsFunction = boundsFunction;
+		return effect;
+	}
+
+	bool IsPerPixel() const
+	{
+		return !mProgram.has_value();
+	}
 
-		GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+	// The file of a per-pixel effect, which also is the name of its function
+	const std::string& GetFilename() const
+	{
+		return mFilename;
+	}
+
+	// Returns null for a per-pixel effect, which runs inside the program of the fused effects
+	const Program* GetProgram() const
+	{
+		return mProgram ? &*mProgram : nullptr;
+	}
+
+	bool IsBounded() const
+	{
+		return (bool)mBoundsFunction;
+	}
+
+	ScreenRectangle GetBounds() const
+	{
+		return mBoundsFunction ? mBoundsFunction() : ScreenRectangle::GetScreen();
+	}
+
+	// Sets the uniforms and binds the textures that the effect needs, once its program is bound. The
+	// colour that the effect reads, and the depth, are already bound to the texture units 0 and 1.
+	void Prepare(GLuint colourTexture, GLuint depthTexture) const
+	{
+		mPreparationFunction(colourTexture, depthTexture);
 	}
 
 private:
-	Program mProgram;
+	PostProcessingEffect(const std::string& filename, std::function<void(GLuint, GLuint)> preparationFunction)
+		:
+		mFilename(filename),
+		mPreparationFunction(preparationFunction)
+	{}
+
+	// Empty for a per-pixel effect
+	std::optional<Program> mProgram;
+	std::string mFilename;
 	std::function<void(GLuint, GLuint)> mPreparationFunction;
+	// Empty when the effect can change every pixel of the screen
+	std::function<ScreenRectangle()> mBoundsFunction;
 };
\ No newline at end of file
@@ -1,29 +1,56 @@
 #include "PostProcessor.h"
 #include "Source/Window/Window.h"
+#include "../../Benchmark/BenchmarkMacros.h"
+#include "../GlStateCache.h"
 
 PostProcessor::PostProcessor(std::function<void()> renderingFunction)
 	:
-	mRenderingFunction(renderingFunction)
+	mRenderingFunction(renderingFunction),
+	mRenderWidth(Window::GetWidth()),
+	mRenderHeight(Window::GetHeight())
 {
-	InitializeTextures();
 	InitializeFramebuffer();
+	InitializeTextures();
+	mRenderTargetPool.SetSize(mRenderWidth, mRenderHeight);
+}
+
+PostProcessor::PostProcessor(std::function<void()> renderingFunction,
+	std::unordered_map<std::string, PostProcessingEffect> effects, const std::vector<std::string>& enabledEffects)
+	:
+	PostProcessor(renderingFunction)
+{
+	for (auto& [effectName, effect] : effects)
+	{
+		AddEffect(effectName, std::move(effect));
+	}
+	SetEffects(enabledEffects);
 }
 
 PostProcessor::~PostProcessor()
 {
 	// Destructors should not throw exception, hence no GL macros
 	glDeleteFramebuffers(1, &mFramebuffer);
-	glDeleteTextures(1, &mTexture);
-	glDeleteTextures(1, &mDepthTexture);
+	GlStateCache::ForgetFramebuffer(mFramebuffer);
+	DeleteTextures();
 }
 
-void PostProcessor::Render(const std::string& effect) const
+void PostProcessor::Render() const
 {
 	StartRenderingIntoTexture();
 	mRenderingFunction();
 	StopRenderingIntoTexture();
-	// Render the texture, with the given effect: "effect"
-	RenderTextureWithEffect(effect);
+
+	if (mPasses.empty())
+	{
+		Copy(GetSceneTarget(), RenderTarget{ 0, 0, Window::GetWidth(), Window::GetHeight() },
+			ScreenRectangle::GetScreen());
+		return;
+	}
+
+	for (const Pass& pass : mPasses)
+	{
+		RenderPass(pass);
+	}
 }
 
 void PostProcessor::AddEffect(const std::string& effectName, PostProcessingEffect effect)
@@ -34,42 +61,282 @@ void PostProcessor::AddEffect(const std::string& effectName, PostProcessingEffec
 	mNameToEffect.insert({ effectName, std::move(effect) });
 }
 
+void PostProcessor::SetEffects(const std::vector<std::string>& effects)
+{
+	mPasses.clear();
+	mEffects = effects;
+
+	// Group the effects into passes, where a per-pixel effect joins the
+	// pass before it, if that pass consists of per-pixel effects
+	for (const auto& effectName : effects)
+	{
+		// Make sure that the effect has been added
+		assert(mNameToEffect.find(effectName) != mNameToEffect.end());
+
+		const PostProcessingEffect& effect = mNameToEffect.at(effectName);
+		if (effect.IsPerPixel() && !mPasses.empty() && mPasses.back().effects.front()->IsPerPixel())
+		{
+			mPasses.back().name += " + " + effectName;
+			mPasses.back().effects.push_back(&effect);
+			continue;
+		}
+
+		Pass pass;
+		pass.name = effectName;
+		pass.effects.push_back(&effect);
+		mPasses.push_back(std::move(pass));
+	}
+
+	// Every pooled target gets released by the pass that reads it, which leaves every target of
+	// the pool free once the passes have been built, ready to be handed out the next time
+	RenderTarget input = GetSceneTarget();
+	for (size_t i = 0; i < mPasses.size(); ++i)
+	{
+		Pass& pass = mPasses[i];
+		pass.program = pass.effects.front()->IsPerPixel() ?
+			&GetFusedProgram(pass.effects) : pass.effects.front()->GetProgram();
+		pass.input = input;
+		// The output is acquired before the input is released, so that they never are the same target.
+		// The last pass renders into the back buffer, at the resolution of the window.
+		pass.output = i + 1 == mPasses.size() ?
+			RenderTarget{ 0, 0, Window::GetWidth(), Window::GetHeight() } : mRenderTargetPool.Acquire();
+		if (input.framebuffer != mFramebuffer)
+		{
+			mRenderTargetPool.Release(input);
+		}
+		input = pass.output;
+	}
+}
+
+void PostProcessor::SetRenderScale(const float scale)
+{
+	if (scale == mRenderScale)
+	{
+		return;
+	}
+
+	mRenderScale = scale;
+	mRenderWidth = std::max((int)std::round((float)Window::GetWidth() * scale), 1);
+	mRenderHeight = std::max((int)std::round((float)Window::GetHeight() * scale), 1);
+
+	DeleteTextures();
+	InitializeTextures();
+	mRenderTargetPool.SetSize(mRenderWidth, mRenderHeight);
+	// Rebuild the passes, which refer to the targets that were just deleted
+	const std::vector<std::string> effects = mEffects;
+	SetEffects(effects);
+}
+
 void PostProcessor::InitializeTextures()
 {
 	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mTexture));
-	GL(glTextureStorage2D(mTexture, 1, GL_RGBA8, Window::GetWidth(), Window::GetHeight()));
+	GL(glTextureStorage2D(mTexture, 1, GL_RGBA8, mRenderWidth, mRenderHeight));
+	// The last pass upscales the texture, when the render resolution is lower than the window's
+	GL(glTextureParameteri(mTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GL(glTextureParameteri(mTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GL(glTextureParameteri(mTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GL(glTextureParameteri(mTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
 	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mDepthTexture));
-	GL(glTextureStorage2D(mDepthTexture, 1, GL_DEPTH_COMPONENT32F, Window::GetWidth(), Window::GetHeight()));
+	GL(glTextureStorage2D(mDepthTexture, 1, GL_DEPTH_COMPONENT32F, mRenderWidth, mRenderHeight));
+	// Depths should not be blended, since that would make up
+	// points that are halfway between the foreground and the background
+	GL(glTextureParameteri(mDepthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GL(glTextureParameteri(mDepthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GL(glTextureParameteri(mDepthTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GL(glTextureParameteri(mDepthTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+	GL(glNamedFramebufferTexture(mFramebuffer, GL_COLOR_ATTACHMENT0, mTexture, 0));
+	// We need to give the framebuffer a depth texture, in order for us to be able to use depth testing
+	GL(glNamedFramebufferTexture(mFramebuffer, GL_DEPTH_ATTACHMENT, mDepthTexture, 0));
 }
 
 void PostProcessor::InitializeFramebuffer()
 {
 	GL(glCreateFramebuffers(1, &mFramebuffer));
-	GL(glNamedFramebufferTexture(mFramebuffer, GL_COLOR_ATTACHMENT0, mTexture, 0));
-
-	// We need to give the framebuffer a depth texture, in order for us to be able to use depth testing
-	GL(glNamedFramebufferTexture(mFramebuffer, GL_DEPTH_ATTACHMENT, mDepthTexture, 0));
 
 	// Make the rendering go into the texture, while we are using the framebuffer
 	GL(glNamedFramebufferDrawBuffer(mFramebuffer, GL_COLOR_ATTACHMENT0));
 }
 
+void PostProcessor::DeleteTextures()
+{
+	// Called by the destructor, which should not throw exception, hence no GL macros
+	glDeleteTextures(1, &mTexture);
+	glDeleteTextures(1, &mDepthTexture);
+	GlStateCache::ForgetTexture(mTexture);
+	GlStateCache::ForgetTexture(mDepthTexture);
+}
+
+RenderTarget PostProcessor::GetSceneTarget() const
+{
+	return RenderTarget{ mFramebuffer, mTexture, mRenderWidth, mRenderHeight };
+}
+
 void PostProcessor::StartRenderingIntoTexture() const
 {
-	GL(glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer));
+	GlStateCache::Get().BindFramebuffer(mFramebuffer);
+	GL(glViewport(0, 0, mRenderWidth, mRenderHeight));
 	GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 }
 
 void PostProcessor::StopRenderingIntoTexture() const
 {
-	GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GlStateCache::Get().BindFramebuffer(0);
+}
+
+void PostProcessor::RenderPass(const Pass& pass) const
+{
+	GPU_BENCHMARK(pass.name);
+
+	ScreenRectangle bounds;
+	const bool isBounded = GetBounds(pass, bounds);
+	if (isBounded)
+	{
+		// The pass leaves the pixels outside of its bounds unchanged, so they are
+		// copied, which is a lot cheaper than running the pass' fragment shader
+		CopyOutside(pass.input, pass.output, bounds);
+		if (bounds.IsEmpty())
+		{
+			return;
+		}
+	}
+
+	GlStateCache& stateCache = GlStateCache::Get();
+	stateCache.BindFramebuffer(pass.output.framebuffer);
+	GL(glViewport(0, 0, pass.output.width, pass.output.height));
+	pass.program->Bind();
+	stateCache.BindTextureUnit(0, pass.input.texture);
+	stateCache.BindTextureUnit(1, mDepthTexture);
+	for (const PostProcessingEffect* effect : pass.effects)
+	{
+		effect->Prepare(pass.input.texture, mDepthTexture);
+	}
+
+	if (isBounded)
+	{
+		// The bounds are in the pixels of the window, which the output might be smaller than
+		const ScreenRectangle scissor = ConvertToTarget(bounds, pass.output);
+		stateCache.SetEnabled(GL_SCISSOR_TEST, true);
+		GL(glScissor(scissor.x, scissor.y, scissor.width, scissor.height));
+	}
+	GL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+	if (isBounded)
+	{
+		stateCache.SetEnabled(GL_SCISSOR_TEST, false);
+	}
 }
 
-void PostProcessor::RenderTextureWithEffect(const std::string& effect) const
+const Program& PostProcessor::GetFusedProgram(const std::vector<const PostProcessingEffect*>& effects)
 {
-	// Make sure that the effect has been added
-	assert(mNameToEffect.find(effect) != mNameToEffect.end());
+	std::vector<std::string> filenames = { "PerPixelEffects" };
+	std::string name;
+	for (const PostProcessingEffect* effect : effects)
+	{
+		filenames.push_back(effect->GetFilename());
+		name += (name.empty() ? "" : " + ") + effect->GetFilename();
+	}
 
-	mNameToEffect.at(effect).Render(mTexture, mDepthTexture);
+	auto iterator = mFusedPrograms.find(name);
+	if (iterator == mFusedPrograms.end())
+	{
+		iterator = mFusedPrograms.emplace(name, Program(filenames, { CreateFusedFragmentSource(effects) }, name)).first;
+	}
+	return iterator->second;
 }
+
+std::string PostProcessor::CreateFusedFragmentSource(const std::vector<const PostProcessingEffect*>& effects)
+{
+	// The functions are defined by the shaders of the effects, which get linked into the same program
+	std::string declarations;
+	std::string calls;
+	for (const PostProcessingEffect* effect : effects)
+	{
+		declarations += "vec4 " + effect->GetFilename() + "(const vec4 colour, const vec2 uv);\n";
+		calls += "\tpixelColour = " + effect->GetFilename() + "(pixelColour, uv);\n";
+	}
+
+	// The type of the shader comes first, just like after "#Shader" inside a file
+	return "Fragment\n"
+		"#version 450 core\n"
+		"layout(binding = 0) uniform sampler2D inputTexture;\n" +
+		declarations +
+		"in vec2 uv;\n"
+		"out vec4 colour;\n"
+		"void main()\n"
+		"{\n"
+		"\tvec4 pixelColour = texture(inputTexture, uv);\n" +
+		calls +
+		"\tcolour = pixelColour;\n"
+		"}\n";
+}
+
+bool PostProcessor::GetBounds(const Pass& pass, ScreenRectangle& bounds)
+{
+	// The pass can change the pixels that any of its effects can change
+	bounds = ScreenRectangle{};
+	for (const PostProcessingEffect* effect : pass.effects)
+	{
+		if (!effect->IsBounded())
+		{
+			return false;
+		}
+		bounds = ScreenRectangle::GetUnion(bounds, effect->GetBounds());
+	}
+	return true;
+}
+
+void PostProcessor::CopyOutside(const RenderTarget& source, const RenderTarget& destination,
+	const ScreenRectangle& bounds) const
+{
+	const ScreenRectangle screen = ScreenRectangle::GetScreen();
+	if (bounds.IsEmpty())
+	{
+		Copy(source, destination, screen);
+		return;
+	}
+
+	// The strips below and above the bounds span the whole width of the
+	// screen, while the strips to the left and right fill the gap in between
+	Copy(source, destination, ScreenRectangle{ 0, 0, screen.width, bounds.y });
+	Copy(source, destination, ScreenRectangle{ 0, bounds.y + bounds.height,
+		screen.width, screen.height - bounds.y - bounds.height });
+	Copy(source, destination, ScreenRectangle{ 0, bounds.y, bounds.x, bounds.height });
+	Copy(source, destination, ScreenRectangle{ bounds.x + bounds.width, bounds.y,
+		screen.width - bounds.x - bounds.width, bounds.height });
+}
+
+void PostProcessor::Copy(const RenderTarget& source, const RenderTarget& destination,
+	const ScreenRectangle& rectangle) const
+{
+	if (rectangle.IsEmpty())
+	{
+		return;
+	}
+
+	const ScreenRectangle from = ConvertToTarget(rectangle, source);
+	const ScreenRectangle to = ConvertToTarget(rectangle, destination);
+	// Only a copy between targets of different resolutions needs to be filtered
+	const bool isScaled = source.width != destination.width || source.height != destination.height;
+	GL(glBlitNamedFramebuffer(source.framebuffer, destination.framebuffer,
+		from.x, from.y, from.x + from.width, from.y + from.height,
+		to.x, to.y, to.x + to.width, to.y + to.height,
+		GL_COLOR_BUFFER_BIT, isScaled ? GL_LINEAR : GL_NEAREST));
+}
+
+ScreenRectangle PostProcessor::ConvertToTarget(const ScreenRectangle& rectangle, const RenderTarget& target)
+{
+	const ScreenRectangle screen = ScreenRectangle::GetScreen();
+	if (target.width == screen.width && target.height == screen.height)
+	{
+		return rectangle;
+	}
+
+	const float xScale = (float)target.width / (float)screen.width;
+	const float yScale = (float)target.height / (float)screen.height;
+	const int left = (int)std::floor((float)rectangle.x * xScale);
+	const int bottom = (int)std::floor((float)rectangle.y * yScale);
+	const int right = std::min((int)std::ceil((float)(rectangle.x + rectangle.width) * xScale), target.width);
+	const int top = std::min((int)std::ceil((float)(rectangle.y + rectangle.height) * yScale), target.height);
+	return ScreenRectangle{ left, bottom, right - left, top - bottom };
+}
\ No newline at end of file
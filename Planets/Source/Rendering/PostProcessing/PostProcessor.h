@@ -1,39 +1,94 @@
 #pragma once
 #include "PostProcessingEffect.h"
+#include "RenderTargetPool.h"
 
 class PostProcessor
 {
 public:
-	// "renderingFunction" is the function for which we are going to apply 
-	// the post-processing effect to
+	// "renderingFunction" is the function for which we are going to apply
+	// the post-processing effects to
 	PostProcessor(std::function<void()> renderingFunction);
+	// Adds "effects", and sets "enabledEffects", right away. The programs of the effects then get
+	// submitted while the post processor is constructed, along with the programs of the members
+	// that are constructed next to it, before any of them is bound.
+	PostProcessor(std::function<void()> renderingFunction,
+		std::unordered_map<std::string, PostProcessingEffect> effects, const std::vector<std::string>& enabledEffects);
 	~PostProcessor();
 
-	// Renders "mRenderingFunction" with the post-processing effect: "effect"
-	void Render(const std::string& effect) const;
+	// Renders "mRenderingFunction" with the post-processing effects that were set by "SetEffects"
+	void Render() const;
 	void AddEffect(const std::string& effectName, PostProcessingEffect effect);
+	// Builds the passes that apply "effects", in order, to the rendering. Adjacent per-pixel
+	// effects get fused into a single pass, and every pass but the last stores its output in a
+	// target from the pool, which the passes whose outputs are never alive at once share.
+	// Without any effects, the rendering gets copied straight into the back buffer.
+	void SetEffects(const std::vector<std::string>& effects);
+	// Renders the scene, and every pass but the last, at "scale" times the resolution of the
+	// window, and lets the last pass upscale it. Reallocates the render targets whenever the
+	// scale changes, which is why the scale should only change in coarse steps.
+	void SetRenderScale(float scale);
 private:
-	// Initializes "mTexture" and "mDepthTexture"
+	// A full-screen draw, which runs either a single effect, or several fused per-pixel effects
+	struct Pass
+	{
+		std::string name;
+		const Program* program = nullptr;
+		std::vector<const PostProcessingEffect*> effects;
+		// The output of the previous pass, or the rendered scene for the first pass
+		RenderTarget input;
+		// The back buffer, for the last pass
+		RenderTarget output;
+	};
+
+	// Initializes "mTexture" and "mDepthTexture", at the render resolution, and attaches them to "mFramebuffer"
 	void InitializeTextures();
 	void InitializeFramebuffer();
+	void DeleteTextures();
+	// The target that the scene gets rendered into
+	RenderTarget GetSceneTarget() const;
 
 	// Subsequent rendering gets stored
 	// inside the texture
 	void StartRenderingIntoTexture() const;
 	// Rendering goes into the back buffer
 	void StopRenderingIntoTexture() const;
-	// Renders the texture with the post-processing effect: "effect"
-	void RenderTextureWithEffect(const std::string& effect) const;
+	void RenderPass(const Pass& pass) const;
+
+	// Returns the program of the fused per-pixel effects "effects", which gets linked the first time
+	const Program& GetFusedProgram(const std::vector<const PostProcessingEffect*>& effects);
+	// Returns the source of the fragment shader that calls the function of every effect
+	// in "effects", in order, with the colour that the previous function returned
+	static std::string CreateFusedFragmentSource(const std::vector<const PostProcessingEffect*>& effects);
+	// Returns whether the pass leaves every pixel outside of "bounds" unchanged
+	static bool GetBounds(const Pass& pass, ScreenRectangle& bounds);
+
+	// Copies the part of "source" that is outside of "bounds" straight into "destination"
+	void CopyOutside(const RenderTarget& source, const RenderTarget& destination, const ScreenRectangle& bounds) const;
+	// "rectangle" is in the pixels of the window, and gets scaled to the resolutions of the targets
+	void Copy(const RenderTarget& source, const RenderTarget& destination, const ScreenRectangle& rectangle) const;
+	// Converts "rectangle", from the pixels of the window, to the pixels of "target", rounding outwards
+	static ScreenRectangle ConvertToTarget(const ScreenRectangle& rectangle, const RenderTarget& target);
 private:
-	// We will apply the post-processing effect to the rendering that
+	// We will apply the post-processing effects to the rendering that
 	// happens inside "mRenderingFunction"
 	std::function<void()> mRenderingFunction = []{};
 	std::unordered_map<std::string, PostProcessingEffect> mNameToEffect;
 
+	// The effects that the passes were built from, which are needed to rebuild them
+	std::vector<std::string> mEffects;
+	std::vector<Pass> mPasses;
+	RenderTargetPool mRenderTargetPool;
+	// The programs of the fused per-pixel effects, by the names of their passes
+	std::unordered_map<std::string, Program> mFusedPrograms;
+
 	// The framebuffer enables us to render into the texture
 	GLuint mFramebuffer = 0;
 	GLuint mTexture = 0;
-	// Since we want to be able to do depth testing when we are rendering 
+	// Since we want to be able to do depth testing when we are rendering
 	// into the texture, we will need a depth texture
 	GLuint mDepthTexture = 0;
+
+	float mRenderScale = 1.0f;
+	int mRenderWidth = 0;
+	int mRenderHeight = 0;
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "RenderTargetPool.h"
+#include "../GlMacro.h"
+#include "../GlStateCache.h"
+
+RenderTargetPool::~RenderTargetPool()
+{
+	DeleteTargets();
+}
+
+RenderTarget RenderTargetPool::Acquire()
+{
+	if (mFreeTargets.empty())
+	{
+		return CreateTarget();
+	}
+
+	const RenderTarget target = mFreeTargets.back();
+	mFreeTargets.pop_back();
+	return target;
+}
+
+void RenderTargetPool::Release(const RenderTarget& target)
+{
+	// Make sure that the target belongs to the pool, and that it has not been released already
+	assert(std::any_of(mTargets.begin(), mTargets.end(),
+		[&](const RenderTarget& other) { return other.framebuffer == target.framebuffer; }));
+	assert(std::none_of(mFreeTargets.begin(), mFreeTargets.end(),
+		[&](const RenderTarget& other) { return other.framebuffer == target.framebuffer; }));
+
+	mFreeTargets.push_back(target);
+}
+
+void RenderTargetPool::SetSize(const int width, const int height)
+{
+	// Make sure that nobody uses any of the targets
+	assert(mFreeTargets.size() == mTargets.size());
+
+	DeleteTargets();
+	mTargets.clear();
+	mFreeTargets.clear();
+	mWidth = width;
+	mHeight = height;
+}
+
+RenderTarget RenderTargetPool::CreateTarget()
+{
+	// Make sure that the size has been set
+	assert(mWidth > 0 && mHeight > 0);
+
+	RenderTarget target;
+	target.width = mWidth;
+	target.height = mHeight;
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &target.texture));
+	GL(glTextureStorage2D(target.texture, 1, GL_RGBA8, mWidth, mHeight));
+	// The next pass might read the target at another resolution
+	GL(glTextureParameteri(target.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GL(glTextureParameteri(target.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GL(glTextureParameteri(target.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GL(glTextureParameteri(target.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+	// Without a depth attachment, the depth test always passes, which is what the full-screen passes want
+	GL(glCreateFramebuffers(1, &target.framebuffer));
+	GL(glNamedFramebufferTexture(target.framebuffer, GL_COLOR_ATTACHMENT0, target.texture, 0));
+	GL(glNamedFramebufferDrawBuffer(target.framebuffer, GL_COLOR_ATTACHMENT0));
+
+	mTargets.push_back(target);
+	return target;
+}
+
+void RenderTargetPool::DeleteTargets()
+{
+	// Called by the destructor, which should not throw exception, hence no GL macros
+	for (const RenderTarget& target : mTargets)
+	{
+		glDeleteFramebuffers(1, &target.framebuffer);
+		glDeleteTextures(1, &target.texture);
+		GlStateCache::ForgetFramebuffer(target.framebuffer);
+		GlStateCache::ForgetTexture(target.texture);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "GL/glew.h"
+
+// A colour texture, together with the framebuffer that renders into it
+struct RenderTarget
+{
+	GLuint framebuffer = 0;
+	GLuint texture = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Hands out the targets that post-processing passes store their output inside, until the next
+// pass has read it. A released target gets handed out again, so that passes whose outputs are
+// never needed at the same time share the same video memory.
+class RenderTargetPool
+{
+public:
+	RenderTargetPool() = default;
+	~RenderTargetPool();
+
+	// One should not be able to copy nor move a "RenderTargetPool" instance
+	RenderTargetPool(const RenderTargetPool& other) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool& other) = delete;
+
+	// Returns a target that nobody uses, which gets created if every target is in use
+	RenderTarget Acquire();
+	// Makes "target", which has to come from "Acquire", available to the next "Acquire"
+	void Release(const RenderTarget& target);
+	// Deletes every target, which all need to have been released, and makes the targets that
+	// get created from now on "width" x "height" pixels
+	void SetSize(int width, int height);
+private:
+	RenderTarget CreateTarget();
+	void DeleteTargets();
+private:
+	int mWidth = 0;
+	int mHeight = 0;
+
+	std::vector<RenderTarget> mTargets;
+	std::vector<RenderTarget> mFreeTargets;
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "ScreenRectangle.h"
+#include "../../Window/Window.h"
+
+bool ScreenRectangle::IsEmpty() const
+{
+	return width <= 0 || height <= 0;
+}
+
+ScreenRectangle ScreenRectangle::GetScreen()
+{
+	return ScreenRectangle{ 0, 0, Window::GetWidth(), Window::GetHeight() };
+}
+
+ScreenRectangle ScreenRectangle::GetUnion(const ScreenRectangle& first, const ScreenRectangle& second)
+{
+	// An empty rectangle does not contain any pixels, wherever it is
+	if (first.IsEmpty())
+	{
+		return second;
+	}
+	if (second.IsEmpty())
+	{
+		return first;
+	}
+
+	const int left = std::min(first.x, second.x);
+	const int bottom = std::min(first.y, second.y);
+	const int right = std::max(first.x + first.width, second.x + second.width);
+	const int top = std::max(first.y + first.height, second.y + second.height);
+	return ScreenRectangle{ left, bottom, right - left, top - bottom };
+}
+
+ScreenRectangle ScreenRectangle::GetSphereBounds(const Vector3& viewPosition, const float radius,
+	const Matrix4& projection, const float near)
+{
+	// Every point of the sphere needs to be in front of the near plane, for its
+	// projection to be bounded by the projections of the tangent points below
+	if (viewPosition[2] + radius > -near)
+	{
+		return GetScreen();
+	}
+
+	// The bounds, in normalized device coordinates, along the x- and y-axes
+	std::array<float, 2> minima = {};
+	std::array<float, 2> maxima = {};
+	for (size_t axis = 0; axis < 2; ++axis)
+	{
+		// Solve the problem in the plane that is spanned by the axis and the z-axis. The lines
+		// from the camera, that just touch the circle of the sphere in that plane, touch it at
+		// the tangent points, which project onto the bounds of the sphere along the axis.
+		const float a = viewPosition[axis];
+		const float z = viewPosition[2];
+		const float distance = sqrt(a * a + z * z);
+		// The cosine and the sine of the angle between the centre and the tangent points,
+		// as seen from the camera. The distance to the tangent points is "distance" * "cosine".
+		const float cosine = sqrt(distance * distance - radius * radius) / distance;
+		const float sine = radius / distance;
+
+		std::array<float, 2> bounds = {};
+		for (size_t i = 0; i < 2; ++i)
+		{
+			// Rotate the centre towards each of the tangent points
+			const float signedSine = i == 0 ? sine : -sine;
+			const float tangentA = (cosine * a - signedSine * z) * cosine;
+			const float tangentZ = (signedSine * a + cosine * z) * cosine;
+
+			// The perspective divide, by "w" = "-z"
+			bounds[i] = (projection[axis][axis] * tangentA + projection[2][axis] * tangentZ) / -tangentZ;
+		}
+		minima[axis] = std::min(bounds[0], bounds[1]);
+		maxima[axis] = std::max(bounds[0], bounds[1]);
+	}
+
+	// Convert the bounds to pixels, rounded outwards, and clamp them to the screen
+	const ScreenRectangle screen = GetScreen();
+	const auto convertToPixel = [](const float ndc, const int size, const bool roundUp)
+	{
+		const float pixel = (ndc * 0.5f + 0.5f) * (float)size;
+		return std::clamp((int)(roundUp ? ceil(pixel) : floor(pixel)), 0, size);
+	};
+	const int left = convertToPixel(minima[0], screen.width, false);
+	const int right = convertToPixel(maxima[0], screen.width, true);
+	const int bottom = convertToPixel(minima[1], screen.height, false);
+	const int top = convertToPixel(maxima[1], screen.height, true);
+
+	return ScreenRectangle{ left, bottom, right - left, top - bottom };
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include "../../Mathematics/Vector/Vector.h"
+#include "../../Mathematics/Matrix/Matrix.h"
+
+// A region of the screen, in pixels, whose origin is the lower left corner of the screen
+struct ScreenRectangle
+{
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+
+	bool IsEmpty() const;
+
+	// Returns the whole screen, at the current size of the window
+	static ScreenRectangle GetScreen();
+	// Returns the smallest rectangle that contains both "first" and "second"
+	static ScreenRectangle GetUnion(const ScreenRectangle& first, const ScreenRectangle& second);
+	// Returns the smallest rectangle that contains the sphere, once it has been projected onto
+	// the screen by "projection". "viewPosition" is the centre of the sphere in view space, in
+	// which the camera looks along the negative z-axis. If the sphere reaches the near plane,
+	// "near", the rectangle conservatively covers the whole screen.
+	static ScreenRectangle GetSphereBounds(const Vector3& viewPosition, float radius,
+		const Matrix4& projection, float near);
+};
\ No newline at end of file
@@ -2,32 +2,39 @@
 #include "../CustomException.h"
 #include <sstream>
 #include "GlMacro.h"
+#include "GlStateCache.h"
+#include "ProgramCache.h"
+#include "../Benchmark/BenchmarkMacros.h"
+#include "../Console/ErrorLog.h"
+#include "../Console/Log.h"
+#include "../Timer.h"
+
+Program::Statistics Program::msStatistics;
 
 Program::Program(const std::string& filename)
 {
 	const std::string wholeFilePath = FILE_PATH + filename + FILE_EXTENSION;
 	std::ifstream file = OpenFile(wholeFilePath);
-	std::vector<Shader> shaders = CreateShaders(file, filename);
-
-	mProgramName = GL(glCreateProgram());
-
-	for (const auto& shader : shaders)
-	{
-		GL(glAttachShader(mProgramName, shader.GetShaderName()));
-	}
-
-	GL(glLinkProgram(mProgramName));
-	int successfullyLinked = 0;
-	GL(glGetProgramiv(mProgramName, GL_LINK_STATUS, &successfullyLinked));
+	std::vector<ShaderSource> sources;
+	AddShaderSources(file, filename, sources);
+	Create(sources, filename);
+}
 
-	if (!successfullyLinked)
+Program::Program(const std::vector<std::string>& filenames, const std::vector<std::string>& additionalSources,
+	const std::string& name)
+{
+	std::vector<ShaderSource> sources;
+	for (const auto& additionalSource : additionalSources)
 	{
-		HandleLinkError(filename);
+		sources.push_back({ additionalSource, name });
 	}
-	else
+	for (const auto& filename : filenames)
 	{
-		mContainsGlProgram = true;
+		std::ifstream file = OpenFile(FILE_PATH + filename + FILE_EXTENSION);
+		AddShaderSources(file, filename, sources);
 	}
+
+	Create(sources, name);
 }
 
 Program::~Program()
@@ -36,6 +43,7 @@ Program::~Program()
 	{
 		// Destructors should not throw exception, hence no GL macro
 		glDeleteProgram(mProgramName);
+		GlStateCache::ForgetProgram(mProgramName);
 	}
 }
 
@@ -49,6 +57,10 @@ Program& Program::operator=(Program&& other) noexcept
 	assert(this != &other);
 	mProgramName = other.mProgramName;
 	mContainsGlProgram = other.mContainsGlProgram;
+	mName = std::move(other.mName);
+	mIsLinked = other.mIsLinked;
+	mPendingShaders = std::move(other.mPendingShaders);
+	mCacheEntryPath = std::move(other.mCacheEntryPath);
 
 	// Remove the resource from other
 	other.mContainsGlProgram = false;
@@ -59,7 +71,19 @@ Program& Program::operator=(Program&& other) noexcept
 void Program::Bind() const
 {
 	assert(mContainsGlProgram);
-	GL(glUseProgram(mProgramName));
+	if (!mIsLinked)
+	{
+		FinishLinking();
+	}
+	GlStateCache::Get().UseProgram(mProgramName);
+}
+
+void Program::LogStatistics()
+{
+	LOG("Programs: " << msStatistics.nLoadedPrograms << " loaded from the program cache and "
+		<< msStatistics.nCompiledPrograms << " compiled, " << msStatistics.submittingSeconds * 1000.0
+		<< " ms submitting, " << msStatistics.waitingSeconds * 1000.0 << " ms waiting for the driver and "
+		<< msStatistics.cachingSeconds * 1000.0 << " ms writing the program cache" << std::endl);
 }
 
 std::ifstream Program::OpenFile(const std::string& filePath) const
@@ -79,9 +103,10 @@ std::ifstream Program::OpenFile(const std::string& filePath) const
 	return file;
 }
 
-std::vector<Shader> Program::CreateShaders(std::ifstream& file, const std::string& filename)
+void Program::AddShaderSources(std::ifstream& file, const std::string& filename,
+	std::vector<ShaderSource>& sources) const
 {
-	std::vector<Shader> shaders;
+	const size_t nSources = sources.size();
 
 	std::string stringFile{ std::istreambuf_iterator(file), std::istreambuf_iterator<char>() };
 	const std::string startSignal = "#Shader";
@@ -93,18 +118,110 @@ std::vector<Shader> Program::CreateShaders(std::ifstream& file, const std::strin
 		beginOfShaderSource += startSignal.size();
 
 		auto endOfShaderSource = std::search(beginOfShaderSource, stringFile.end(), startSignal.begin(), startSignal.end());
-		shaders.emplace_back(std::string{ beginOfShaderSource, endOfShaderSource }, filename);
+		sources.push_back({ std::string{ beginOfShaderSource, endOfShaderSource }, filename });
 
 		// The beginning of the next shader's source is the end of this shader's source
 		beginOfShaderSource = endOfShaderSource;
 	}
 
-	if (shaders.size() == 0)
+	if (sources.size() == nSources)
 	{
 		throw CREATE_CUSTOM_EXCEPTION("\"" + filename + "\"" + " does not contain any shaders");
 	}
-	
-	return shaders;
+}
+
+void Program::Create(const std::vector<ShaderSource>& sources, const std::string& name)
+{
+	BENCHMARK;
+	Timer timer;
+	timer.Time();
+	mName = name;
+
+	if (programcache::IsSupported())
+	{
+		std::vector<std::string> sourceStrings;
+		for (const auto& source : sources)
+		{
+			sourceStrings.push_back(source.source);
+		}
+		const std::string entryPath = programcache::GetEntryPath(name, sourceStrings);
+
+		mProgramName = programcache::Load(entryPath);
+		if (mProgramName != 0)
+		{
+			mContainsGlProgram = true;
+			mIsLinked = true;
+			++msStatistics.nLoadedPrograms;
+			msStatistics.submittingSeconds += timer.Time();
+			return;
+		}
+		mCacheEntryPath = entryPath;
+	}
+
+	for (const auto& source : sources)
+	{
+		mPendingShaders.emplace_back(source.source, source.filename);
+	}
+
+	mProgramName = GL(glCreateProgram());
+	mContainsGlProgram = true;
+	for (const auto& shader : mPendingShaders)
+	{
+		GL(glAttachShader(mProgramName, shader.GetShaderName()));
+	}
+	if (!mCacheEntryPath.empty())
+	{
+		GL(glProgramParameteri(mProgramName, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	}
+
+	// Just like the compilations, the linking only gets submitted to the driver
+	GL(glLinkProgram(mProgramName));
+	++msStatistics.nCompiledPrograms;
+	msStatistics.submittingSeconds += timer.Time();
+}
+
+void Program::FinishLinking() const
+{
+	BENCHMARK;
+	Timer timer;
+	timer.Time();
+
+	// Blocks until the driver is done compiling and linking
+	int successfullyLinked = 0;
+	GL(glGetProgramiv(mProgramName, GL_LINK_STATUS, &successfullyLinked));
+	msStatistics.waitingSeconds += timer.Time();
+
+	if (!successfullyLinked)
+	{
+		// A shader that failed to compile tells more than the log of the linking
+		for (const auto& shader : mPendingShaders)
+		{
+			shader.CheckCompileStatus();
+		}
+		HandleLinkError(mName);
+	}
+	mIsLinked = true;
+
+	// The shaders get deleted once they are no longer attached
+	for (const auto& shader : mPendingShaders)
+	{
+		GL(glDetachShader(mProgramName, shader.GetShaderName()));
+	}
+	mPendingShaders.clear();
+
+	if (!mCacheEntryPath.empty())
+	{
+		try
+		{
+			programcache::WriteEntry(mCacheEntryPath, mProgramName);
+		}
+		catch (const CustomException& exception)
+		{
+			// The program works without its entry, it just gets compiled again the next time
+			ERROR_LOG(exception.what());
+		}
+		msStatistics.cachingSeconds += timer.Time();
+	}
 }
 
 void Program::HandleLinkError(const std::string& filename) const
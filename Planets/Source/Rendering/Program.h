@@ -2,10 +2,21 @@
 #include "Shader.h"
 #include <fstream>
 
+// A program is only submitted to the driver when it is created, and the first "Bind" waits for
+// the driver to finish it, which lets the driver compile the programs that are created one after
+// another in parallel. The binaries of the linked programs are kept in the program cache (see
+// "programcache"), so that the shaders only get compiled the first time that a program is created.
 class Program
 {
 public:
 	Program(const std::string& filename);
+	// Links the shaders of every file in "filenames", together with the shaders whose sources are
+	// "additionalSources", into one program. Each of those sources starts with the type of its
+	// shader, just like after "#Shader" inside a file. A stage may then consist of several shaders,
+	// e.g., one that defines a function and one that calls it. "name" tells which program an error
+	// occurred inside, and names the entry of the program in the program cache.
+	Program(const std::vector<std::string>& filenames, const std::vector<std::string>& additionalSources,
+		const std::string& name);
 	~Program();
 
 	// One should not be able to copy a "Program" instance
@@ -15,14 +26,50 @@ public:
 	Program(Program&& other) noexcept;
 	Program& operator=(Program&& other) noexcept;
 
+	// Throws, the first time, if the program failed to compile or link
 	void Bind() const;
+
+	// Logs how many programs were loaded from the program cache and how many were compiled,
+	// together with the time spent submitting them, waiting for the driver and caching them
+	static void LogStatistics();
 private:
+	struct ShaderSource
+	{
+		// Starts with the type of the shader
+		std::string source;
+		// The file that the source comes from, which is only needed for the error messages
+		std::string filename;
+	};
+
+	struct Statistics
+	{
+		int nLoadedPrograms = 0;
+		int nCompiledPrograms = 0;
+		double submittingSeconds = 0.0;
+		double waitingSeconds = 0.0;
+		double cachingSeconds = 0.0;
+	};
+
 	std::ifstream OpenFile(const std::string& filePath) const;
-	std::vector<Shader> CreateShaders(std::ifstream& file, const std::string& filename);
+	void AddShaderSources(std::ifstream& file, const std::string& filename, std::vector<ShaderSource>& sources) const;
+	// Loads the program from the program cache, or submits its shaders for compilation and linking
+	void Create(const std::vector<ShaderSource>& sources, const std::string& name);
+	// Waits for the driver to finish linking, and writes the binary of the program to the program cache
+	void FinishLinking() const;
 	void HandleLinkError(const std::string& filename) const;
 private:
 	GLint mProgramName = 0;
 	bool mContainsGlProgram = false;
+	std::string mName;
+	// Whether "FinishLinking" has run, or the program was loaded from the program cache
+	mutable bool mIsLinked = false;
+	// The shaders are kept until the linking has finished, since the errors of
+	// their compilations explain why the linking failed, if it failed
+	mutable std::vector<Shader> mPendingShaders;
+	// Where the binary of the program gets written, once it has been linked. Empty if the program
+	// was loaded from the program cache, or if the driver can not give binaries of programs.
+	std::string mCacheEntryPath;
+	static Statistics msStatistics;
 	inline static const std::string FILE_PATH = "Source/Shaders/";
 	inline static const std::string FILE_EXTENSION = ".shader";
 };
\ No newline at end of file
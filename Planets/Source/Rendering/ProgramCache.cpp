@@ -0,0 +1,211 @@
+#include "ProgramCache.h"
+#include "GlMacro.h"
+#include "../CustomException.h"
+#include "../Console/ErrorLog.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+	constexpr char MAGIC[4] = { 'P', 'B', 'I', 'N' };
+	// Needs to be incremented whenever the layout of an entry changes,
+	// in order to make every existing entry stale
+	constexpr uint32_t VERSION = 1;
+
+	struct Header
+	{
+		char magic[4] = {};
+		uint32_t version = 0;
+		GLenum binaryFormat = 0;
+		uint32_t size = 0;
+		// The FNV-1a hash of the binary, which reveals a partially written entry
+		uint32_t checksum = 0;
+	};
+
+	std::vector<GLenum> GetBinaryFormats()
+	{
+		GLint nFormats = 0;
+		GL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nFormats));
+		std::vector<GLenum> formats(nFormats);
+		if (nFormats > 0)
+		{
+			GL(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, reinterpret_cast<GLint*>(formats.data())));
+		}
+		return formats;
+	}
+
+	// The value that the FNV-1a hash starts from
+	constexpr uint32_t HASH_OFFSET_BASIS = 2166136261u;
+
+	// Hashes "data" with FNV-1a, continuing from "hash"
+	uint32_t UpdateHash(uint32_t hash, const void* const data, const size_t size)
+	{
+		const unsigned char* const bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	uint32_t UpdateHash(const uint32_t hash, const std::string& string)
+	{
+		// The size is part of the hash, so that moving characters between two strings changes the hash
+		const uint64_t size = string.size();
+		return UpdateHash(UpdateHash(hash, &size, sizeof(size)), string.data(), string.size());
+	}
+
+	std::string GetDriverString(const GLenum name)
+	{
+		const GLubyte* const string = GL(glGetString(name));
+		return string ? reinterpret_cast<const char*>(string) : "";
+	}
+}
+
+bool programcache::IsSupported()
+{
+	// Only depends on the driver, which does not change while running
+	static const bool isSupported = !GetBinaryFormats().empty();
+	return isSupported;
+}
+
+std::string programcache::GetEntryPath(const std::string& name, const std::vector<std::string>& sources)
+{
+	// Everything that affects the binary is part of the hash
+	uint32_t hash = UpdateHash(HASH_OFFSET_BASIS, &VERSION, sizeof(VERSION));
+	for (const GLenum driverString : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		hash = UpdateHash(hash, GetDriverString(driverString));
+	}
+	for (const std::string& source : sources)
+	{
+		hash = UpdateHash(hash, source);
+	}
+
+	std::stringstream entryName;
+	entryName << name << "_" << std::hex << std::setw(8) << std::setfill('0') << hash << FILE_EXTENSION;
+
+	return DIRECTORY + entryName.str();
+}
+
+GLuint programcache::Load(const std::string& entryPath)
+{
+	std::ifstream file(entryPath, std::ios::binary);
+	if (!file)
+	{
+		return 0;
+	}
+
+	Header header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	// The header is checked before the binary gets allocated, since
+	// a broken entry could claim a size of up to 4 GiB otherwise
+	const std::streampos binaryBegin = file.tellg();
+	file.seekg(0, std::ios::end);
+	const std::streamoff remainingSize = file ? file.tellg() - binaryBegin : 0;
+	file.seekg(binaryBegin);
+	const bool hasValidHeader = file && std::equal(std::begin(MAGIC), std::end(MAGIC), header.magic)
+		&& header.version == VERSION && remainingSize == (std::streamoff)header.size;
+	if (!hasValidHeader)
+	{
+		ERROR_LOG("The program cache entry " + entryPath + " is broken, and gets rebuilt");
+		return 0;
+	}
+
+	std::vector<char> binary(header.size);
+	file.read(binary.data(), binary.size());
+
+	const std::vector<GLenum> formats = GetBinaryFormats();
+	const bool isValid = file
+		&& UpdateHash(HASH_OFFSET_BASIS, binary.data(), binary.size()) == header.checksum
+		// The driver would fail the call, instead of the link, with a format that it does not know
+		&& std::find(formats.begin(), formats.end(), header.binaryFormat) != formats.end();
+	if (!isValid)
+	{
+		ERROR_LOG("The program cache entry " + entryPath + " is broken, and gets rebuilt");
+		return 0;
+	}
+
+	const GLuint program = GL(glCreateProgram());
+	GL(glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size()));
+
+	// The driver is allowed to reject any binary, e.g., after it has been updated
+	// without changing its version string, which is not an error
+	GLint successfullyLinked = 0;
+	GL(glGetProgramiv(program, GL_LINK_STATUS, &successfullyLinked));
+	if (!successfullyLinked)
+	{
+		GL(glDeleteProgram(program));
+		return 0;
+	}
+
+	return program;
+}
+
+void programcache::WriteEntry(const std::string& entryPath, const GLuint program)
+{
+	GLint size = 0;
+	GL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size));
+	if (size <= 0)
+	{
+		return;
+	}
+
+	Header header;
+	std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+	header.version = VERSION;
+	header.size = (uint32_t)size;
+
+	std::vector<char> binary(size);
+	GL(glGetProgramBinary(program, size, NULL, &header.binaryFormat, binary.data()));
+	header.checksum = UpdateHash(HASH_OFFSET_BASIS, binary.data(), binary.size());
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(DIRECTORY, errorCode);
+	if (errorCode)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to create the program cache directory " + DIRECTORY + ": "
+			+ errorCode.message());
+	}
+
+	// The entry is written under a temporary name first, so that a partially
+	// written entry never shows up under the name of a valid entry
+	const std::string temporaryPath = entryPath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), binary.size());
+		if (!file)
+		{
+			throw CREATE_CUSTOM_EXCEPTION("Failed to write " + temporaryPath);
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, entryPath, errorCode);
+	if (errorCode)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to move " + temporaryPath + " to " + entryPath + ": "
+			+ errorCode.message());
+	}
+
+	// Remove the entries of older versions of the program. They are named after the
+	// program, followed by an underscore, 8 hexadecimal digits and the file extension.
+	const std::filesystem::path entry(entryPath);
+	const std::string prefix = entry.stem().string().substr(0, entry.stem().string().size() - 8);
+	for (const auto& directoryEntry : std::filesystem::directory_iterator(DIRECTORY, errorCode))
+	{
+		const std::string fileName = directoryEntry.path().filename().string();
+		const bool isEntryOfProgram = fileName.size() == entry.filename().string().size()
+			&& fileName.starts_with(prefix) && directoryEntry.path().extension() == FILE_EXTENSION;
+
+		if (isEntryOfProgram && fileName != entry.filename().string())
+		{
+			std::filesystem::remove(directoryEntry.path(), errorCode);
+		}
+	}
+}
\ No newline at end of file
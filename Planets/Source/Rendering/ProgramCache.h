@@ -0,0 +1,28 @@
+#pragma once
+#include "GL/glew.h"
+#include <string>
+#include <vector>
+
+// Keeps the binaries of the linked programs, so that the shaders only need to be compiled the first
+// time that a program is created. An entry is named after the program and the hash of the sources of
+// its shaders, together with the vendor, renderer and version strings of the driver, since a binary
+// only works with the driver that made it. Updating the driver, or changing a shader, therefore makes
+// the entry stale.
+namespace programcache
+{
+	const inline std::string DIRECTORY = "Source/ProgramCache/";
+	const inline std::string FILE_EXTENSION = ".programbinary";
+
+	// Returns whether the driver is able to give, and take, binaries of programs
+	bool IsSupported();
+
+	// Returns the path of the entry of the program "name", whose shaders are made from "sources"
+	std::string GetEntryPath(const std::string& name, const std::vector<std::string>& sources);
+
+	// Creates a linked program from the entry at "entryPath". Returns 0 if there is no such entry, or if
+	// the driver rejects its binary, in which case the program needs to be compiled from its sources.
+	GLuint Load(const std::string& entryPath);
+	// Writes the binary of the linked program "program" to "entryPath". The program should have
+	// been linked with "GL_PROGRAM_BINARY_RETRIEVABLE_HINT". The stale entries of the program are removed.
+	void WriteEntry(const std::string& entryPath, GLuint program);
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "RenderQueue.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "StreamBuffer.h"
+#include "../Benchmark/BenchmarkMacros.h"
+#include <functional>
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	assert(packet.program != nullptr);
+	mPackets.push_back(packet);
+}
+
+void RenderQueue::Flush()
+{
+	BENCHMARK;
+
+	if (mPackets.empty())
+	{
+		return;
+	}
+
+	// Sorting by the addresses makes the order of the programs and texture sets arbitrary,
+	// but the draws that share them end up next to each other, which is all that matters.
+	// Unlike "<", "std::less" gives a total order of pointers that point to unrelated objects.
+	std::sort(mPackets.begin(), mPackets.end(),
+		[](const DrawPacket& a, const DrawPacket& b)
+		{
+			if (a.program != b.program)
+			{
+				return std::less<const Program*>()(a.program, b.program);
+			}
+			if (a.textureSet != b.textureSet)
+			{
+				return std::less<const TextureSet*>()(a.textureSet, b.textureSet);
+			}
+			return a.vertexArray < b.vertexArray;
+		});
+
+	const GLintptr commandsOffset = UploadBuffers();
+
+	GlStateCache& stateCache = GlStateCache::Get();
+	// The state cache skips the binds that would not change anything, but the
+	// texture set is still tracked, to skip going through all its bindings
+	const TextureSet* boundTextureSet = nullptr;
+	for (size_t first = 0; first < mPackets.size();)
+	{
+		const DrawPacket& packet = mPackets[first];
+
+		// Find the end of the run of packets that can be submitted together
+		size_t end = first + 1;
+		while (end < mPackets.size() && mPackets[end].program == packet.program
+			&& mPackets[end].textureSet == packet.textureSet && mPackets[end].vertexArray == packet.vertexArray)
+		{
+			++end;
+		}
+
+		packet.program->Bind();
+
+		if (packet.textureSet != nullptr && packet.textureSet != boundTextureSet)
+		{
+			for (const TextureSet::Binding& binding : packet.textureSet->bindings)
+			{
+				stateCache.BindTextureUnit(binding.unit, binding.texture);
+			}
+			boundTextureSet = packet.textureSet;
+		}
+
+		stateCache.BindVertexArray(packet.vertexArray);
+
+		// The uniform is part of the program's state, so it is set for every run
+		GL(glUniform1i(FIRST_DRAW_LOCATION, (GLint)first));
+		GL(glMultiDrawArraysIndirect(GL_TRIANGLES,
+			(const void*)(commandsOffset + first * sizeof(DrawArraysIndirectCommand)), GLsizei(end - first), 0));
+
+		first = end;
+	}
+
+	mPackets.clear();
+}
+
+GLintptr RenderQueue::UploadBuffers()
+{
+	StreamBuffer& streamBuffer = StreamBuffer::Get();
+
+	// The commands and the draw data are written straight into the stream buffer,
+	// which is only read by the GPU after it has finished the earlier frames
+	const StreamBuffer::Allocation commands =
+		streamBuffer.Allocate(mPackets.size() * sizeof(DrawArraysIndirectCommand), alignof(DrawArraysIndirectCommand));
+	const StreamBuffer::Allocation drawData = streamBuffer.Allocate(mPackets.size() * sizeof(DrawData),
+		std::max(alignof(DrawData), streamBuffer.GetShaderStorageBufferAlignment()));
+
+	DrawArraysIndirectCommand* const mappedCommands = static_cast<DrawArraysIndirectCommand*>(commands.data);
+	DrawData* const mappedDrawData = static_cast<DrawData*>(drawData.data);
+	for (size_t i = 0; i < mPackets.size(); ++i)
+	{
+		mappedCommands[i] = DrawArraysIndirectCommand{ (GLuint)mPackets[i].count, 1, (GLuint)mPackets[i].first, 0 };
+		mappedDrawData[i] = mPackets[i].drawData;
+	}
+
+	GlStateCache& stateCache = GlStateCache::Get();
+	stateCache.BindBuffer(GL_DRAW_INDIRECT_BUFFER, streamBuffer.GetBuffer());
+	stateCache.BindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, streamBuffer.GetBuffer(), drawData.offset,
+		(GLsizeiptr)(mPackets.size() * sizeof(DrawData)));
+
+	return commands.offset;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include "Program.h"
+#include "../Mathematics/Vector/TightlyPacked/TightlyPackedVector3.h"
+
+// The data of a draw that its vertex shader fetches from the draw data buffer. Laid out
+// according to the std430 storage layout, in which the struct is aligned like a "vec3".
+struct alignas(4 * 4) DrawData
+{
+	// The transform of the draw, from model space to world space
+	TightlyPackedVector3 position;
+	float scale = 1.0f;
+	// The layer of the draw's textures, inside the texture arrays that it samples from
+	int textureLayer = 0;
+};
+static_assert(sizeof(DrawData) == 4 * 4 * 2);
+
+// Textures that get bound together, before the draws that use them
+struct TextureSet
+{
+	struct Binding
+	{
+		GLuint unit = 0;
+		GLuint texture = 0;
+	};
+	std::vector<Binding> bindings;
+};
+
+struct DrawPacket
+{
+	const Program* program = nullptr;
+	// The packets are compared by the address of their texture sets, hence the texture
+	// sets need to outlive the flush. Null when the draw has no textures of its own.
+	const TextureSet* textureSet = nullptr;
+	// The draws that share a vertex array object can be submitted together
+	GLuint vertexArray = 0;
+	GLint first = 0;
+	GLsizei count = 0;
+	DrawData drawData;
+};
+
+// Collects the draws of a frame and submits them sorted by program, and then by texture set.
+// Every run of draws that share their program, texture set and vertex array object is submitted
+// with a single "glMultiDrawArraysIndirect", whose commands are read from a buffer on the GPU.
+// The vertex shaders find their draw data at the index "firstDraw" + "gl_DrawIDARB", where
+// "firstDraw" is the uniform at the location "FIRST_DRAW_LOCATION", inside the shader storage
+// buffer that is bound to "DRAW_DATA_BINDING". The amount of OpenGL calls therefore only grows
+// with the number of different programs and texture sets, instead of with the number of draws.
+// Should only be used by the thread that owns the OpenGL context.
+class RenderQueue
+{
+public:
+	void Submit(const DrawPacket& packet);
+
+	// Draws the submitted packets and empties the queue. The programs read the constants
+	// that they share from the frame constants, so nothing gets set between the programs.
+	void Flush();
+
+	static constexpr GLuint DRAW_DATA_BINDING = 2;
+	static constexpr GLint FIRST_DRAW_LOCATION = 3;
+private:
+	// The layout of the commands that "glMultiDrawArraysIndirect" reads
+	struct DrawArraysIndirectCommand
+	{
+		GLuint count = 0;
+		GLuint instanceCount = 0;
+		GLuint first = 0;
+		GLuint baseInstance = 0;
+	};
+
+	// Streams the commands and the draw data of the sorted packets to the GPU, and binds
+	// them. Returns the offset of the commands inside the draw indirect buffer.
+	GLintptr UploadBuffers();
+private:
+	std::vector<DrawPacket> mPackets;
+};
@@ -0,0 +1,24 @@
+#include "Sampler.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+
+Sampler::Sampler(const SamplerParameters& parameters)
+{
+	GL(glCreateSamplers(1, &mSampler));
+
+	GL(glSamplerParameterfv(mSampler, GL_TEXTURE_BORDER_COLOR, parameters.borderColour.data()));
+	GL(glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_S, parameters.wrapS));
+	GL(glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_T, parameters.wrapT));
+}
+
+Sampler::~Sampler()
+{
+	// Destructors should not throw exception, hence no GL macro
+	glDeleteSamplers(1, &mSampler);
+	GlStateCache::ForgetSampler(mSampler);
+}
+
+void Sampler::Bind(const GLuint unit) const
+{
+	GlStateCache::Get().BindSampler(unit, mSampler);
+}
\ No newline at end of file
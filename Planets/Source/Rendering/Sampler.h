@@ -0,0 +1,30 @@
+#pragma once
+#include "GL/glew.h"
+#include <array>
+
+// The state of a sampler object. Two samplers with equal parameters sample the
+// same way, which is what the "AssetCache" uses to share them.
+struct SamplerParameters
+{
+	GLint wrapS = GL_REPEAT;
+	GLint wrapT = GL_REPEAT;
+	// Only used by the wrap mode "GL_CLAMP_TO_BORDER"
+	std::array<float, 4> borderColour = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	auto operator<=>(const SamplerParameters& other) const = default;
+};
+
+class Sampler
+{
+public:
+	Sampler(const SamplerParameters& parameters);
+	~Sampler();
+
+	// One should not be able to copy a "Sampler" instance
+	Sampler(const Sampler& other) = delete;
+	Sampler& operator=(const Sampler& other) = delete;
+
+	void Bind(GLuint unit) const;
+private:
+	GLuint mSampler = 0;
+};
\ No newline at end of file
@@ -3,25 +3,16 @@
 #include "GlMacro.h"
 
 Shader::Shader(std::string shaderSource, const std::string& filename)
+	:
+	mFilename(filename)
 {
-	std::string typeAsString;
-	mShaderName = GL(glCreateShader(GetType(shaderSource, typeAsString)));
-	const char* const cString = shaderSource.c_str();
+	mShaderName = GL(glCreateShader(GetType(shaderSource, mTypeAsString)));
+	mContainsGlShader = true;
+	mSource = std::move(shaderSource);
+	const char* const cString = mSource.c_str();
 
 	GL(glShaderSource(mShaderName, 1, &cString, NULL));
 	GL(glCompileShader(mShaderName));
-	
-	int successfullyCompiled = 0;
-	GL(glGetShaderiv(mShaderName, GL_COMPILE_STATUS, &successfullyCompiled));
-
-	if (!successfullyCompiled)
-	{
-		HandleCompileError(shaderSource, typeAsString, filename);
-	}
-	else
-	{
-		mContainsGlShader = true;
-	}
 }
 
 Shader::~Shader()
@@ -44,6 +35,9 @@ Shader& Shader::operator=(Shader&& other) noexcept
 
 	mShaderName = other.mShaderName;
 	mContainsGlShader = other.mContainsGlShader;
+	mSource = std::move(other.mSource);
+	mTypeAsString = std::move(other.mTypeAsString);
+	mFilename = std::move(other.mFilename);
 
 	// Remove the resource from other
 	other.mContainsGlShader = false;
@@ -56,7 +50,19 @@ GLuint Shader::GetShaderName() const
 	return mShaderName;
 }
 
-void Shader::HandleCompileError(std::string shaderSource, const std::string& shaderType, const std::string& filename) const
+void Shader::CheckCompileStatus() const
+{
+	// Blocks until the driver is done compiling the shader
+	int successfullyCompiled = 0;
+	GL(glGetShaderiv(mShaderName, GL_COMPILE_STATUS, &successfullyCompiled));
+
+	if (!successfullyCompiled)
+	{
+		HandleCompileError();
+	}
+}
+
+void Shader::HandleCompileError() const
 {
 	// "logLength" counts the null termination character
 	int logLength = 0;
@@ -67,10 +73,11 @@ void Shader::HandleCompileError(std::string shaderSource, const std::string& sha
 	log.resize(logLength - 1);
 	GL(glGetShaderInfoLog(mShaderName, logLength, NULL, log.data()));
 
-	GL(glDeleteShader(mShaderName));
+	// The shader itself gets deleted by the destructor
+	std::string shaderSource = mSource;
 	AddLineNumbersToString(shaderSource);
-	throw CREATE_CUSTOM_EXCEPTION("Failed to compile " + shaderType + 
-		" shader in " + "\"" + filename + "\"" + "\n" + log + shaderSource);
+	throw CREATE_CUSTOM_EXCEPTION("Failed to compile " + mTypeAsString + 
+		" shader in " + "\"" + mFilename + "\"" + "\n" + log + shaderSource);
 }
 
 void Shader::AddLineNumbersToString(std::string& string) const
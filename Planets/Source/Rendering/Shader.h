@@ -5,7 +5,9 @@ class Shader
 {
 public:
 	// We only need the file path in order to be able to notify the user
-	// of which file the potential error occurred inside
+	// of which file the potential error occurred inside. The shader only gets
+	// submitted for compilation, which lets the driver compile several shaders
+	// in parallel, until "CheckCompileStatus" waits for it.
 	Shader(std::string shaderSource, const std::string& filename);
 	~Shader();
 
@@ -17,13 +19,19 @@ public:
 	Shader& operator=(Shader&& other) noexcept;
 
 	GLuint GetShaderName() const;
+	// Waits for the compilation to finish, and throws if it failed
+	void CheckCompileStatus() const;
 private:
-	void HandleCompileError(std::string shaderSource, const std::string& shaderType, const std::string& filePath) const;
+	void HandleCompileError() const;
 	void AddLineNumbersToString(std::string& string) const;
 	GLenum GetType(std::string& shaderSource, std::string& typeAsString) const;
 private:
 	GLuint mShaderName = 0;
 	bool mContainsGlShader = false;
+	// Kept for the error message, in case the compilation fails
+	std::string mSource;
+	std::string mTypeAsString;
+	std::string mFilename;
 
 	inline static const std::unordered_map<std::string, GLenum> msStringToType =
 	{
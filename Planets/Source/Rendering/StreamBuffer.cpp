@@ -0,0 +1,124 @@
+#include "StreamBuffer.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "../Benchmark/BenchmarkMacros.h"
+
+StreamBuffer::StreamBuffer()
+{
+	// There should only be one instance of this class
+	assert(!msStreamBuffer);
+	msStreamBuffer = this;
+
+	// The buffer is coherent, so what the CPU writes becomes
+	// visible to the GPU without any explicit flushing
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	GL(glCreateBuffers(1, &mBuffer));
+	GL(glNamedBufferStorage(mBuffer, REGION_SIZE * N_REGIONS, nullptr, flags));
+	mMemory = (unsigned char*)GL(glMapNamedBufferRange(mBuffer, 0, REGION_SIZE * N_REGIONS, flags));
+
+	if (!mMemory)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to map the stream buffer");
+	}
+
+	GL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &mUniformBufferAlignment));
+	GL(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &mShaderStorageBufferAlignment));
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	// Destructors should not throw exception, hence no GL macros
+	for (const GLsync fence : mFences)
+	{
+		glDeleteSync(fence);
+	}
+	glUnmapNamedBuffer(mBuffer);
+	glDeleteBuffers(1, &mBuffer);
+	GlStateCache::ForgetBuffer(mBuffer);
+
+	msStreamBuffer = nullptr;
+}
+
+StreamBuffer& StreamBuffer::Get()
+{
+	assert(msStreamBuffer);
+	return *msStreamBuffer;
+}
+
+StreamBuffer::Allocation StreamBuffer::Allocate(const size_t size, const size_t alignment)
+{
+	assert(size <= REGION_SIZE);
+	assert(alignment > 0);
+
+	// The regions start at multiples of "REGION_SIZE", which are aligned
+	// to every alignment that OpenGL asks for
+	size_t offset = (mHead + alignment - 1) / alignment * alignment;
+	if (offset + size > REGION_SIZE)
+	{
+		MoveToNextRegion();
+		offset = 0;
+	}
+	mHead = offset + size;
+
+	const size_t bufferOffset = mRegion * REGION_SIZE + offset;
+	return Allocation{ (GLintptr)bufferOffset, mMemory + bufferOffset };
+}
+
+void StreamBuffer::CopyToBuffer(const GLuint destination, const GLintptr destinationOffset,
+	const void* const data, const size_t size)
+{
+	const unsigned char* source = static_cast<const unsigned char*>(data);
+	for (size_t copied = 0; copied < size;)
+	{
+		// Fill up what is left of the current region, rather than moving on to the next one
+		const size_t freeSize = REGION_SIZE - mHead;
+		const size_t pieceSize = std::min(size - copied, freeSize > 0 ? freeSize : REGION_SIZE);
+
+		const Allocation allocation = Allocate(pieceSize, 1);
+		std::copy_n(source + copied, pieceSize, static_cast<unsigned char*>(allocation.data));
+		GL(glCopyNamedBufferSubData(mBuffer, destination, allocation.offset,
+			destinationOffset + (GLintptr)copied, (GLsizeiptr)pieceSize));
+
+		copied += pieceSize;
+	}
+}
+
+void StreamBuffer::EndFrame()
+{
+	MoveToNextRegion();
+}
+
+GLuint StreamBuffer::GetBuffer() const
+{
+	return mBuffer;
+}
+
+size_t StreamBuffer::GetUniformBufferAlignment() const
+{
+	return (size_t)mUniformBufferAlignment;
+}
+
+size_t StreamBuffer::GetShaderStorageBufferAlignment() const
+{
+	return (size_t)mShaderStorageBufferAlignment;
+}
+
+void StreamBuffer::MoveToNextRegion()
+{
+	// The GPU is done with the region, once it has passed the fence
+	const GLsync fence = GL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	mFences[mRegion] = fence;
+
+	mRegion = (mRegion + 1) % N_REGIONS;
+	mHead = 0;
+
+	if (mFences[mRegion])
+	{
+		// Normally the fence was passed long ago, in which case this does not wait at all
+		NAMED_BENCHMARK("Wait for stream buffer region");
+		GL(glClientWaitSync(mFences[mRegion], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+		GL(glDeleteSync(mFences[mRegion]));
+		mFences[mRegion] = nullptr;
+	}
+}
\ No newline at end of file
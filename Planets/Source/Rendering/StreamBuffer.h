@@ -0,0 +1,74 @@
+#pragma once
+#include "GL/glew.h"
+#include <array>
+
+// Singleton. A buffer that stays persistently mapped, through which the data that changes
+// from frame to frame is streamed to the GPU, without any reallocations or implicit
+// synchronizations by the driver. The buffer is split into regions of "REGION_SIZE" bytes,
+// of which every frame writes to its own. The region gets guarded by a fence once the frame
+// is done with it, and is only written to again once the GPU has passed the fence, which
+// normally is a couple of frames later. Should only be used by the thread that owns the
+// OpenGL context.
+class StreamBuffer
+{
+public:
+	// A part of the buffer, which stays untouched until the GPU has finished
+	// the commands that were issued during the current frame
+	struct Allocation
+	{
+		// The offset of the allocation inside the buffer
+		GLintptr offset = 0;
+		// The memory of the allocation, which the CPU writes to
+		void* data = nullptr;
+	};
+
+	// Needs to be constructed after the OpenGL context has been created
+	StreamBuffer();
+	~StreamBuffer();
+
+	// One should not be able to copy nor move a "StreamBuffer" instance
+	StreamBuffer(const StreamBuffer& other) = delete;
+	StreamBuffer& operator=(const StreamBuffer& other) = delete;
+
+	static StreamBuffer& Get();
+
+	// Returns "size" bytes, whose offset is a multiple of "alignment". The allocation
+	// can not be larger than a region. If the current region is full, the allocation
+	// is taken from the next region, which might have to wait for the GPU.
+	Allocation Allocate(size_t size, size_t alignment);
+	// Copies "data" into "destination", at "destinationOffset", through the stream buffer.
+	// The copy happens on the GPU, in the order of the commands, so it never waits for
+	// the GPU to finish with "destination". Data that is larger than a region is copied
+	// piece by piece, which has to wait for the GPU once it has gone through all the regions.
+	void CopyToBuffer(GLuint destination, GLintptr destinationOffset, const void* data, size_t size);
+
+	// Guards the region of the current frame with a fence, and moves on to the next region.
+	// Needs to be called once per frame, after all the commands of the frame have been issued.
+	void EndFrame();
+
+	GLuint GetBuffer() const;
+	// The alignments that the offsets of uniform buffer and shader storage buffer bindings need
+	size_t GetUniformBufferAlignment() const;
+	size_t GetShaderStorageBufferAlignment() const;
+
+	static constexpr size_t REGION_SIZE = 4 * 1024 * 1024;
+private:
+	// Fences the current region, and waits for the GPU to finish with the next region
+	void MoveToNextRegion();
+private:
+	GLuint mBuffer = 0;
+	unsigned char* mMemory = nullptr;
+
+	// Three regions lets the CPU be two frames ahead of the GPU before it has to wait
+	static constexpr size_t N_REGIONS = 3;
+	// The fences of the regions that the GPU might still be reading from
+	std::array<GLsync, N_REGIONS> mFences = {};
+	size_t mRegion = 0;
+	// The offset of the free memory, inside the current region
+	size_t mHead = 0;
+
+	GLint mUniformBufferAlignment = 0;
+	GLint mShaderStorageBufferAlignment = 0;
+
+	static inline StreamBuffer* msStreamBuffer = nullptr;
+};
\ No newline at end of file
@@ -1,32 +1,9 @@
 #include "Texture.h"
-#include "PngLoader.h"
-#include "GlMacro.h"
 
-Texture::Texture(const std::string& filename)
+Texture::Texture(const std::string& filename, const TextureKind kind)
+	:
+	mHandle(TextureLoader::Get().Load(FILE_PATH + filename + FILE_EXTENSION, kind, N_MIPMAP_LEVELS))
 {
-	std::vector<unsigned char> buffer;
-	lodepng::load_file(buffer, FILE_PATH + filename + FILE_EXTENSION);
-
-	std::vector<unsigned char> image;
-	unsigned int width;
-	unsigned int height;
-	lodepng::decode(image, width, height, buffer);
-
-	// OpenGL begins to read the image in the lower left corner.
-	// The first pixel from the image loaded is stored in the upper left corner.
-	// We therefore need to invert the loaded image along the y-axis.
-	RevertImage(image, width, height);
-
-	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mTextureName));
-	GL(glTextureStorage2D(mTextureName, N_MIPMAP_LEVELS, GL_RGBA8, width, height));
-	GL(glTextureSubImage2D(mTextureName, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &image.front()));
-	GL(glGenerateTextureMipmap(mTextureName));
-}
-
-Texture::~Texture()
-{
-	// Destructors should not throw exception, hence no GL macro
-	glDeleteTextures(1, &mTextureName);
 }
 
 Texture::Texture(Texture&& other) noexcept
@@ -37,44 +14,24 @@ Texture::Texture(Texture&& other) noexcept
 Texture& Texture::operator=(Texture&& other) noexcept
 {
 	assert(this != &other);
-	mTextureName = other.mTextureName;
-	mContainsGlTexture = other.mContainsGlTexture;
 
 	// Remove the resource from other
-	other.mContainsGlTexture = false;
+	mHandle = std::move(other.mHandle);
 
 	return *this;
 }
 
-void Texture::Bind(GLuint unit) const
+bool Texture::IsReady() const
 {
-	GL(glBindTextureUnit(unit, mTextureName));
+	return mHandle->IsReady();
 }
 
-void Texture::RevertImage(std::vector<unsigned char>& image, const int width, const int height) const
+size_t Texture::GetResidentBytes() const
 {
-	std::vector<unsigned char> reversedImage = image;
-
-	// The width of the texture in bytes. Each pixel has a width of 4 bytes, 
-	// hence we multiply the width, in pixels, by 4.
-	const int byteWidth = width * 4;
-
-	// Divide the image into a vector of rows
-	std::vector<const unsigned char*> rows;
-	rows.resize(height);
-	std::generate(rows.begin(), rows.end(),
-		[i = 0, &image, byteWidth]() mutable
-	{
-		return &image.front() + (i++) * byteWidth;
-	});
-
-	// Loop through the rows in reversed order
-	std::for_each(rows.rbegin(), rows.rend(),
-		[i = 0, &reversedImage, byteWidth](const unsigned char* row) mutable
-	{
-		// Copy each row back into the image, inverting the image along the y-axis
-		std::copy_n(row, byteWidth, reversedImage.begin() + (i++) * byteWidth);
-	});
-
-	image = reversedImage;
+	return mHandle->GetResidentBytes();
 }
+
+void Texture::Bind(GLuint unit) const
+{
+	mHandle->Bind(unit);
+}
\ No newline at end of file
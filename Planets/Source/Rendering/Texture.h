@@ -1,11 +1,14 @@
 #pragma once
 #include "GL/glew.h"
+#include "TextureLoader.h"
 
 class Texture
 {
 public:
-	Texture(const std::string& filename);
-	~Texture();
+	// The image is loaded asynchronously by the "TextureLoader". Until it has been
+	// uploaded, binding the texture binds a 1x1 placeholder texture instead. The kind
+	// decides which block compressed format the texture gets stored in.
+	Texture(const std::string& filename, TextureKind kind = TextureKind::Colour);
 
 	// One should not be able to copy a "Texture" instance
 	Texture(const Texture& other) = delete;
@@ -14,13 +17,17 @@ public:
 	Texture(Texture&& other) noexcept;
 	Texture& operator=(Texture&& other) noexcept;
 
+	// Returns true once the image has been uploaded
+	bool IsReady() const;
+
+	// Returns the video memory that the texture uses, which is 0 until it has been uploaded
+	size_t GetResidentBytes() const;
+
 	void Bind(GLuint location) const;
 private:
-	void RevertImage(std::vector<unsigned char>& image, int width, int height) const;
-private:
-	GLuint mTextureName;
-	bool mContainsGlTexture = false;
-	inline static const GLsizei N_MIPMAP_LEVELS = 4;
+	// Owns the OpenGL texture, and is shared with the "TextureLoader" while loading
+	std::shared_ptr<const TextureHandle> mHandle;
+	inline static const GLsizei N_MIPMAP_LEVELS = mipchain::FULL_CHAIN;
 	inline static const std::string FILE_PATH = "Source/Textures/";
 	inline static const std::string FILE_EXTENSION = ".png";
 };
\ No newline at end of file
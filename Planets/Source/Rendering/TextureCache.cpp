@@ -0,0 +1,152 @@
+#include "TextureCache.h"
+#include "BlockCompression.h"
+#include "MipChain.h"
+#include "../CustomException.h"
+#include "../Console/ErrorLog.h"
+#include "../Console/Log.h"
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+std::string texturecache::GetEntryPath(const std::string& filePath, const std::vector<unsigned char>& png,
+	const TextureKind kind, const int nMipLevels)
+{
+	return GetEntryPath(filePath, png.data(), png.size(), kind, nMipLevels);
+}
+
+std::string texturecache::GetEntryPath(const std::string& filePath, const void* const content, const size_t size,
+	const TextureKind kind, const int nMipLevels)
+{
+	// Everything that affects the content of the entry is part of the hash
+	uint32_t hash = texturecontainer::UpdateChecksum(texturecontainer::CHECKSUM_OFFSET_BASIS, content, size);
+	const uint32_t settings[] = { ENCODER_VERSION, (uint32_t)kind, (uint32_t)nMipLevels };
+	hash = texturecontainer::UpdateChecksum(hash, settings, sizeof(settings));
+
+	std::stringstream entryName;
+	entryName << std::filesystem::path(filePath).stem().string() << "_"
+		<< std::hex << std::setw(8) << std::setfill('0') << hash << texturecontainer::FILE_EXTENSION;
+
+	return DIRECTORY + entryName.str();
+}
+
+void texturecache::WriteEntry(const std::string& entryPath, const unsigned char* const pixels, const int width,
+	const int height, const TextureKind kind, const int nMipLevels)
+{
+	const TextureFormat format = kind == TextureKind::NormalMap ? TextureFormat::Bc5
+		: blockcompression::IsOpaque(pixels, width, height) ? TextureFormat::Bc1 : TextureFormat::Bc3;
+
+	const std::vector<mipchain::MipLevel> mipChain = mipchain::BuildRgba8(pixels, width, height, kind, nMipLevels);
+
+	std::vector<mipchain::MipLevel> compressedMipChain;
+	compressedMipChain.reserve(mipChain.size());
+	for (const mipchain::MipLevel& mipLevel : mipChain)
+	{
+		compressedMipChain.push_back(mipchain::MipLevel{
+			blockcompression::Compress(format, mipLevel.pixels.data(), mipLevel.width, mipLevel.height),
+			mipLevel.width, mipLevel.height });
+	}
+
+	WriteEntry(entryPath, format, compressedMipChain);
+}
+
+void texturecache::WriteEntry(const std::string& entryPath, const TextureFormat format,
+	const std::vector<mipchain::MipLevel>& mipChain)
+{
+	std::error_code errorCode;
+	std::filesystem::create_directories(DIRECTORY, errorCode);
+	if (errorCode)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to create the texture cache directory " + DIRECTORY + ": "
+			+ errorCode.message());
+	}
+
+	// The entry is written under a temporary name first, so that a partially
+	// written entry never shows up under the name of a valid entry
+	const std::string temporaryPath = entryPath + ".tmp";
+	{
+		TextureContainerWriter writer(temporaryPath, format, mipChain.front().width, mipChain.front().height,
+			(int)mipChain.size());
+
+		for (const mipchain::MipLevel& mipLevel : mipChain)
+		{
+			writer.Write(mipLevel.pixels.data(), mipLevel.pixels.size());
+		}
+
+		writer.Finish();
+	}
+
+	std::filesystem::rename(temporaryPath, entryPath, errorCode);
+	if (errorCode)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to move " + temporaryPath + " to " + entryPath + ": "
+			+ errorCode.message());
+	}
+
+	// Remove the entries of older versions of the texture. They are named after the
+	// texture, followed by an underscore, 8 hexadecimal digits and the file extension.
+	const std::filesystem::path entry(entryPath);
+	const std::string prefix = entry.stem().string().substr(0, entry.stem().string().size() - 8);
+	for (const auto& directoryEntry : std::filesystem::directory_iterator(DIRECTORY, errorCode))
+	{
+		const std::string fileName = directoryEntry.path().filename().string();
+		const bool isEntryOfTexture = fileName.size() == entry.filename().string().size()
+			&& fileName.starts_with(prefix) && directoryEntry.path().extension() == texturecontainer::FILE_EXTENSION;
+
+		if (isEntryOfTexture && fileName != entry.filename().string())
+		{
+			std::filesystem::remove(directoryEntry.path(), errorCode);
+		}
+	}
+}
+
+std::unique_ptr<MappedTextureContainer> texturecache::LoadWithMipChain(const std::string& filePath,
+	ThreadPool* const threadPool)
+{
+	auto container = std::make_unique<MappedTextureContainer>(filePath);
+	if (container->GetMipLevelCount() > 1)
+	{
+		return container;
+	}
+
+	const TextureFormat format = container->GetFormat();
+	if (textureformat::IsCompressed(format))
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not build the mip chain of the compressed texture container " + filePath);
+	}
+
+	const std::string entryPath = GetEntryPath(filePath, container->GetMipLevelData(0), container->GetMipLevelSize(0),
+		TextureKind::Colour, mipchain::FULL_CHAIN);
+	if (std::filesystem::exists(entryPath))
+	{
+		try
+		{
+			return std::make_unique<MappedTextureContainer>(entryPath);
+		}
+		catch (const CustomException& exception)
+		{
+			// The broken entry gets replaced below
+			ERROR_LOG(exception.what());
+		}
+	}
+
+	try
+	{
+		LOG("Building the mip chain of " << filePath << " into the texture cache" << std::endl);
+
+		const std::vector<mipchain::MipLevel> mipChain = format == TextureFormat::Rgba8
+			? mipchain::BuildRgba8(static_cast<const unsigned char*>(container->GetMipLevelData(0)),
+				container->GetWidth(), container->GetHeight(), TextureKind::Colour, mipchain::FULL_CHAIN,
+				MipFilter::Kaiser, threadPool)
+			: mipchain::BuildR32f(static_cast<const float*>(container->GetMipLevelData(0)),
+				container->GetWidth(), container->GetHeight(), mipchain::FULL_CHAIN, MipFilter::Kaiser, threadPool);
+		WriteEntry(entryPath, format, mipChain);
+
+		return std::make_unique<MappedTextureContainer>(entryPath);
+	}
+	catch (const CustomException& exception)
+	{
+		// The texture still works without its mip chain, only with more aliasing
+		ERROR_LOG(exception.what());
+		return container;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include "TextureContainer.h"
+#include "../Threading/ThreadPool.h"
+#include <vector>
+
+// What a texture is used for, which decides the format that it gets compressed into
+enum class TextureKind
+{
+	// Compressed into Bc1, or into Bc3 if any pixel is not fully opaque
+	Colour,
+	// Compressed into Bc5, which only keeps the x and y components of the normals
+	NormalMap
+};
+
+namespace mipchain
+{
+	struct MipLevel;
+}
+
+// Keeps block compressed mip chains of the PNG textures, and uncompressed mip chains of the
+// generated textures, as texture containers, so that the mip chains only need to be built
+// the first time that the textures are loaded. An entry is named after the texture and
+// the hash of its source file, which makes an entry stale as soon as the file changes.
+namespace texturecache
+{
+	const inline std::string DIRECTORY = "Source/TextureCache/";
+
+	// Needs to be incremented whenever the output of the encoder changes,
+	// in order to make every existing entry stale
+	constexpr uint32_t ENCODER_VERSION = 2;
+
+	// Returns the path of the entry of the PNG file "filePath", whose content is "png"
+	std::string GetEntryPath(const std::string& filePath, const std::vector<unsigned char>& png,
+		TextureKind kind, int nMipLevels);
+	// Returns the path of the entry of the file "filePath", whose content is the "size" bytes at "content"
+	std::string GetEntryPath(const std::string& filePath, const void* content, size_t size,
+		TextureKind kind, int nMipLevels);
+
+	// Builds a mip chain of "nMipLevels" levels (see "mipchain::GetMipLevelCount") from the 8-bit RGBA image,
+	// compresses it and writes it to "entryPath". The stale entries of the same texture are removed.
+	void WriteEntry(const std::string& entryPath, const unsigned char* pixels, int width, int height,
+		TextureKind kind, int nMipLevels);
+	// Writes a mip chain, whose payloads already are in the format "format", as it is
+	void WriteEntry(const std::string& entryPath, TextureFormat format, const std::vector<mipchain::MipLevel>& mipChain);
+
+	// Maps the uncompressed texture container "filePath", or, if it only has a single mip level, the
+	// entry that holds its full mip chain. The entry gets built, with the rows of every mip level
+	// filtered on "threadPool", if the cache does not have it yet. Falls back to the container itself,
+	// if the entry can not be written.
+	std::unique_ptr<MappedTextureContainer> LoadWithMipChain(const std::string& filePath, ThreadPool* threadPool);
+}
\ No newline at end of file
@@ -0,0 +1,466 @@
+#include "TextureContainer.h"
+#include "GlMacro.h"
+#include "../CustomException.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+size_t textureformat::GetImageSize(const TextureFormat format, const int width, const int height)
+{
+	switch (format)
+	{
+	case TextureFormat::Rgba8:
+		return (size_t)width * height * 4;
+	case TextureFormat::R32f:
+		return (size_t)width * height * sizeof(float);
+	case TextureFormat::Bc1:
+		// 8 bytes per block of 4x4 pixels. The blocks along the right and
+		// bottom edges cover the remaining pixels, if any.
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+	case TextureFormat::Bc3:
+	case TextureFormat::Bc5:
+		// 16 bytes per block of 4x4 pixels
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+	default:
+		throw CREATE_CUSTOM_EXCEPTION("Unknown texture format: " + std::to_string((uint32_t)format));
+	}
+}
+
+bool textureformat::IsCompressed(const TextureFormat format)
+{
+	return format == TextureFormat::Bc1 || format == TextureFormat::Bc3 || format == TextureFormat::Bc5;
+}
+
+GLenum textureformat::GetGlInternalFormat(const TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::Rgba8:
+		return GL_RGBA8;
+	case TextureFormat::R32f:
+		return GL_R32F;
+	case TextureFormat::Bc1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case TextureFormat::Bc3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TextureFormat::Bc5:
+		return GL_COMPRESSED_RG_RGTC2;
+	default:
+		throw CREATE_CUSTOM_EXCEPTION("Unknown texture format: " + std::to_string((uint32_t)format));
+	}
+}
+
+GLenum textureformat::GetGlFormat(const TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::Rgba8:
+		return GL_RGBA;
+	case TextureFormat::R32f:
+		return GL_RED;
+	default:
+		throw CREATE_CUSTOM_EXCEPTION("Unknown texture format: " + std::to_string((uint32_t)format));
+	}
+}
+
+GLenum textureformat::GetGlType(const TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::Rgba8:
+		return GL_UNSIGNED_BYTE;
+	case TextureFormat::R32f:
+		return GL_FLOAT;
+	default:
+		throw CREATE_CUSTOM_EXCEPTION("Unknown texture format: " + std::to_string((uint32_t)format));
+	}
+}
+
+uint32_t texturecontainer::UpdateChecksum(uint32_t hash, const void* const data, const size_t size)
+{
+	const unsigned char* const bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// vvv TextureContainerWriter vvv
+
+TextureContainerWriter::TextureContainerWriter(const std::string& filePath, const TextureFormat format,
+	const int width, const int height, const int nMipLevels)
+	:
+	mFilePath(filePath)
+{
+	if (width < 1 || height < 1 || nMipLevels < 1 || nMipLevels > texturecontainer::MAX_MIP_LEVEL_COUNT)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Can not create a texture container with the size " + std::to_string(width)
+			+ "x" + std::to_string(height) + " and " + std::to_string(nMipLevels) + " mip level(s): " + filePath);
+	}
+
+	std::copy(std::begin(texturecontainer::MAGIC), std::end(texturecontainer::MAGIC), mHeader.magic);
+	mHeader.version = texturecontainer::VERSION;
+	mHeader.format = format;
+	mHeader.width = (uint32_t)width;
+	mHeader.height = (uint32_t)height;
+	mHeader.nMipLevels = (uint32_t)nMipLevels;
+
+	// The payloads are stored after the header, in order, each one starting at a page boundary
+	uint64_t offset = texturecontainer::PAYLOAD_ALIGNMENT;
+	for (int i = 0; i < nMipLevels; ++i)
+	{
+		texturecontainer::MipLevel& mipLevel = mHeader.mipLevels[i];
+		mipLevel.width = std::max(1u, mHeader.width >> i);
+		mipLevel.height = std::max(1u, mHeader.height >> i);
+		mipLevel.offset = offset;
+		mipLevel.size = textureformat::GetImageSize(format, (int)mipLevel.width, (int)mipLevel.height);
+
+		// Round up to the next page boundary
+		offset += (mipLevel.size + texturecontainer::PAYLOAD_ALIGNMENT - 1)
+			/ texturecontainer::PAYLOAD_ALIGNMENT * texturecontainer::PAYLOAD_ALIGNMENT;
+	}
+
+	mFile.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+	try
+	{
+		// We want to discard the old content, hence "std::ios_base::trunc"
+		mFile.open(filePath, std::ios_base::binary | std::ios_base::trunc);
+
+		// The checksum is not known yet. The header gets written again by "Finish".
+		WriteHeader();
+		PadToCurrentMipLevel();
+	}
+	catch (std::ios_base::failure)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to open or write to file: " + filePath);
+	}
+}
+
+void TextureContainerWriter::Write(const void* const data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	try
+	{
+		while (size > 0)
+		{
+			if (mCurrentMipLevel >= (int)mHeader.nMipLevels)
+			{
+				throw CREATE_CUSTOM_EXCEPTION("Tried to write more than the size of all the mip levels to: " + mFilePath);
+			}
+
+			// Only write what fits inside the current mip level
+			const texturecontainer::MipLevel& mipLevel = mHeader.mipLevels[mCurrentMipLevel];
+			const size_t pieceSize = (size_t)std::min((uint64_t)size, mipLevel.size - mWrittenSize);
+
+			mFile.write(reinterpret_cast<const char*>(bytes), pieceSize);
+			mChecksum = texturecontainer::UpdateChecksum(mChecksum, bytes, pieceSize);
+
+			bytes += pieceSize;
+			size -= pieceSize;
+			mWrittenSize += pieceSize;
+
+			if (mWrittenSize == mipLevel.size)
+			{
+				// Continue with the next mip level
+				++mCurrentMipLevel;
+				mWrittenSize = 0;
+				PadToCurrentMipLevel();
+			}
+		}
+	}
+	catch (std::ios_base::failure)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to write to file: " + mFilePath);
+	}
+}
+
+void TextureContainerWriter::Finish()
+{
+	if (mCurrentMipLevel != (int)mHeader.nMipLevels)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Not all the mip levels have been written to: " + mFilePath);
+	}
+
+	try
+	{
+		// Patch the header with the checksum of the whole payload
+		mHeader.checksum = mChecksum;
+		mFile.seekp(0);
+		WriteHeader();
+		mFile.close();
+	}
+	catch (std::ios_base::failure)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to write to file: " + mFilePath);
+	}
+}
+
+void TextureContainerWriter::WriteHeader()
+{
+	mFile.write(reinterpret_cast<const char*>(&mHeader), sizeof(mHeader));
+}
+
+void TextureContainerWriter::PadToCurrentMipLevel()
+{
+	// After the last mip level, there is nothing left to pad
+	if (mCurrentMipLevel >= (int)mHeader.nMipLevels)
+	{
+		return;
+	}
+
+	const uint64_t position = (uint64_t)mFile.tellp();
+	const uint64_t offset = mHeader.mipLevels[mCurrentMipLevel].offset;
+	assert(position <= offset);
+
+	const std::vector<char> zeros((size_t)(offset - position), 0);
+	mFile.write(zeros.data(), zeros.size());
+}
+
+// ^^^ TextureContainerWriter ^^^
+
+// vvv MappedTextureContainer vvv
+
+MappedTextureContainer::MappedTextureContainer(const std::string& filePath)
+	:
+	mFilePath(filePath)
+{
+	Map();
+
+	try
+	{
+		Validate();
+	}
+	catch (...)
+	{
+		// The destructor does not run when the constructor throws
+		Unmap();
+		throw;
+	}
+}
+
+MappedTextureContainer::~MappedTextureContainer()
+{
+	Unmap();
+}
+
+TextureFormat MappedTextureContainer::GetFormat() const
+{
+	return GetHeader().format;
+}
+
+int MappedTextureContainer::GetMipLevelCount() const
+{
+	return (int)GetHeader().nMipLevels;
+}
+
+int MappedTextureContainer::GetWidth(const int mipLevel) const
+{
+	assert(mipLevel >= 0 && mipLevel < GetMipLevelCount());
+	return (int)GetHeader().mipLevels[mipLevel].width;
+}
+
+int MappedTextureContainer::GetHeight(const int mipLevel) const
+{
+	assert(mipLevel >= 0 && mipLevel < GetMipLevelCount());
+	return (int)GetHeader().mipLevels[mipLevel].height;
+}
+
+const void* MappedTextureContainer::GetMipLevelData(const int mipLevel) const
+{
+	assert(mipLevel >= 0 && mipLevel < GetMipLevelCount());
+	return mData + GetHeader().mipLevels[mipLevel].offset;
+}
+
+size_t MappedTextureContainer::GetMipLevelSize(const int mipLevel) const
+{
+	assert(mipLevel >= 0 && mipLevel < GetMipLevelCount());
+	return (size_t)GetHeader().mipLevels[mipLevel].size;
+}
+
+GLuint MappedTextureContainer::CreateGlTexture() const
+{
+	const TextureFormat format = GetFormat();
+
+	GLuint texture = 0;
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &texture));
+	GL(glTextureStorage2D(texture, GetMipLevelCount(), textureformat::GetGlInternalFormat(format),
+		GetWidth(), GetHeight()));
+
+	for (int i = 0; i < GetMipLevelCount(); ++i)
+	{
+		// The pixels are read straight from the mapped file
+		if (textureformat::IsCompressed(format))
+		{
+			GL(glCompressedTextureSubImage2D(texture, i, 0, 0, GetWidth(i), GetHeight(i),
+				textureformat::GetGlInternalFormat(format), (GLsizei)GetMipLevelSize(i), GetMipLevelData(i)));
+		}
+		else
+		{
+			GL(glTextureSubImage2D(texture, i, 0, 0, GetWidth(i), GetHeight(i), textureformat::GetGlFormat(format),
+				textureformat::GetGlType(format), GetMipLevelData(i)));
+		}
+	}
+
+	return texture;
+}
+
+void MappedTextureContainer::Map()
+{
+#ifdef _WIN32
+	const HANDLE file = CreateFileA(mFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to open file: " + mFilePath);
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		throw CREATE_CUSTOM_EXCEPTION("Failed to get the size of, or empty file: " + mFilePath);
+	}
+	mSize = (size_t)fileSize.QuadPart;
+
+	const HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping)
+	{
+		mData = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+
+	// The view keeps the file mapped, even after the handles have been closed
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	const int file = open(mFilePath.c_str(), O_RDONLY);
+	if (file == -1)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to open file: " + mFilePath);
+	}
+
+	struct stat fileStatus = {};
+	if (fstat(file, &fileStatus) == -1 || fileStatus.st_size == 0)
+	{
+		close(file);
+		throw CREATE_CUSTOM_EXCEPTION("Failed to get the size of, or empty file: " + mFilePath);
+	}
+	mSize = (size_t)fileStatus.st_size;
+
+	void* const data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+	if (data != MAP_FAILED)
+	{
+		mData = static_cast<const unsigned char*>(data);
+	}
+
+	// The mapping stays valid, even after the file has been closed
+	close(file);
+#endif
+
+	if (!mData)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to map file: " + mFilePath);
+	}
+}
+
+void MappedTextureContainer::Unmap()
+{
+	if (!mData)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(mData);
+#else
+	munmap(const_cast<unsigned char*>(mData), mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
+
+void MappedTextureContainer::Validate() const
+{
+	if (mSize < texturecontainer::PAYLOAD_ALIGNMENT)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("The file is too small to be a texture container: " + mFilePath);
+	}
+
+	const texturecontainer::Header& header = GetHeader();
+	if (!std::equal(std::begin(texturecontainer::MAGIC), std::end(texturecontainer::MAGIC), header.magic))
+	{
+		throw CREATE_CUSTOM_EXCEPTION("The file is not a texture container: " + mFilePath);
+	}
+	if (header.version != texturecontainer::VERSION)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("The texture container has version " + std::to_string(header.version)
+			+ ", expected version " + std::to_string(texturecontainer::VERSION) + ": " + mFilePath);
+	}
+	if (header.width == 0 || header.height == 0)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("The texture container has no pixels: " + mFilePath);
+	}
+	if (header.nMipLevels < 1 || header.nMipLevels > (uint32_t)texturecontainer::MAX_MIP_LEVEL_COUNT)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("The texture container has an invalid amount of mip levels: " + mFilePath);
+	}
+
+	// Also throws if the format is unknown
+	textureformat::GetImageSize(header.format, 1, 1);
+
+	for (uint32_t i = 0; i < header.nMipLevels; ++i)
+	{
+		const texturecontainer::MipLevel& mipLevel = header.mipLevels[i];
+		const bool hasValidSize = mipLevel.width == std::max(1u, header.width >> i)
+			&& mipLevel.height == std::max(1u, header.height >> i)
+			&& mipLevel.size == textureformat::GetImageSize(header.format, (int)mipLevel.width, (int)mipLevel.height);
+		const bool isInsideFile = mipLevel.offset % texturecontainer::PAYLOAD_ALIGNMENT == 0
+			&& mipLevel.offset >= texturecontainer::PAYLOAD_ALIGNMENT
+			&& mipLevel.offset <= mSize && mipLevel.size <= mSize - mipLevel.offset;
+
+		if (!hasValidSize || !isInsideFile)
+		{
+			throw CREATE_CUSTOM_EXCEPTION("Mip level " + std::to_string(i) + " of the texture container is invalid: "
+				+ mFilePath);
+		}
+	}
+
+	// Verifying the checksum means reading the whole payload, which
+	// defeats the purpose of mapping the file. We therefore only do
+	// it for debug builds.
+	#ifdef DEBUG
+		uint32_t checksum = texturecontainer::CHECKSUM_OFFSET_BASIS;
+		for (uint32_t i = 0; i < header.nMipLevels; ++i)
+		{
+			checksum = texturecontainer::UpdateChecksum(checksum, mData + header.mipLevels[i].offset,
+				(size_t)header.mipLevels[i].size);
+		}
+		if (checksum != header.checksum)
+		{
+			throw CREATE_CUSTOM_EXCEPTION("The checksum of the texture container does not match its content: "
+				+ mFilePath);
+		}
+	#endif
+}
+
+const texturecontainer::Header& MappedTextureContainer::GetHeader() const
+{
+	assert(mData);
+	return *reinterpret_cast<const texturecontainer::Header*>(mData);
+}
+
+// ^^^ MappedTextureContainer ^^^
\ No newline at end of file
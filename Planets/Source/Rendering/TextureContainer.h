@@ -0,0 +1,146 @@
+#pragma once
+#include "GL/glew.h"
+#include <cstdint>
+#include <fstream>
+
+// The pixel formats that a texture container is able to store
+enum class TextureFormat : uint32_t
+{
+	Rgba8 = 0,
+	R32f = 1,
+	// The block compressed formats, which store 4x4 pixels per block. Bc1 stores opaque
+	// colours, Bc3 colours with alpha and Bc5 the two channels of a normal map.
+	Bc1 = 2,
+	Bc3 = 3,
+	Bc5 = 4
+};
+
+namespace textureformat
+{
+	// The size, in bytes, of an image with the format "format"
+	size_t GetImageSize(TextureFormat format, int width, int height);
+
+	bool IsCompressed(TextureFormat format);
+
+	// The arguments that OpenGL needs, in order to allocate and upload a texture of the format.
+	// The compressed formats only need the internal format.
+	GLenum GetGlInternalFormat(TextureFormat format);
+	GLenum GetGlFormat(TextureFormat format);
+	GLenum GetGlType(TextureFormat format);
+}
+
+namespace texturecontainer
+{
+	const inline std::string FILE_EXTENSION = ".texture";
+
+	// The first four bytes of every texture container
+	constexpr char MAGIC[4] = { 'P', 'T', 'E', 'X' };
+
+	// Needs to be incremented whenever the layout of the file changes
+	constexpr uint32_t VERSION = 1;
+
+	// The header occupies the first page of the file and the payload of every mip
+	// level starts at a page boundary, which lets the memory mapped payload get passed
+	// straight to OpenGL
+	constexpr uint64_t PAYLOAD_ALIGNMENT = 4096;
+
+	constexpr int MAX_MIP_LEVEL_COUNT = 16;
+
+	struct MipLevel
+	{
+		// The location, in bytes, of the payload, measured from the start of the file
+		uint64_t offset = 0;
+		// The size, in bytes, of the payload
+		uint64_t size = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	// The header is stored as is, at the start of the file
+	struct Header
+	{
+		char magic[4] = {};
+		uint32_t version = 0;
+		TextureFormat format = TextureFormat::Rgba8;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t nMipLevels = 0;
+		// The FNV-1a hash of the payloads of all the mip levels (excluding the padding)
+		uint32_t checksum = 0;
+		uint32_t reserved = 0;
+		MipLevel mipLevels[MAX_MIP_LEVEL_COUNT] = {};
+	};
+	static_assert(sizeof(Header) <= PAYLOAD_ALIGNMENT, "The header needs to fit inside the first page");
+
+	// Returns the FNV-1a hash of "data", continuing from "hash"
+	uint32_t UpdateChecksum(uint32_t hash, const void* data, size_t size);
+
+	// The value that the FNV-1a hash starts from
+	constexpr uint32_t CHECKSUM_OFFSET_BASIS = 2166136261u;
+}
+
+// Writes a texture container, without having to hold the whole image in memory. The
+// payload is passed in pieces to "Write" and the checksum gets patched into the header
+// by "Finish", once the whole payload has been written.
+class TextureContainerWriter
+{
+public:
+	// Writes the header of a texture container with "nMipLevels" mip levels. The payloads
+	// of the mip levels, starting with the largest one, should then get passed to "Write".
+	TextureContainerWriter(const std::string& filePath, TextureFormat format,
+		int width, int height, int nMipLevels = 1);
+
+	// Writes the next "size" bytes of the payload. A piece is allowed to span multiple mip levels.
+	void Write(const void* data, size_t size);
+
+	// Has to be called after the whole payload has been written
+	void Finish();
+private:
+	void WriteHeader();
+	// Writes zeros up until the offset of the current mip level
+	void PadToCurrentMipLevel();
+private:
+	std::ofstream mFile;
+	std::string mFilePath;
+	texturecontainer::Header mHeader;
+
+	int mCurrentMipLevel = 0;
+	// The amount of bytes that have been written to the current mip level
+	uint64_t mWrittenSize = 0;
+	uint32_t mChecksum = texturecontainer::CHECKSUM_OFFSET_BASIS;
+};
+
+// Maps a texture container into memory. The header is validated when the container
+// is opened, but no payload is copied, so opening a container is close to free.
+class MappedTextureContainer
+{
+public:
+	MappedTextureContainer(const std::string& filePath);
+	~MappedTextureContainer();
+
+	// One should not be able to copy a "MappedTextureContainer" instance
+	MappedTextureContainer(const MappedTextureContainer& other) = delete;
+	MappedTextureContainer& operator=(const MappedTextureContainer& other) = delete;
+
+	TextureFormat GetFormat() const;
+	int GetMipLevelCount() const;
+	int GetWidth(int mipLevel = 0) const;
+	int GetHeight(int mipLevel = 0) const;
+
+	// Returns a pointer to the payload of the mip level, which points straight into the mapped file
+	const void* GetMipLevelData(int mipLevel) const;
+	size_t GetMipLevelSize(int mipLevel) const;
+
+	// Creates an OpenGL texture, with immutable storage, and uploads all the mip levels to it
+	GLuint CreateGlTexture() const;
+private:
+	void Map();
+	void Unmap();
+	// Throws if the header does not describe a valid texture container that fits inside the file
+	void Validate() const;
+	const texturecontainer::Header& GetHeader() const;
+private:
+	std::string mFilePath;
+	const unsigned char* mData = nullptr;
+	size_t mSize = 0;
+};
\ No newline at end of file
@@ -0,0 +1,355 @@
+#include "TextureLoader.h"
+#include "PngLoader.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "../Benchmark/BenchmarkMacros.h"
+#include "../Console/ErrorLog.h"
+#include "../Console/Log.h"
+#include <filesystem>
+
+// vvv TextureHandle vvv
+
+TextureHandle::TextureHandle(const GLuint placeholderTextureName)
+	:
+	mPlaceholderTextureName(placeholderTextureName)
+{
+}
+
+TextureHandle::~TextureHandle()
+{
+	// Destructors should not throw exception, hence no GL macro
+	glDeleteTextures(1, &mTextureName);
+	GlStateCache::ForgetTexture(mTextureName);
+}
+
+bool TextureHandle::IsReady() const
+{
+	return mTextureName != 0;
+}
+
+void TextureHandle::Bind(const GLuint unit) const
+{
+	GlStateCache::Get().BindTextureUnit(unit, IsReady() ? mTextureName : mPlaceholderTextureName);
+}
+
+size_t TextureHandle::GetResidentBytes() const
+{
+	return mResidentBytes;
+}
+
+// ^^^ TextureHandle ^^^
+
+// vvv TextureLoader vvv
+
+TextureLoader::TextureLoader()
+{
+	// There should only be one instance of this class
+	assert(!msTextureLoader);
+	msTextureLoader = this;
+
+	InitializePlaceholderTexture();
+	InitializeStagingBuffer();
+}
+
+TextureLoader::~TextureLoader()
+{
+	// Destructors should not throw exception, hence no GL macros
+	for (const StagingRegion& region : mStagingRegionsInUse)
+	{
+		glDeleteSync(region.fence);
+	}
+	glUnmapNamedBuffer(mStagingBuffer);
+	glDeleteBuffers(1, &mStagingBuffer);
+	glDeleteTextures(1, &mPlaceholderTexture);
+	GlStateCache::ForgetBuffer(mStagingBuffer);
+	GlStateCache::ForgetTexture(mPlaceholderTexture);
+
+	msTextureLoader = nullptr;
+}
+
+TextureLoader& TextureLoader::Get()
+{
+	assert(msTextureLoader);
+	return *msTextureLoader;
+}
+
+std::shared_ptr<const TextureHandle> TextureLoader::Load(const std::string& filePath, const TextureKind kind,
+	const GLsizei nMipmapLevels)
+{
+	auto handle = std::make_shared<TextureHandle>(mPlaceholderTexture);
+
+	mPendingUploads.push_back(PendingUpload{ handle,
+		mThreadPool.Submit([filePath, kind, nMipmapLevels]() { return LoadImage(filePath, kind, nMipmapLevels); }) });
+
+	return handle;
+}
+
+void TextureLoader::Update()
+{
+	BENCHMARK;
+
+	for (auto it = mPendingUploads.begin(); it != mPendingUploads.end(); )
+	{
+		if (it->loadedImage.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		try
+		{
+			// Rethrows any exception that was thrown while loading
+			const LoadedImage image = it->loadedImage.get();
+
+			// There is no need to upload the image, if the owner
+			// has already destroyed the texture
+			if (it->handle.use_count() > 1)
+			{
+				Upload(*it->handle, image);
+			}
+		}
+		catch (const CustomException& exception)
+		{
+			// A missing or broken texture should not stop the program
+			// from running, so the placeholder texture is kept instead
+			ERROR_LOG(exception.what());
+		}
+
+		it = mPendingUploads.erase(it);
+	}
+}
+
+void TextureLoader::Finish()
+{
+	for (PendingUpload& pendingUpload : mPendingUploads)
+	{
+		pendingUpload.loadedImage.wait();
+	}
+	Update();
+}
+
+TextureLoader::LoadedImage TextureLoader::LoadImage(const std::string& filePath, const TextureKind kind,
+	const GLsizei nMipmapLevels)
+{
+	std::vector<unsigned char> png;
+	if (const unsigned int error = lodepng::load_file(png, filePath))
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to read the file " + filePath + ": " + lodepng_error_text(error));
+	}
+
+	LoadedImage image;
+
+	#if COMPRESS_TEXTURES
+		const std::string entryPath = texturecache::GetEntryPath(filePath, png, kind, nMipmapLevels);
+		if (std::filesystem::exists(entryPath))
+		{
+			try
+			{
+				image.container = std::make_unique<MappedTextureContainer>(entryPath);
+				return image;
+			}
+			catch (const CustomException& exception)
+			{
+				// The broken entry gets replaced below
+				ERROR_LOG(exception.what());
+			}
+		}
+	#endif
+
+	const DecodedImage decodedImage = Decode(filePath, png);
+
+	#if COMPRESS_TEXTURES
+		try
+		{
+			LOG("Compressing " << filePath << " into the texture cache" << std::endl);
+			texturecache::WriteEntry(entryPath, decodedImage.pixels.data(), (int)decodedImage.width,
+				(int)decodedImage.height, kind, (int)nMipmapLevels);
+
+			image.container = std::make_unique<MappedTextureContainer>(entryPath);
+			return image;
+		}
+		catch (const CustomException& exception)
+		{
+			// The uncompressed image gets uploaded instead, e.g.,
+			// when the texture cache directory is not writable
+			ERROR_LOG(exception.what());
+		}
+	#endif
+
+	// The mip chain is built here, on the worker thread, so that
+	// the main thread only has to upload it
+	image.mipChain = mipchain::BuildRgba8(decodedImage.pixels.data(), (int)decodedImage.width,
+		(int)decodedImage.height, kind, (int)nMipmapLevels);
+
+	return image;
+}
+
+TextureLoader::DecodedImage TextureLoader::Decode(const std::string& filePath, const std::vector<unsigned char>& png)
+{
+	// OpenGL begins to read the image in the lower left corner.
+	// The first pixel of a PNG image is stored in the upper left corner.
+	// We therefore let the decoder invert the image along the y-axis,
+	// which it does while unfiltering, without an extra copy of the image.
+	lodepng::State state;
+	state.decoder.flip_vertically = 1;
+
+	DecodedImage image;
+	if (const unsigned int error = lodepng_inspect(&image.width, &image.height, &state, png.data(), png.size()))
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to decode the file " + filePath + ": " + lodepng_error_text(error));
+	}
+
+	// The rows are decoded straight into the pixels, so the
+	// decoder never allocates a second copy of the image
+	image.pixels.resize((size_t)image.width * image.height * 4);
+	if (const unsigned int error = lodepng::decode(image.pixels.data(), image.pixels.size(), image.width,
+		image.height, state, png))
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to decode the file " + filePath + ": " + lodepng_error_text(error));
+	}
+
+	return image;
+}
+
+void TextureLoader::Upload(TextureHandle& handle, const LoadedImage& image)
+{
+	GLuint textureName = 0;
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &textureName));
+
+	size_t residentBytes = 0;
+	if (image.container)
+	{
+		// The whole mip chain is stored in the texture cache, already compressed
+		const MappedTextureContainer& container = *image.container;
+		GL(glTextureStorage2D(textureName, container.GetMipLevelCount(),
+			textureformat::GetGlInternalFormat(container.GetFormat()), container.GetWidth(), container.GetHeight()));
+
+		for (int i = 0; i < container.GetMipLevelCount(); ++i)
+		{
+			UploadMipLevel(textureName, i, container.GetFormat(), container.GetWidth(i), container.GetHeight(i),
+				container.GetMipLevelData(i), container.GetMipLevelSize(i));
+			residentBytes += container.GetMipLevelSize(i);
+		}
+	}
+	else
+	{
+		const std::vector<mipchain::MipLevel>& mipChain = image.mipChain;
+		GL(glTextureStorage2D(textureName, (GLsizei)mipChain.size(), GL_RGBA8,
+			mipChain.front().width, mipChain.front().height));
+
+		for (int i = 0; i < (int)mipChain.size(); ++i)
+		{
+			UploadMipLevel(textureName, i, TextureFormat::Rgba8, mipChain[i].width, mipChain[i].height,
+				mipChain[i].pixels.data(), mipChain[i].pixels.size());
+			residentBytes += mipChain[i].pixels.size();
+		}
+	}
+
+	handle.mTextureName = textureName;
+	handle.mResidentBytes = residentBytes;
+}
+
+void TextureLoader::UploadMipLevel(const GLuint textureName, const int mipLevel, const TextureFormat format,
+	const int width, const int height, const void* const data, const size_t size)
+{
+	// Larger images are uploaded straight from client memory
+	const bool useStagingBuffer = size <= STAGING_BUFFER_SIZE;
+
+	const void* source = data;
+	size_t offset = 0;
+	if (useStagingBuffer)
+	{
+		offset = AllocateStagingMemory(size);
+		std::copy_n(static_cast<const unsigned char*>(data), size, mStagingMemory + offset);
+
+		// While a pixel unpack buffer is bound, the last argument is
+		// an offset into the buffer rather than a pointer
+		source = reinterpret_cast<const void*>(offset);
+		GlStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, mStagingBuffer);
+	}
+
+	if (textureformat::IsCompressed(format))
+	{
+		GL(glCompressedTextureSubImage2D(textureName, mipLevel, 0, 0, width, height,
+			textureformat::GetGlInternalFormat(format), (GLsizei)size, source));
+	}
+	else
+	{
+		GL(glTextureSubImage2D(textureName, mipLevel, 0, 0, width, height, textureformat::GetGlFormat(format),
+			textureformat::GetGlType(format), source));
+	}
+
+	if (useStagingBuffer)
+	{
+		GlStateCache::Get().BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		// The region can not be reused until the GPU has finished reading from it
+		const GLsync fence = GL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		mStagingRegionsInUse.push_back(StagingRegion{ offset, size, fence });
+	}
+}
+
+size_t TextureLoader::AllocateStagingMemory(const size_t size)
+{
+	assert(size <= STAGING_BUFFER_SIZE);
+
+	// Start over from the beginning, if the region does not fit before the end of the buffer
+	if (mStagingHead + size > STAGING_BUFFER_SIZE)
+	{
+		mStagingHead = 0;
+	}
+	const size_t offset = mStagingHead;
+
+	// The regions are ordered from the oldest to the newest upload. Waiting for the newest
+	// region that overlaps the wanted one, means that all the older regions are free as well.
+	auto lastOverlappingRegion = mStagingRegionsInUse.end();
+	for (auto it = mStagingRegionsInUse.begin(); it != mStagingRegionsInUse.end(); ++it)
+	{
+		if (it->offset < offset + size && offset < it->offset + it->size)
+		{
+			lastOverlappingRegion = it;
+		}
+	}
+
+	if (lastOverlappingRegion != mStagingRegionsInUse.end())
+	{
+		GL(glClientWaitSync(lastOverlappingRegion->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+
+		const auto endOfFreeRegions = std::next(lastOverlappingRegion);
+		for (auto it = mStagingRegionsInUse.begin(); it != endOfFreeRegions; ++it)
+		{
+			GL(glDeleteSync(it->fence));
+		}
+		mStagingRegionsInUse.erase(mStagingRegionsInUse.begin(), endOfFreeRegions);
+	}
+
+	// Keep the next region aligned
+	mStagingHead = (offset + size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+
+	return offset;
+}
+
+void TextureLoader::InitializePlaceholderTexture()
+{
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mPlaceholderTexture));
+	GL(glTextureStorage2D(mPlaceholderTexture, 1, GL_RGBA8, 1, 1));
+	GL(glTextureSubImage2D(mPlaceholderTexture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL));
+}
+
+void TextureLoader::InitializeStagingBuffer()
+{
+	// The buffer is coherent, so what the CPU writes becomes
+	// visible to the GPU without any explicit flushing
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	GL(glCreateBuffers(1, &mStagingBuffer));
+	GL(glNamedBufferStorage(mStagingBuffer, STAGING_BUFFER_SIZE, nullptr, flags));
+	mStagingMemory = (unsigned char*)GL(glMapNamedBufferRange(mStagingBuffer, 0, STAGING_BUFFER_SIZE, flags));
+
+	if (!mStagingMemory)
+	{
+		throw CREATE_CUSTOM_EXCEPTION("Failed to map the texture staging buffer");
+	}
+}
+
+// ^^^ TextureLoader ^^^
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+#include "GL/glew.h"
+#include "TextureCache.h"
+#include "MipChain.h"
+#include "../Threading/ThreadPool.h"
+#include <deque>
+
+// When enabled, the textures are block compressed the first time that they are loaded,
+// and loaded from the texture cache every time after that
+#define COMPRESS_TEXTURES 1
+
+// The OpenGL texture of an image that is loaded by the "TextureLoader". The handle is
+// shared between the loader and the owner of the texture, so the owner is free to
+// destroy it before the image has finished loading.
+class TextureHandle
+{
+public:
+	TextureHandle(GLuint placeholderTextureName);
+	~TextureHandle();
+
+	// One should not be able to copy a "TextureHandle" instance
+	TextureHandle(const TextureHandle& other) = delete;
+	TextureHandle& operator=(const TextureHandle& other) = delete;
+
+	// Returns true once the image has been decoded and uploaded
+	bool IsReady() const;
+
+	// Binds the texture, or the placeholder texture if the texture is not ready yet
+	void Bind(GLuint unit) const;
+
+	// Returns the video memory that the texture, including its mip levels, uses.
+	// Stays 0 until the image has been uploaded.
+	size_t GetResidentBytes() const;
+private:
+	friend class TextureLoader;
+
+	// Stays 0 until the image has been uploaded
+	GLuint mTextureName = 0;
+	GLuint mPlaceholderTextureName = 0;
+	size_t mResidentBytes = 0;
+};
+
+// Singleton. Loads PNG images into OpenGL textures, without stalling the main thread. The
+// images are read and decoded (or read from the texture cache) on worker threads, while the
+// main thread uploads the images, through a persistently mapped pixel buffer object,
+// whenever "Update" gets called.
+class TextureLoader
+{
+public:
+	// Needs to be constructed after the OpenGL context has been created
+	TextureLoader();
+	~TextureLoader();
+
+	// One should not be able to copy nor move a "TextureLoader" instance
+	TextureLoader(const TextureLoader& other) = delete;
+	TextureLoader& operator=(const TextureLoader& other) = delete;
+
+	static TextureLoader& Get();
+
+	// Queues the PNG image at "filePath" to be loaded on a worker thread, along with a mip
+	// chain of "nMipmapLevels" levels, or a full chain when it is "mipchain::FULL_CHAIN". The
+	// returned handle binds a 1x1 placeholder texture until the image has been uploaded.
+	std::shared_ptr<const TextureHandle> Load(const std::string& filePath, TextureKind kind,
+		GLsizei nMipmapLevels);
+
+	// Uploads the images that have finished loading. Needs to be called by the thread that
+	// owns the OpenGL context, preferably once per frame. An image that failed to load gets
+	// logged and keeps binding the placeholder texture.
+	void Update();
+
+	// Blocks until all the queued images have been decoded and uploaded
+	void Finish();
+private:
+	struct DecodedImage
+	{
+		std::vector<unsigned char> pixels;
+		unsigned int width = 0;
+		unsigned int height = 0;
+	};
+
+	struct LoadedImage
+	{
+		// The compressed mip chain, when the image was read from, or written to, the texture cache
+		std::unique_ptr<MappedTextureContainer> container;
+		// Otherwise the uncompressed mip chain, which is built from the decoded image
+		std::vector<mipchain::MipLevel> mipChain;
+	};
+
+	struct PendingUpload
+	{
+		std::shared_ptr<TextureHandle> handle;
+		std::future<LoadedImage> loadedImage;
+	};
+
+	// A region of the staging buffer that the GPU might still be reading from
+	struct StagingRegion
+	{
+		size_t offset = 0;
+		size_t size = 0;
+		GLsync fence = nullptr;
+	};
+
+	// Run on the worker threads
+	static LoadedImage LoadImage(const std::string& filePath, TextureKind kind, GLsizei nMipmapLevels);
+	static DecodedImage Decode(const std::string& filePath, const std::vector<unsigned char>& png);
+
+	void Upload(TextureHandle& handle, const LoadedImage& image);
+	// Uploads one mip level, through the staging buffer if it fits
+	void UploadMipLevel(GLuint textureName, int mipLevel, TextureFormat format, int width, int height,
+		const void* data, size_t size);
+
+	// Returns the offset of "size" free bytes inside the staging buffer. Waits for
+	// the GPU to finish reading from the region, if an earlier upload still uses it.
+	size_t AllocateStagingMemory(size_t size);
+
+	void InitializePlaceholderTexture();
+	void InitializeStagingBuffer();
+private:
+	ThreadPool mThreadPool;
+	std::vector<PendingUpload> mPendingUploads;
+
+	GLuint mPlaceholderTexture = 0;
+
+	// A pixel buffer object that stays mapped for the lifetime of the loader. The
+	// uploads are written one after another, wrapping around at the end of the buffer.
+	GLuint mStagingBuffer = 0;
+	unsigned char* mStagingMemory = nullptr;
+	size_t mStagingHead = 0;
+	std::deque<StagingRegion> mStagingRegionsInUse;
+
+	static inline TextureLoader* msTextureLoader = nullptr;
+
+	// Images that are larger than the staging buffer are uploaded straight from client memory
+	static constexpr size_t STAGING_BUFFER_SIZE = 16 * 1024 * 1024;
+	static constexpr size_t STAGING_ALIGNMENT = 256;
+
+	// A flat normal, which leaves the normal maps without any effect, and a
+	// zero alpha, which leaves the colour textures invisible, until loaded
+	static constexpr unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 255, 0 };
+};
\ No newline at end of file
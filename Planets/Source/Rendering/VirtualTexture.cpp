@@ -0,0 +1,306 @@
+#include "VirtualTexture.h"
+#include "GlMacro.h"
+#include "GlStateCache.h"
+#include "../Benchmark/BenchmarkMacros.h"
+#include "../Console/ErrorLog.h"
+#include "../CustomException.h"
+#include <algorithm>
+#include <cstring>
+
+VirtualTexture::VirtualTexture(PageProducer pageProducer)
+	:
+	mPageProducer(std::move(pageProducer)),
+	mSlots(PHYSICAL_PAGES_PER_SIDE * PHYSICAL_PAGES_PER_SIDE)
+{
+	InitializeTextures();
+	InitializeFeedbackBuffers();
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	// Destructors should not throw exception, hence no GL macros
+	for (const FeedbackBuffer& feedbackBuffer : mFeedbackBuffers)
+	{
+		glDeleteSync(feedbackBuffer.fence);
+		glUnmapNamedBuffer(feedbackBuffer.buffer);
+		glDeleteBuffers(1, &feedbackBuffer.buffer);
+		GlStateCache::ForgetBuffer(feedbackBuffer.buffer);
+	}
+	glDeleteTextures(1, &mPageTable);
+	glDeleteTextures(1, &mPhysicalTexture);
+	GlStateCache::ForgetTexture(mPageTable);
+	GlStateCache::ForgetTexture(mPhysicalTexture);
+}
+
+void VirtualTexture::Update()
+{
+	BENCHMARK;
+
+	// Everything that the previous frame rendered has been issued by now
+	if (mFrame > 0)
+	{
+		FeedbackBuffer& previousFeedbackBuffer = mFeedbackBuffers[mFrame % mFeedbackBuffers.size()];
+
+		// The shader writes need to become visible to the mapping, once the fence has been signalled
+		GL(glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT));
+		previousFeedbackBuffer.fence = GL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+
+	++mFrame;
+
+	// The buffer that the current frame is about to write to, was written
+	// to a couple of frames ago, so the GPU should be done with it already
+	FeedbackBuffer& feedbackBuffer = mFeedbackBuffers[mFrame % mFeedbackBuffers.size()];
+	if (feedbackBuffer.fence)
+	{
+		ReadFeedback(feedbackBuffer);
+	}
+
+	UploadProducedPages();
+
+	if (mPageTableIsOutdated)
+	{
+		UpdatePageTable();
+		mPageTableIsOutdated = false;
+	}
+}
+
+void VirtualTexture::Bind(const GLuint pageTableUnit, const GLuint physicalTextureUnit,
+	const GLuint feedbackBufferBinding) const
+{
+	GlStateCache& stateCache = GlStateCache::Get();
+	stateCache.BindTextureUnit(pageTableUnit, mPageTable);
+	stateCache.BindTextureUnit(physicalTextureUnit, mPhysicalTexture);
+	stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, feedbackBufferBinding,
+		mFeedbackBuffers[mFrame % mFeedbackBuffers.size()].buffer);
+}
+
+int VirtualTexture::GetPagesPerSide(const int mipLevel)
+{
+	return (VIRTUAL_SIZE / PAGE_SIZE) >> mipLevel;
+}
+
+VirtualTexture::PageId VirtualTexture::GetPageId(const Page& page)
+{
+	// The pages of the finer mip levels come first
+	PageId pageId = 0;
+	for (int mipLevel = 0; mipLevel < page.mipLevel; ++mipLevel)
+	{
+		pageId += PageId(GetPagesPerSide(mipLevel) * GetPagesPerSide(mipLevel));
+	}
+
+	return pageId + PageId(page.y * GetPagesPerSide(page.mipLevel) + page.x);
+}
+
+VirtualTexture::Page VirtualTexture::GetPage(PageId pageId)
+{
+	int mipLevel = 0;
+	for (; pageId >= PageId(GetPagesPerSide(mipLevel) * GetPagesPerSide(mipLevel)); ++mipLevel)
+	{
+		pageId -= PageId(GetPagesPerSide(mipLevel) * GetPagesPerSide(mipLevel));
+	}
+
+	const int pagesPerSide = GetPagesPerSide(mipLevel);
+	return Page{ int(pageId % pagesPerSide), int(pageId / pagesPerSide), mipLevel };
+}
+
+void VirtualTexture::ReadFeedback(FeedbackBuffer& feedbackBuffer)
+{
+	GL(glClientWaitSync(feedbackBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+	GL(glDeleteSync(feedbackBuffer.fence));
+	feedbackBuffer.fence = nullptr;
+
+	std::vector<PageId> missingPages;
+	for (PageId pageId = 0; pageId < N_PAGES; ++pageId)
+	{
+		if (!feedbackBuffer.requests[pageId])
+		{
+			continue;
+		}
+
+		if (const auto residentPage = mResidentPages.find(pageId); residentPage != mResidentPages.end())
+		{
+			mSlots[residentPage->second].lastRequestedFrame = mFrame;
+		}
+		else
+		{
+			const bool isPending = std::any_of(mPendingPages.begin(), mPendingPages.end(),
+				[pageId](const PendingPage& pendingPage) { return pendingPage.pageId == pageId; });
+			if (!isPending)
+			{
+				missingPages.push_back(pageId);
+			}
+		}
+	}
+
+	// The buffer is coherent, so the cleared requests are
+	// visible to the GPU the next time that it writes to it
+	std::memset(feedbackBuffer.requests, 0, N_PAGES * sizeof(uint32_t));
+
+	// The coarser pages are produced first, since they cover the largest area, and since
+	// the finer pages fall back to them while they are still being produced. The pages of
+	// the coarser mip levels have the highest ids.
+	std::sort(missingPages.begin(), missingPages.end(), std::greater<PageId>());
+
+	for (const PageId pageId : missingPages)
+	{
+		if (mPendingPages.size() >= MAX_PENDING_PAGES)
+		{
+			// The remaining pages will be requested again by the coming frames
+			break;
+		}
+
+		const Page page = GetPage(pageId);
+		const VirtualTexturePageRegion region{ page.x * PAGE_SIZE - PAGE_BORDER, page.y * PAGE_SIZE - PAGE_BORDER,
+			PADDED_PAGE_SIZE, VIRTUAL_SIZE >> page.mipLevel };
+
+		mPendingPages.push_back(PendingPage{ pageId, mPageProducer(region) });
+	}
+}
+
+void VirtualTexture::UploadProducedPages()
+{
+	size_t nUploads = 0;
+	for (auto it = mPendingPages.begin(); it != mPendingPages.end() && nUploads < MAX_UPLOADS_PER_FRAME; )
+	{
+		if (it->pixels.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		const std::vector<unsigned char> pixels = it->pixels.get();
+		const int slotIndex = AllocateSlot();
+		if (slotIndex == -1)
+		{
+			// The page gets requested again, once there is room for it
+			it = mPendingPages.erase(it);
+			continue;
+		}
+
+		if (pixels.size() != (size_t)PADDED_PAGE_SIZE * PADDED_PAGE_SIZE * 4)
+		{
+			ERROR_LOG("The page producer of a virtual texture returned a page of the wrong size");
+			it = mPendingPages.erase(it);
+			continue;
+		}
+
+		Slot& slot = mSlots[slotIndex];
+		if (slot.isOccupied)
+		{
+			mResidentPages.erase(slot.pageId);
+		}
+		slot = Slot{ it->pageId, true, mFrame };
+		mResidentPages[it->pageId] = slotIndex;
+
+		const int slotX = slotIndex % PHYSICAL_PAGES_PER_SIDE;
+		const int slotY = slotIndex / PHYSICAL_PAGES_PER_SIDE;
+		GL(glTextureSubImage2D(mPhysicalTexture, 0, slotX * PADDED_PAGE_SIZE, slotY * PADDED_PAGE_SIZE,
+			PADDED_PAGE_SIZE, PADDED_PAGE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+
+		mPageTableIsOutdated = true;
+		++nUploads;
+		it = mPendingPages.erase(it);
+	}
+}
+
+int VirtualTexture::AllocateSlot()
+{
+	int leastRecentlyRequestedSlot = -1;
+	for (int i = 0; i < (int)mSlots.size(); ++i)
+	{
+		if (!mSlots[i].isOccupied)
+		{
+			return i;
+		}
+
+		// The pages that the current frame asked for are not evicted
+		if (mSlots[i].lastRequestedFrame < mFrame && (leastRecentlyRequestedSlot == -1
+			|| mSlots[i].lastRequestedFrame < mSlots[leastRecentlyRequestedSlot].lastRequestedFrame))
+		{
+			leastRecentlyRequestedSlot = i;
+		}
+	}
+
+	return leastRecentlyRequestedSlot;
+}
+
+void VirtualTexture::UpdatePageTable()
+{
+	// An entry holds the slot of the page, the mip level of the page, and whether
+	// there is a page at all. The entries are filled in from the coarsest mip
+	// level, so that a missing page can inherit the entry of its parent.
+	std::vector<std::array<unsigned char, 4>> parentEntries(1, { 0, 0, 0, 0 });
+	for (int mipLevel = N_MIP_LEVELS - 1; mipLevel >= 0; --mipLevel)
+	{
+		const int pagesPerSide = GetPagesPerSide(mipLevel);
+		const int parentPagesPerSide = std::max(1, pagesPerSide / 2);
+
+		std::vector<std::array<unsigned char, 4>> entries((size_t)pagesPerSide * pagesPerSide);
+		for (int y = 0; y < pagesPerSide; ++y)
+		{
+			for (int x = 0; x < pagesPerSide; ++x)
+			{
+				std::array<unsigned char, 4>& entry = entries[(size_t)y * pagesPerSide + x];
+
+				const auto residentPage = mResidentPages.find(GetPageId(Page{ x, y, mipLevel }));
+				if (residentPage != mResidentPages.end())
+				{
+					entry = { (unsigned char)(residentPage->second % PHYSICAL_PAGES_PER_SIDE),
+						(unsigned char)(residentPage->second / PHYSICAL_PAGES_PER_SIDE), (unsigned char)mipLevel, 1 };
+				}
+				else
+				{
+					// The single page of the coarsest mip level inherits an empty entry
+					entry = parentEntries[(size_t)(y / 2) * parentPagesPerSide + x / 2];
+				}
+			}
+		}
+
+		GL(glTextureSubImage2D(mPageTable, mipLevel, 0, 0, pagesPerSide, pagesPerSide,
+			GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entries.data()));
+
+		parentEntries = std::move(entries);
+	}
+}
+
+void VirtualTexture::InitializeTextures()
+{
+	static_assert(PHYSICAL_PAGES_PER_SIDE <= 256, "The slots need to fit inside the 8-bit page table entries");
+
+	// The page table is only ever read with "texelFetch", one mip level per mip level of the virtual texture
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mPageTable));
+	GL(glTextureStorage2D(mPageTable, N_MIP_LEVELS, GL_RGBA8UI, GetPagesPerSide(0), GetPagesPerSide(0)));
+	UpdatePageTable();
+
+	// The physical texture has no mip levels of its own, since every mip
+	// level of the virtual texture is made of pages of the same size
+	GL(glCreateTextures(GL_TEXTURE_2D, 1, &mPhysicalTexture));
+	GL(glTextureStorage2D(mPhysicalTexture, 1, GL_RGBA8, PHYSICAL_SIZE, PHYSICAL_SIZE));
+	GL(glTextureParameteri(mPhysicalTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GL(glTextureParameteri(mPhysicalTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GL(glTextureParameteri(mPhysicalTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GL(glTextureParameteri(mPhysicalTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+}
+
+void VirtualTexture::InitializeFeedbackBuffers()
+{
+	// The buffers are coherent, so what the GPU writes becomes visible
+	// to the CPU, and the other way around, without any explicit flushing
+	const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr size = N_PAGES * sizeof(uint32_t);
+
+	for (FeedbackBuffer& feedbackBuffer : mFeedbackBuffers)
+	{
+		GL(glCreateBuffers(1, &feedbackBuffer.buffer));
+		GL(glNamedBufferStorage(feedbackBuffer.buffer, size, nullptr, flags));
+		feedbackBuffer.requests = (uint32_t*)GL(glMapNamedBufferRange(feedbackBuffer.buffer, 0, size, flags));
+
+		if (!feedbackBuffer.requests)
+		{
+			throw CREATE_CUSTOM_EXCEPTION("Failed to map a virtual texture feedback buffer");
+		}
+
+		std::memset(feedbackBuffer.requests, 0, size);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+#include "GL/glew.h"
+#include <array>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+// A square region of one mip level of a virtual texture, which a page producer should
+// fill with 8-bit RGBA pixels. The region includes the border of the page, so it reaches
+// outside the mip level along the edges of the texture.
+struct VirtualTexturePageRegion
+{
+	int x = 0;
+	int y = 0;
+	int size = 0;
+	// The resolution of the mip level, along each axis
+	int mipLevelSize = 0;
+};
+
+// A very large texture, of which only the pages that were seen during the last frames are
+// kept in video memory. The shader looks up the page of every sample inside the page table,
+// which points out where in the physical page cache the page resides, and records which
+// pages it wanted inside the feedback buffer. The feedback gets read back a couple of frames
+// later, without stalling, and the missing pages are produced on worker threads, by the page
+// producer, and uploaded once they are done. Until then, the shader falls back to the
+// closest coarser page that is resident, or to a texture of its own if there is none.
+// Should only be used by the thread that owns the OpenGL context.
+class VirtualTexture
+{
+public:
+	// Thread-safe. Starts producing the pixels of the region, in row order, without any padding.
+	using PageProducer = std::function<std::future<std::vector<unsigned char>>(const VirtualTexturePageRegion&)>;
+
+	// Needs to be constructed after the OpenGL context has been created
+	VirtualTexture(PageProducer pageProducer);
+	~VirtualTexture();
+
+	// One should not be able to copy nor move a "VirtualTexture" instance
+	VirtualTexture(const VirtualTexture& other) = delete;
+	VirtualTexture& operator=(const VirtualTexture& other) = delete;
+
+	// Reads back the feedback of earlier frames, queues the missing pages for production and
+	// uploads the pages that have been produced. Needs to be called once per frame, before
+	// the frame gets rendered.
+	void Update();
+
+	// Binds the page table, the physical page cache, and the feedback buffer that the current
+	// frame should write its requests to
+	void Bind(GLuint pageTableUnit, GLuint physicalTextureUnit, GLuint feedbackBufferBinding) const;
+
+	// The dimensions, in texels, of the virtual texture and its pages. These
+	// need to match the constants inside the shaders that sample the texture.
+	static constexpr int VIRTUAL_SIZE = 16384;
+	static constexpr int PAGE_SIZE = 128;
+	// Every page is surrounded by a border of texels from its neighbours,
+	// so that bilinear filtering does not bleed into unrelated pages
+	static constexpr int PAGE_BORDER = 4;
+	static constexpr int PADDED_PAGE_SIZE = PAGE_SIZE + PAGE_BORDER * 2;
+
+	// The number of mip levels, from a page table of 128x128 pages, down to a single page
+	static constexpr int N_MIP_LEVELS = 8;
+	static_assert(VIRTUAL_SIZE == PAGE_SIZE << (N_MIP_LEVELS - 1));
+private:
+	// Identifies a page by its index inside the feedback buffer
+	using PageId = uint32_t;
+
+	struct Page
+	{
+		int x = 0;
+		int y = 0;
+		int mipLevel = 0;
+	};
+
+	// A place for one page inside the physical page cache
+	struct Slot
+	{
+		// The page that resides in the slot, if "isOccupied" is set
+		PageId pageId = 0;
+		bool isOccupied = false;
+		// The last frame that the page was requested
+		uint64_t lastRequestedFrame = 0;
+	};
+
+	struct PendingPage
+	{
+		PageId pageId = 0;
+		std::future<std::vector<unsigned char>> pixels;
+	};
+
+	// A feedback buffer that the GPU writes to during one frame
+	struct FeedbackBuffer
+	{
+		GLuint buffer = 0;
+		uint32_t* requests = nullptr;
+		// Signalled once the GPU is done with the frame that wrote to the buffer
+		GLsync fence = nullptr;
+	};
+
+	static int GetPagesPerSide(int mipLevel);
+	static PageId GetPageId(const Page& page);
+	static Page GetPage(PageId pageId);
+
+	// Reads the requests that the GPU wrote to "feedbackBuffer" and clears it
+	void ReadFeedback(FeedbackBuffer& feedbackBuffer);
+	// Uploads the pages that have been produced, and places them in the physical page cache
+	void UploadProducedPages();
+	// Returns the slot that the least recently requested page resides in, if no
+	// slot is free. Returns -1 if every page was requested during the current frame.
+	int AllocateSlot();
+	// Points every page table entry at the finest resident page that covers it
+	void UpdatePageTable();
+
+	void InitializeTextures();
+	void InitializeFeedbackBuffers();
+private:
+	PageProducer mPageProducer;
+
+	GLuint mPageTable = 0;
+	GLuint mPhysicalTexture = 0;
+
+	// The feedback is read back a couple of frames after it was written,
+	// so that the CPU never has to wait for the GPU
+	std::array<FeedbackBuffer, 3> mFeedbackBuffers;
+	uint64_t mFrame = 0;
+
+	std::vector<Slot> mSlots;
+	std::unordered_map<PageId, int> mResidentPages;
+	std::vector<PendingPage> mPendingPages;
+	bool mPageTableIsOutdated = false;
+
+	// The side length, in pages, of the physical page cache
+	static constexpr int PHYSICAL_PAGES_PER_SIDE = 16;
+	static constexpr int PHYSICAL_SIZE = PHYSICAL_PAGES_PER_SIDE * PADDED_PAGE_SIZE;
+
+	// Limits how much work a single frame can cause, so that a sudden change of
+	// view spreads its pages over several frames instead of causing a hitch
+	static constexpr size_t MAX_PENDING_PAGES = 16;
+	static constexpr size_t MAX_UPLOADS_PER_FRAME = 4;
+
+	// The total number of pages, over all the mip levels, which
+	// also is the number of entries inside a feedback buffer
+	static constexpr size_t N_PAGES = (((size_t)VIRTUAL_SIZE / PAGE_SIZE) * (VIRTUAL_SIZE / PAGE_SIZE) * 4 - 1) / 3;
+};
\ No newline at end of file
@@ -14,6 +14,16 @@ layout(location = 0) uniform int nCraters;
 layout(location = 1) uniform float maxCraterTextureRadius;
 layout(location = 2) uniform float craterFactors[21];
 
+// When set, every invocation bakes one texel of the detail normal map, instead
+// of updating three vertices. "BakeDetailNormalMap" of class "CelestialBody"
+// dispatches 6 * "normalMapSize" * "normalMapSize" / 12 work groups, which makes
+// it one invocation per texel.
+layout(location = 23) uniform bool bakeNormalMap;
+// The resolution of each face of the detail normal map
+layout(location = 24) uniform int normalMapSize;
+
+layout(binding = 0, rgba8_snorm) uniform writeonly imageCube detailNormalMap;
+
 const int MAX_CRATER_COUNT = 1024;
 const float PI = 3.1415926535;
 const float MODEL_RADIUS = 1.0;
@@ -486,7 +496,87 @@ vec3 GetCraterUv(const vec3 vertexPosition, const vec3 craterPosition, const flo
 	return vec3(uv, 1.0);
 }
 
-void main()
+// Returns the offset from the model's surface, caused by all the craters
+float GetTotalCraterOffset(const vec3 position)
+{
+	float totalCraterOffset = 0.0;
+	for (int j = 0; j < nCraters; ++j)
+	{
+		// The distance between two points on a sphere of radius 1 is equal
+		// to the angle between them, see "GenerateVertices"
+		const float distance = acos(clamp(dot(position, craterBuffer.craterDatas[j].position), -1.0, 1.0));
+		const float randomCraterValue = craterBuffer.craterDatas[j].randomValue;
+		const float craterRadius = GetRandomCraterRadius(randomCraterValue);
+		if (distance < craterRadius)
+		{
+			totalCraterOffset += GetCraterOffset(distance, craterRadius, randomCraterValue);
+		}
+	}
+
+	return totalCraterOffset;
+}
+
+// Returns the position on the terrain, with all the detail, in the direction "direction"
+vec3 GetTerrainPosition(const vec3 direction)
+{
+	const vec3 position = normalize(direction);
+	return position * (MODEL_RADIUS + GetTotalCraterOffset(position) + GetTotalPerlinOffset(position));
+}
+
+// Returns the direction that the texel coordinate "st", ranging
+// from -1 to 1, points in on the face "face" of a cube map. The
+// directions follow the cube map face layout of OpenGL.
+vec3 GetCubeMapDirection(const int face, const vec2 st)
+{
+	switch (face)
+	{
+	case 0:
+		return vec3(1.0, -st.y, -st.x);
+	case 1:
+		return vec3(-1.0, -st.y, st.x);
+	case 2:
+		return vec3(st.x, 1.0, st.y);
+	case 3:
+		return vec3(st.x, -1.0, -st.y);
+	case 4:
+		return vec3(st.x, -st.y, 1.0);
+	default:
+		return vec3(-st.x, -st.y, -1.0);
+	}
+}
+
+void BakeDetailNormal()
+{
+	const uint index = gl_GlobalInvocationID.x;
+	const int face = int(index / uint(normalMapSize * normalMapSize));
+	const int texelIndex = int(index % uint(normalMapSize * normalMapSize));
+	const ivec2 texel = ivec2(texelIndex % normalMapSize, texelIndex / normalMapSize);
+
+	// The centre of the texel, and the distance to the centres
+	// of its neighbours, in the range -1 to 1 of the face
+	const vec2 st = (vec2(texel) + 0.5) / float(normalMapSize) * 2.0 - 1.0;
+	const float texelSize = 2.0 / float(normalMapSize);
+
+	// The normal is calculated from the terrain positions in the directions
+	// of the neighbouring texels, so that it captures all the detail that
+	// fits inside the normal map, no matter how coarse the mesh is
+	const vec3 right = GetTerrainPosition(GetCubeMapDirection(face, st + vec2(texelSize, 0.0)))
+		- GetTerrainPosition(GetCubeMapDirection(face, st - vec2(texelSize, 0.0)));
+	const vec3 up = GetTerrainPosition(GetCubeMapDirection(face, st + vec2(0.0, texelSize)))
+		- GetTerrainPosition(GetCubeMapDirection(face, st - vec2(0.0, texelSize)));
+	vec3 normal = normalize(cross(right, up));
+
+	// The texel axes are mirrored on some of the faces,
+	// so make sure that the normal points outwards
+	if (dot(normal, GetCubeMapDirection(face, st)) < 0.0)
+	{
+		normal = -normal;
+	}
+
+	imageStore(detailNormalMap, ivec3(texel, face), vec4(normal, 0.0));
+}
+
+void GenerateVertices()
 {
 	// The index of the current work group
 	const uint index = gl_GlobalInvocationID.x;
@@ -574,4 +664,16 @@ void main()
 		// vertices have the same normal
 		vertices[index * 3 + i].normal = normal;
 	}
+}
+
+void main()
+{
+	if (bakeNormalMap)
+	{
+		BakeDetailNormal();
+	}
+	else
+	{
+		GenerateVertices();
+	}
 }
\ No newline at end of file
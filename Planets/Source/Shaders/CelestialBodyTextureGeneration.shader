@@ -0,0 +1,161 @@
+#Shader Compute
+
+#version 450 core
+
+// Each invocation is responsible for one texel of both the textures. Inside
+// the method "GenerateNoiseTexturesOnGpu" of class "CelestialBodyTextures", we
+// dispatch enough work groups to cover the whole texture.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// The width and height of the textures, in texels
+layout(location = 0) uniform ivec2 textureSize;
+// Converts a texel coordinate into the coordinate space of the reference size. This
+// makes the textures show the same pattern, regardless of their resolution.
+layout(location = 1) uniform vec2 scale;
+
+layout(binding = 0, rgba8) uniform writeonly image2D surfaceTexture;
+layout(binding = 1, r32f) uniform writeonly image2D normalInterpolationTexture;
+
+// vvv Perlin noise vvv
+// This is a two dimensional version of the perlin noise, which gives the same values
+// as the class "PerlinNoise<2>" on the CPU, i.e., the noise that the "NoiseTextureBaker"
+// uses when baking the textures
+const int N_RANDOM_VALUES = 256;
+layout(binding = 1, std140) uniform PermutationBuffer
+{
+	int permutationTable[N_RANDOM_VALUES * 2 - 1];
+}permutationBuffer;
+
+float Smoothstep(float t)
+{
+	return t * t * t * (10.0 + t * (6.0 * t - 15.0));
+}
+int AccessPermutationTable(int index)
+{
+	return permutationBuffer.permutationTable[index];
+}
+int GetRandomIndex(const ivec2 location)
+{
+	return AccessPermutationTable(AccessPermutationTable(location.x) + location.y);
+}
+float GetRandomPerlinValue(const int index, const vec2 toPosition)
+{
+	// "PerlinNoise<2>" uses twelve three dimensional diagonal vectors. Since the
+	// third element of "toPosition" is always 0 in two dimensions, only the first
+	// two elements of the diagonal vectors affect the dot product.
+	switch (index % 12)
+	{
+	case 0:
+	case 2:
+		return toPosition.y;
+	case 1:
+	case 3:
+		return -toPosition.y;
+	case 4:
+	case 6:
+		return toPosition.x;
+	case 5:
+	case 7:
+		return -toPosition.x;
+	case 8:
+		return toPosition.x + toPosition.y;
+	case 9:
+		return -toPosition.x + toPosition.y;
+	case 10:
+		return toPosition.x - toPosition.y;
+	case 11:
+		return -toPosition.x - toPosition.y;
+	default:
+		return -1.0;
+	}
+}
+float PerlinNoise(const vec2 position)
+{
+	int fx = int(floor(position.x));
+	int fy = int(floor(position.y));
+
+	int x0 = int(fx & (N_RANDOM_VALUES - 1));
+	int y0 = int(fy & (N_RANDOM_VALUES - 1));
+
+	int x1 = (x0 + 1) & (N_RANDOM_VALUES - 1);
+	int y1 = (y0 + 1) & (N_RANDOM_VALUES - 1);
+
+	float tx = position.x - fx;
+	float ty = position.y - fy;
+
+	float sx = Smoothstep(tx);
+	float sy = Smoothstep(ty);
+
+	float c00 = GetRandomPerlinValue(GetRandomIndex(ivec2(x0, y0)), vec2(tx, ty));
+	float c10 = GetRandomPerlinValue(GetRandomIndex(ivec2(x1, y0)), vec2(tx - 1, ty));
+	float c01 = GetRandomPerlinValue(GetRandomIndex(ivec2(x0, y1)), vec2(tx, ty - 1));
+	float c11 = GetRandomPerlinValue(GetRandomIndex(ivec2(x1, y1)), vec2(tx - 1, ty - 1));
+
+	float perlinValue = mix(mix(c00, c10, sx), mix(c01, c11, sx), sy);
+	return (perlinValue + 1.0) / 2.0;
+}
+float GetFractalPerlin(const vec2 position, const int nOctaves,
+	const float startFrequency, const float startAmplitude)
+{
+	float amplitude = startAmplitude;
+	float frequency = startFrequency;
+	float maxAmplitude = 0.0;
+	float perlinValue = 0.0;
+
+	// For each ocatave incrementation, we want to half the amplitude
+	// and double the frequency
+	for (int i = 0; i < nOctaves; i++, amplitude /= 2.0, frequency *= 2.0)
+	{
+		// "PerlinNoise" returns a value that ranges from 0 to 1. We make
+		// it range from -amplitude to amplitude before accumulating it.
+		perlinValue += (PerlinNoise(position * frequency) * 2.0 - 1.0) * amplitude;
+
+		// The max amplitude will increase by the amplitude
+		// of the local perlin value
+		maxAmplitude += amplitude;
+	}
+
+	// The perlin value ranges from -maxAmplitude to maxAmplitude. Adding
+	// the max amplitude to the value and then dividing that sum by 2 * the 
+	// max amplitude will make the perlin value range from 0 to 1.
+	return (perlinValue + maxAmplitude) / (2.0 * maxAmplitude);
+}
+float GetWarpedPerlin(const vec2 position, const int nOctaves,
+	const float frequency, const float amplitude, const float warpAmount)
+{
+	// Calculate the position offset using fractal noise
+	vec2 offset =
+		vec2(
+			GetFractalPerlin(position, nOctaves, frequency, amplitude),
+
+			// The noise for the y-offset, is offsetted with (5.2, 1.3), so that 
+			// we will not get the same random values for both coordinates
+			GetFractalPerlin(position + vec2(5.2, 1.3), nOctaves, frequency, amplitude)
+		);
+
+	// Return a warped noise, i.e., a fractal noise that is 
+	// offsetted with yet another fractal noise
+	return GetFractalPerlin(position + offset * warpAmount, nOctaves, frequency, amplitude);
+}
+// ^^^ Perlin noise ^^^
+
+void main()
+{
+	const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+
+	// The last work groups might stick out of the textures
+	if (texel.x >= textureSize.x || texel.y >= textureSize.y)
+	{
+		return;
+	}
+
+	const vec2 position = vec2(texel) * scale;
+
+	// The surface texture is grayscale. We truncate the value to whole
+	// steps of 1 / 255, just like the "NoiseTextureBaker" does when it
+	// converts the value into a byte.
+	const float grayscaleValue = floor(GetWarpedPerlin(position, 4, 0.01, 1.0, 1080.0) * 255.0) / 255.0;
+	imageStore(surfaceTexture, texel, vec4(vec3(grayscaleValue), 1.0));
+
+	imageStore(normalInterpolationTexture, texel, vec4(PerlinNoise(position * 0.1)));
+}
\ No newline at end of file
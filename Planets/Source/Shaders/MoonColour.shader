@@ -1,37 +1,66 @@
 #Shader Vertex
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(location = 0) in vec3 vertexPosition;
-layout(location = 2) in vec3 normal;
 
-layout(location = 0) uniform vec3 cameraPosition;
-layout(location = 1) uniform mat4 viewRotation;
-layout(location = 2) uniform mat4 projectionMatrix;
-layout(location = 3) uniform vec3 worldPosition;
-layout(location = 4) uniform float scale;
+// Needs to match the constants of "FrameConstantsBuffer"
+layout(binding = 3, std140) uniform FrameConstants
+{
+	mat4 viewRotation;
+	mat4 viewRotationInverse;
+	mat4 projection;
+	mat4 projectionInverse;
+	vec3 cameraPosition;
+	float near;
+	float far;
+};
+// The index, inside the draw data buffer, of the first draw of the multi-draw call
+layout(location = 3) uniform int firstDraw;
+
+// Needs to match "DrawData" of the "RenderQueue"
+struct DrawData
+{
+	vec3 position;
+	float scale;
+	int textureLayer;
+};
+layout(binding = 2, std430) readonly buffer DrawDataBuffer
+{
+	DrawData drawDatas[];
+};
 
 out VS_OUT
 {
-	vec3 normal;
 	vec3 toCamera;
+	flat int textureLayer;
+	vec3 vertexPosition;
 }vsOut;
 
 void main()
 {
-	const vec3 position = worldPosition + vertexPosition * scale;
-	vsOut.normal = normal;
+	const DrawData drawData = drawDatas[firstDraw + gl_DrawIDARB];
+	const vec3 position = drawData.position + vertexPosition * drawData.scale;
+	vsOut.textureLayer = drawData.textureLayer;
 	vsOut.toCamera = normalize(cameraPosition - position);
+	vsOut.vertexPosition = vertexPosition;
 
-	gl_Position = projectionMatrix * viewRotation * vec4(position - cameraPosition, 1.0);
+	gl_Position = projection * viewRotation * vec4(position - cameraPosition, 1.0);
 }
 
 #Shader Fragment
 #version 450 core
 
+// The normals of the terrain, with all of its detail, baked into a cube map around the
+// model's origin, so that the shading does not depend on how finely the mesh is tessellated.
+// Every celestial body has its own layer.
+layout(binding = 15) uniform samplerCubeArray detailNormalMaps;
+
 in VS_OUT
 {
-	vec3 normal;
 	vec3 toCamera;
+	flat int textureLayer;
+	vec3 vertexPosition;
 } fsIn;
 
 const vec3 TO_SUN = normalize(vec3(1.0, 5.0, 0.0));
@@ -40,7 +69,7 @@ out vec4 colour;
 
 void main()
 {
-	const vec3 normal = normalize(fsIn.normal);
+	const vec3 normal = normalize(texture(detailNormalMaps, vec4(fsIn.vertexPosition, fsIn.textureLayer)).xyz);
 	
 	// vvv Specular lighting vvv
 
@@ -1,43 +1,141 @@
 #Shader Vertex
 #version 450 core
+#extension GL_ARB_shader_draw_parameters : require
 
 layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 uv;
-layout(location = 2) in vec3 normal;
 
-layout(location = 0) uniform vec3 cameraPosition;
-layout(location = 1) uniform mat4 viewRotation;
-layout(location = 2) uniform mat4 projectionMatrix;
-layout(location = 3) uniform vec3 worldPosition;
-layout(location = 4) uniform float scale;
+// Needs to match the constants of "FrameConstantsBuffer"
+layout(binding = 3, std140) uniform FrameConstants
+{
+	mat4 viewRotation;
+	mat4 viewRotationInverse;
+	mat4 projection;
+	mat4 projectionInverse;
+	vec3 cameraPosition;
+	float near;
+	float far;
+};
+// The index, inside the draw data buffer, of the first draw of the multi-draw call
+layout(location = 3) uniform int firstDraw;
+
+// Needs to match "DrawData" of the "RenderQueue"
+struct DrawData
+{
+	vec3 position;
+	float scale;
+	int textureLayer;
+};
+layout(binding = 2, std430) readonly buffer DrawDataBuffer
+{
+	DrawData drawDatas[];
+};
 
 out VS_OUT
 {
 	vec3 uv;
-	vec3 vertexNormal;
 	vec3 toCamera;
+	flat int textureLayer;
 	vec3 vertexPosition;
 }vsOut;
 
 void main()
 {
-	const vec3 position = worldPosition + vertexPosition * scale;
+	const DrawData drawData = drawDatas[firstDraw + gl_DrawIDARB];
+	const vec3 position = drawData.position + vertexPosition * drawData.scale;
+	vsOut.textureLayer = drawData.textureLayer;
 	vsOut.uv = uv;
-	vsOut.vertexNormal = normal;
 	vsOut.toCamera = normalize(cameraPosition - position);
 	vsOut.vertexPosition = vertexPosition;
 
-	gl_Position = projectionMatrix * viewRotation * vec4(position - cameraPosition, 1.0);
+	gl_Position = projection * viewRotation * vec4(position - cameraPosition, 1.0);
 }
 
 #Shader Fragment
 #version 450 core
 
-layout(binding = 1) uniform sampler2D surfaceTexture;
-layout(binding = 2) uniform sampler2D craterTexture;
-layout(binding = 3) uniform sampler2D normalMap;
-layout(binding = 4) uniform sampler2D secondNormalMap;
-layout(binding = 5) uniform sampler2D normalInterpolationTexture;
+layout(binding = 8) uniform sampler2D surfaceTexture;
+layout(binding = 9) uniform sampler2D craterTexture;
+layout(binding = 10) uniform sampler2D normalMap;
+layout(binding = 11) uniform sampler2D secondNormalMap;
+layout(binding = 12) uniform sampler2D normalInterpolationTexture;
+// The normals of the terrain, with all of its detail, baked into a cube map around the
+// model's origin, so that the shading does not depend on how finely the mesh is tessellated.
+// Every celestial body has its own layer.
+layout(binding = 15) uniform samplerCubeArray detailNormalMaps;
+
+// vvv Virtual surface texture vvv
+
+// These need to match the constants of "VirtualTexture"
+const float VIRTUAL_SIZE = 16384.0;
+const int PAGE_SIZE = 128;
+const int PAGE_BORDER = 4;
+const int PADDED_PAGE_SIZE = PAGE_SIZE + PAGE_BORDER * 2;
+const int PAGES_PER_SIDE = 128;
+const int N_MIP_LEVELS = 8;
+const float PHYSICAL_SIZE = 16.0 * PADDED_PAGE_SIZE;
+
+// Every entry holds the slot, inside the physical texture, of the finest resident
+// page that covers the entry, the mip level of that page, and whether there is a page
+layout(binding = 13) uniform usampler2D virtualSurfacePageTable;
+layout(binding = 14) uniform sampler2D virtualSurfaceTexture;
+
+// One entry per page, over all the mip levels, where the finer mip levels come
+// first. The pages that were wanted during the frame are set to 1.
+layout(binding = 1, std430) buffer VirtualSurfaceFeedback
+{
+	uint requests[];
+}virtualSurfaceFeedback;
+
+void RequestPage(const ivec2 page, const int mipLevel)
+{
+	int pageId = 0;
+	for (int i = 0; i < mipLevel; i++)
+	{
+		pageId += (PAGES_PER_SIDE >> i) * (PAGES_PER_SIDE >> i);
+	}
+	pageId += page.y * (PAGES_PER_SIDE >> mipLevel) + page.x;
+
+	virtualSurfaceFeedback.requests[pageId] = 1u;
+}
+
+// Samples the virtual surface texture at "uv", and records the page that was wanted if
+// "recordRequest" is set. Falls back to the surface texture while there is no page.
+vec4 SampleVirtualSurface(const vec2 uv, const bool recordRequest)
+{
+	// The derivatives are taken before wrapping the coordinates, since
+	// the wrapping would cause huge derivatives along the seams
+	const vec2 uvDx = dFdx(uv);
+	const vec2 uvDy = dFdy(uv);
+	const vec2 texelDx = uvDx * VIRTUAL_SIZE;
+	const vec2 texelDy = uvDy * VIRTUAL_SIZE;
+	const float lod = 0.5 * log2(max(dot(texelDx, texelDx), dot(texelDy, texelDy)));
+	const int mipLevel = clamp(int(lod), 0, N_MIP_LEVELS - 1);
+
+	// The surface texture repeats
+	const vec2 wrappedUv = fract(uv);
+
+	const int pagesPerSide = PAGES_PER_SIDE >> mipLevel;
+	const ivec2 page = min(ivec2(wrappedUv * float(pagesPerSide)), ivec2(pagesPerSide - 1));
+	if (recordRequest)
+	{
+		RequestPage(page, mipLevel);
+	}
+
+	const uvec4 entry = texelFetch(virtualSurfacePageTable, page, mipLevel);
+	if (entry.a == 0u)
+	{
+		return textureGrad(surfaceTexture, wrappedUv, uvDx, uvDy);
+	}
+
+	// The page that the entry points at might be coarser than the wanted one
+	const vec2 uvInsidePage = fract(wrappedUv * float(PAGES_PER_SIDE >> entry.b));
+	const vec2 physicalTexel = vec2(entry.rg) * float(PADDED_PAGE_SIZE) + float(PAGE_BORDER)
+		+ uvInsidePage * float(PAGE_SIZE);
+
+	return textureLod(virtualSurfaceTexture, physicalTexel / PHYSICAL_SIZE, 0.0);
+}
+// ^^^ Virtual surface texture ^^^
 
 // vvv Perlin noise vvv
 const int N_RANDOM_VALUES = 256;
@@ -242,12 +340,21 @@ vec3 GetTriplanarWeights(const vec3 normal, const float sharpness)
 
 // Uses triplanar mapping (a technique, which results in seamless texturing, 
 // where you sample the texture three times, and blend between the different 
-// samples based on the normal) to sample from the surface texture
+// samples based on the normal) to sample from the virtual surface texture
 vec4 GetTriplanarMappedColour(const vec3 texturePosition, const vec3 weights)
 {
-	const vec4 textureFrontAndBack = texture(surfaceTexture, texturePosition.xy);
-	const vec4 textureSides = texture(surfaceTexture, texturePosition.yz);
-	const vec4 textureTopAndBottom = texture(surfaceTexture, texturePosition.zx);
+	// Only one pixel out of every 4x4 pixels records which pages it wanted, which is plenty
+	// for finding the visible pages, while keeping the writes to the feedback buffer down.
+	// The planes that barely contribute to the colour do not ask for any pages.
+	const bool recordRequests = all(equal(ivec2(gl_FragCoord.xy) & 3, ivec2(0)));
+	const float minWeight = 0.01;
+
+	const vec4 textureFrontAndBack =
+		SampleVirtualSurface(texturePosition.xy, recordRequests && weights.z > minWeight);
+	const vec4 textureSides =
+		SampleVirtualSurface(texturePosition.yz, recordRequests && weights.x > minWeight);
+	const vec4 textureTopAndBottom =
+		SampleVirtualSurface(texturePosition.zx, recordRequests && weights.y > minWeight);
 
 	vec4 colour = textureFrontAndBack * weights.z
 		+ textureSides * weights.x
@@ -335,8 +442,8 @@ float GetWarpedColourAmount(const vec3 vertexPosition,
 in VS_OUT
 {
 	vec3 uv;
-	vec3 vertexNormal;
 	vec3 toCamera;
+	flat int textureLayer;
 	vec3 vertexPosition;
 } fsIn;
 
@@ -346,7 +453,7 @@ out vec4 colour;
 
 void main()
 {
-	const vec3 vertexNormal = normalize(fsIn.vertexNormal);
+	const vec3 vertexNormal = normalize(texture(detailNormalMaps, vec4(fsIn.vertexPosition, fsIn.textureLayer)).xyz);
 	
 	// vvv Triplanar sampling vvv
 	const vec3 weights = GetTriplanarWeights(vertexNormal, 5.0);
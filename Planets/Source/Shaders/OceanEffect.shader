@@ -1,43 +1,35 @@
-#Shader Vertex
-#version 450 core
-
-out vec2 uv;
-
-void main()
-{
-	vec3[4] vertexPositions = { vec3(1.0, -1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(-1.0, -1.0, 0.0), vec3(-1.0, 1.0, 0.0) };
-	vec2[4] uvs = { vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(0.0, 1.0) };
-
-	uv = uvs[gl_VertexID];
-	gl_Position = vec4(vertexPositions[gl_VertexID], 1.0);
-}
-
+// A per-pixel effect, which gets fused with the per-pixel effects next to it, by the
+// "PostProcessor". It therefore only consists of the function "OceanEffect", which
+// the fragment shader of the fused effects calls for every pixel.
 #Shader Fragment
 #version 450 core
 
-layout(binding = 0) uniform sampler2D renderedSceneTexture;
 layout(binding = 1) uniform sampler2D depthTexture;
 layout(binding = 2) uniform sampler2D waterNormalMap;
 
-layout(location = 0) uniform float near;
-layout(location = 1) uniform float far;
-layout(location = 2) uniform float left;
-layout(location = 3) uniform float right;
-layout(location = 4) uniform float top;
-layout(location = 5) uniform float bottom;
+// Needs to match the constants of "FrameConstantsBuffer"
+layout(binding = 3, std140) uniform FrameConstants
+{
+	mat4 viewRotation;
+	mat4 viewRotationInverse;
+	mat4 projection;
+	mat4 projectionInverse;
+	vec3 cameraPosition;
+	float near;
+	float far;
+};
 
 layout(location = 6) uniform float planetRadius;
-// The position of the planet rotated by the 
-// view rotation, since most calculations done in
-// the shader occur inside that space
-layout(location = 7) uniform vec3 planetPosition;
-
-layout(location = 8) uniform mat4 viewRotation;
-layout(location = 9) uniform mat4 viewRotationInverse;
+layout(location = 7) uniform vec3 planetWorldPosition;
 
 layout(location = 10) uniform mat3 normalMapRotation0;
 layout(location = 11) uniform mat3 normalMapRotation1;
 
+// The position of the planet, as seen from the camera, rotated by
+// the view rotation, since most calculations done in the shader
+// occur inside that space
+const vec3 planetPosition = (viewRotation * vec4(planetWorldPosition - cameraPosition, 1.0)).xyz;
+
 // The "TO_SUN"-vector rotated by the 
 // view rotation, since most calculations done in
 // the shader occur inside that space
@@ -119,15 +111,9 @@ SphereIntersections SortSphereIntersections(SphereIntersections sphereIntersecti
 
 vec3 ConvertPixelPositionToWorldPosition(const vec3 pixelScreenPosition)
 {
-	vec3 worldPosition = vec3(0.0);
-	worldPosition.z =
-		(-2.0 * far * near) / ((pixelScreenPosition.z + (near + far) / (near - far)) * (near - far));
-	worldPosition.x =
-		(pixelScreenPosition.x - (left + right) / (left - right)) * (left - right) * worldPosition.z / (2.0 * near);
-	worldPosition.y =
-		(pixelScreenPosition.y - (bottom + top) / (bottom - top)) * (bottom - top) * worldPosition.z / (2.0 * near);
-
-	return worldPosition;
+	// Revert the projection, which leaves the position in the view rotated space
+	const vec4 worldPosition = projectionInverse * vec4(pixelScreenPosition, 1.0);
+	return worldPosition.xyz / worldPosition.w;
 }
 
 
@@ -235,9 +221,8 @@ vec3 GetWaterColour(const float depth, const vec3 normal, const float specularFa
 	return waterColour;
 }
 
-in vec2 uv;
-out vec4 colour;
-void main()
+// Returns the colour of the pixel at "uv", whose colour is "sceneColour" before the effect
+vec4 OceanEffect(const vec4 sceneColour, const vec2 uv)
 {
 	// The pixel's position on the screen
 	const vec3 pixelScreenPosition = vec3(uv * 2.0 - 1.0, texture(depthTexture, uv).r * 2.0 - 1.0);
@@ -325,19 +310,18 @@ void main()
 			specularFactor = 0.8;
 		}
 		vec3 waterColour = GetWaterColour(depth, normal, specularFactor);
-		vec3 sceneColour = texture(renderedSceneTexture, uv).rgb;
 
 		// The depth at which the ocean becomes fully opaque
 		const float fullyOpaqueDepth = planetRadius / 6.0;
 		float opaqueness = depth / fullyOpaqueDepth;
 		opaqueness = clamp(opaqueness, 0.7, 1.0);
 
-		colour = vec4(mix(sceneColour, waterColour, opaqueness), 1.0);
+		return vec4(mix(sceneColour.rgb, waterColour, opaqueness), 1.0);
 	}
 	else
 	{
 		// The point is not seen through any water so render
 		// the point without any effect
-		colour = vec4(texture(renderedSceneTexture, uv).rgb, 1.0);
+		return vec4(sceneColour.rgb, 1.0);
 	}
 }
\ No newline at end of file
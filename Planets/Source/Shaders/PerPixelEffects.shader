@@ -0,0 +1,16 @@
+#Shader Vertex
+#version 450 core
+
+// The vertex shader of the fused per-pixel effects, whose fragment shader is put together
+// by the "PostProcessor", out of the functions of the effects
+
+out vec2 uv;
+
+void main()
+{
+	vec3[4] vertexPositions = { vec3(1.0, -1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(-1.0, -1.0, 0.0), vec3(-1.0, 1.0, 0.0) };
+	vec2[4] uvs = { vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(0.0, 1.0) };
+
+	uv = uvs[gl_VertexID];
+	gl_Position = vec4(vertexPositions[gl_VertexID], 1.0);
+}
\ No newline at end of file
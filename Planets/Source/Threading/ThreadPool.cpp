@@ -0,0 +1,67 @@
+#include "ThreadPool.h"
+#include "../Benchmark/BenchmarkMacros.h"
+
+ThreadPool::ThreadPool(unsigned int nThreads)
+{
+	if (nThreads == 0)
+	{
+		// "hardware_concurrency" is allowed to return 0, if
+		// the value is not computable
+		nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	mThreads.reserve(nThreads);
+	for (unsigned int i = 0; i < nThreads; ++i)
+	{
+		mThreads.emplace_back(&ThreadPool::Loop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lockGuard(mMutex);
+		mShouldStop = true;
+	}
+	mConditionVariable.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return (unsigned int)mThreads.size();
+}
+
+void ThreadPool::Loop(const unsigned int threadIndex)
+{
+	NAME_THREAD("Worker " + std::to_string(threadIndex));
+
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock uniqueLock(mMutex);
+			mConditionVariable.wait(uniqueLock,
+				[this]()
+				{
+					return mShouldStop || !mTasks.empty();
+				});
+
+			// We only stop once all the submitted tasks have been run,
+			// since someone might still be waiting for their futures
+			if (mTasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(mTasks.front());
+			mTasks.pop();
+		}
+
+		task();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <queue>
+#include <functional>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// Creates "nThreads" worker threads. When "nThreads" is 0, one
+	// worker thread is created per hardware thread.
+	ThreadPool(unsigned int nThreads = 0);
+	// Finishes all the submitted tasks before joining the worker threads
+	~ThreadPool();
+	// One should not be able to copy nor move a "ThreadPool" instance
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	// Thread-safe. Queues "function" for execution on one of the worker
+	// threads. The returned future becomes ready once the function has run.
+	template<class F>
+	std::future<std::invoke_result_t<F>> Submit(F&& function)
+	{
+		using ResultType = std::invoke_result_t<F>;
+
+		// "std::function" requires its target to be copyable, hence
+		// we store the (move only) packaged task as a "std::shared_ptr"
+		auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(function));
+		std::future<ResultType> future = task->get_future();
+		{
+			std::lock_guard lockGuard(mMutex);
+			mTasks.push([task]() { (*task)(); });
+		}
+		mConditionVariable.notify_one();
+
+		return future;
+	}
+
+	unsigned int GetThreadCount() const;
+private:
+	// Runs on every worker thread, until the pool gets destroyed
+	void Loop(unsigned int threadIndex);
+private:
+	std::vector<std::thread> mThreads;
+	std::queue<std::function<void()>> mTasks;
+	std::mutex mMutex;
+	std::condition_variable mConditionVariable;
+	bool mShouldStop = false;
+};
\ No newline at end of file
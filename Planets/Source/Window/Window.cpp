@@ -1,7 +1,9 @@
 #include "Window.h"
 #include "../CustomException.h"
+#include "../Rendering/GlMacro.h"
 
-Window::Window(const std::string& title, int width, int height)
+Window::Window(const std::string& title, int width, int height, const bool isHidden,
+    const int contextCreationApi)
 	:
 	mWidth(width),
 	mHeight(height)
@@ -10,7 +12,7 @@ Window::Window(const std::string& title, int width, int height)
 	assert(!msWindow);
 	msWindow = this;
 
-    InitializeGLFW(title);
+    InitializeGLFW(title, isHidden, contextCreationApi);
     InitializeGLEW();
 
     glfwSetWindowCloseCallback(mGlfwWindow, CloseCallback);
@@ -44,7 +46,7 @@ void Window::CursorCallback(GLFWwindow* window, const double xPosition, const do
     msWindow->mCursorCallback(xPosition, yPosition);
 }
 
-void Window::InitializeGLFW(const std::string& title)
+void Window::InitializeGLFW(const std::string& title, const bool isHidden, const int contextCreationApi)
 {
     // Initialize GLFW
     if (!glfwInit())
@@ -55,6 +57,20 @@ void Window::InitializeGLFW(const std::string& title)
     // The user should not be able to resize the window
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
+    if (isHidden)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
+    // Contexts that are not native, such as the ones of OSMesa, might otherwise
+    // default to an older version than the one that the shaders need
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextCreationApi);
+    if (contextCreationApi != GLFW_NATIVE_CONTEXT_API)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    }
+
     // Create the window 
     mGlfwWindow = glfwCreateWindow(mWidth, mHeight, title.c_str(), NULL, NULL);
     if (!mGlfwWindow)
@@ -75,6 +91,14 @@ void Window::InitializeGLEW() const
         std::string errorString = reinterpret_cast<const char*>(glewGetErrorString(status));
         throw CREATE_CUSTOM_EXCEPTION("Failed to initialize GLEW\n" + errorString);
     }
+
+    // Lets the driver compile the shaders on as many threads as it wants, which
+    // is what makes the programs, that only get submitted when they are created,
+    // compile in parallel. Most drivers compile on a single thread otherwise.
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        GL(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+    }
 }
 
 GLFWwindow* Window::GetGlfwWindow()
@@ -8,7 +8,10 @@ class WindowAccessSpecifier;
 class Window
 {
 public:
-	Window(const std::string& title, int width, int height);
+	// A hidden window is never shown, and only exists for the sake of its OpenGL context.
+	// "contextCreationApi" is one of the context creation APIs that GLFW supports.
+	Window(const std::string& title, int width, int height, bool isHidden = false,
+		int contextCreationApi = GLFW_NATIVE_CONTEXT_API);
 	// One should not be able to copy nor move a "Window" instance
 	Window(const Window& other) = delete;
 	Window& operator=(const Window& other) = delete;
@@ -29,7 +32,7 @@ private:
 	static void CloseCallback(GLFWwindow* window);
 	static void CursorCallback(GLFWwindow* window, double xPosition, double yPosition);
 
-	void InitializeGLFW(const std::string& title);
+	void InitializeGLFW(const std::string& title, bool isHidden, int contextCreationApi);
 	void InitializeGLEW() const;
 	GLFWwindow* GetGlfwWindow();
 private: